@@ -0,0 +1,68 @@
+// Distributed state vector
+// Source: ./examples/distributed_ket.cpp
+// Run with e.g.: mpirun -np 4 ./distributed_ket
+#include <iostream>
+#include <vector>
+#include "qpp.h"
+#include "MPI/distributed_ket.h"
+
+using namespace qpp;
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // the same random circuit, applied to a distributed and to a dense state
+    idx n = 8;
+    std::vector<idx> dims(n, 2);
+    DistributedKet dpsi(dims);
+    ket psi = mket(std::vector<idx>(n, 0));
+
+    // all processes must use the same gates
+    std::vector<cmat> Us;
+    if (rank == 0)
+        for (idx i = 0; i < 20; ++i)
+            Us.push_back(randU(4));
+    for (idx i = 0; i < 20; ++i)
+    {
+        if (rank != 0)
+            Us.push_back(cmat(4, 4));
+        MPI_Bcast(Us[i].data(), 32, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    }
+
+    for (idx i = 0; i < 20; ++i)
+    {
+        idx a = i % n, b = (3 * i + 1) % n;
+        if (a == b)
+            b = (b + 1) % n;
+        dpsi.apply(Us[i], {a, b});
+        psi = apply(psi, Us[i], {a, b}, dims);
+        dpsi.applyCTRL(gt.X, {b}, {(a + 2) % n == b ? (a + 3) % n
+                                                    : (a + 2) % n});
+        psi = applyCTRL(psi, gt.X, {b}, {(a + 2) % n == b ? (a + 3) % n
+                                                          : (a + 2) % n},
+                        dims);
+    }
+
+    double err = norm(dpsi.to_ket() - psi);
+    if (rank == 0)
+    {
+        std::cout << ">> Distance to the dense simulation: " << err << '\n';
+        std::cout << ">> Final layout: " << disp(dpsi.get_layout(), ", ")
+                  << '\n';
+    }
+
+    // measure all qubits
+    auto result = dpsi.measure_seq({0, 1, 2, 3, 4, 5, 6, 7});
+    if (rank == 0)
+    {
+        std::cout << ">> Measurement results: "
+                  << disp(std::get<0>(result), " ") << '\n';
+        std::cout << ">> Outcome probability: " << std::get<1>(result)
+                  << '\n';
+    }
+
+    MPI_Finalize();
+}
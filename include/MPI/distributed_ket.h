@@ -0,0 +1,542 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file MPI/distributed_ket.h
+* \brief Multi-partite state vector distributed over MPI processes
+*/
+
+#ifndef MPI_DISTRIBUTED_KET_H_
+#define MPI_DISTRIBUTED_KET_H_
+
+// MPI state vector sharding
+// include after qpp.h, compile with mpicxx or link against the MPI library
+
+#include <mpi.h>
+
+namespace qpp
+{
+
+/**
+* \class qpp::DistributedKet
+* \brief Multi-partite state vector whose amplitudes are split over the
+* processes of an MPI communicator
+* \see qpp::GatePlan
+*
+* The number of processes \a P must be the product of the dimensions of the
+* leading subsystems of the \a physical layout, which are \a global: each
+* process holds the D/P amplitudes whose global digits are given by its
+* rank, in the standard lexicographical order. The remaining subsystems are
+* \a local.
+*
+* A gate acting on local subsystems only is applied by each process to its
+* own amplitudes, with no communication. Qubit controls on global
+* subsystems are resolved from the rank. Any other global subsystem touched
+* by a gate is first remapped to a local one of the same dimension, by a
+* pairwise exchange of amplitudes between the processes, i.e. a SWAP of the
+* two subsystems in the physical layout. The logical order of the
+* subsystems, used by all the member functions, never changes.
+*
+* \note All the processes of the communicator must call the member
+* functions collectively, with the same arguments
+*/
+class DistributedKet : public IDisplay
+{
+    MPI_Comm comm_;          ///< communicator
+    int rank_;               ///< rank of the current process
+    int size_;               ///< number of processes
+    std::vector<idx> dims_;  ///< logical dimensions
+    idx g_;                  ///< number of global subsystems
+    std::vector<idx> pos_;   ///< physical position of each subsystem
+    std::vector<idx> pdims_; ///< physical dimensions
+    ket local_;              ///< local amplitudes
+
+    /**
+    * \brief Stride of the physical position \a p, within the local
+    * amplitudes if \a p is local, or within the ranks if \a p is global
+    */
+    idx stride_(idx p) const
+    {
+        idx result = 1;
+        idx last = p < g_ ? g_ : pdims_.size();
+        for (idx k = p + 1; k < last; ++k)
+            result *= pdims_[k];
+
+        return result;
+    }
+
+    /**
+    * \brief Digit of the current rank at the global physical position \a p
+    */
+    idx rank_digit_(idx p) const
+    {
+        return (static_cast<idx>(rank_) / stride_(p)) % pdims_[p];
+    }
+
+    /**
+    * \brief Sends \a count amplitudes to the rank \a partner and receives
+    * as many from it, in pieces that fit in an int count
+    */
+    void exchange_(cplx* send, cplx* recv, idx count, int partner) const
+    {
+        const idx piece = static_cast<idx>(1) << 28;
+        for (idx i = 0; i < count; i += piece)
+        {
+            int n = static_cast<int>(2 * std::min(piece, count - i));
+            MPI_Sendrecv(reinterpret_cast<double*>(send + i), n, MPI_DOUBLE,
+                         partner, 0, reinterpret_cast<double*>(recv + i), n,
+                         MPI_DOUBLE, partner, 0, comm_, MPI_STATUS_IGNORE);
+        }
+    }
+
+    /**
+    * \brief Swaps the global physical position \a p with the local one
+    * \a q, of the same dimension, by pairwise exchanges of amplitudes
+    */
+    void swap_positions_(idx p, idx q)
+    {
+        idx d = pdims_[p];
+        idx a = rank_digit_(p);
+        idx sq = stride_(q);
+        idx L = static_cast<idx>(local_.size());
+        idx count = L / d;
+
+        // local indexes with the digit b at q, in increasing order
+        auto index = [&](idx i, idx b) -> idx
+        {
+            return (i / sq) * sq * d + b * sq + i % sq;
+        };
+
+        // the amplitudes with local digit b go to the rank with digit b at
+        // p, which sends back its amplitudes with local digit a
+        ket send(count), recv(count);
+        for (idx b = 0; b < d; ++b)
+        {
+            if (b == a)
+                continue;
+            for (idx i = 0; i < count; ++i)
+                send(i) = local_(index(i, b));
+            int partner = rank_ + static_cast<int>(stride_(p) * b) -
+                          static_cast<int>(stride_(p) * a);
+            exchange_(send.data(), recv.data(), count, partner);
+            for (idx i = 0; i < count; ++i)
+                local_(index(i, b)) = recv(i);
+        }
+
+        // update the layout
+        for (auto&& it : pos_)
+        {
+            if (it == p)
+                it = q;
+            else if (it == q)
+                it = p;
+        }
+    }
+
+    /**
+    * \brief Brings to local positions the subsystems \a sub, avoiding the
+    * positions of \a keep
+    */
+    void localize_(const std::vector<idx>& sub, const std::vector<idx>& keep)
+    {
+        std::vector<bool> busy(pdims_.size(), false);
+        for (idx i : keep)
+            busy[pos_[i]] = true;
+
+        for (idx i : sub)
+        {
+            if (pos_[i] >= g_)
+                continue;
+
+            // last free local position of the same dimension
+            idx q = pdims_.size();
+            for (idx k = pdims_.size(); k-- > g_;)
+                if (!busy[k] && pdims_[k] == pdims_[pos_[i]])
+                {
+                    q = k;
+                    break;
+                }
+            if (q == pdims_.size())
+                throw Exception("qpp::DistributedKet::applyCTRL()",
+                                "No local subsystem to swap with!");
+
+            busy[pos_[i]] = false;
+            swap_positions_(pos_[i], q);
+            busy[q] = true;
+        }
+    }
+
+public:
+    /**
+    * \brief Constructs the multi-partite state
+    * \f$|0\rangle^{\otimes N}\f$, distributed over the processes of
+    * \a comm
+    *
+    * \param dims Dimensions of the multi-partite system
+    * \param comm MPI communicator
+    */
+    explicit DistributedKet(const std::vector<idx>& dims,
+                            MPI_Comm comm = MPI_COMM_WORLD) :
+            comm_{comm}, rank_{0}, size_{1}, dims_{dims}, g_{0}, pos_{},
+            pdims_{dims}, local_{}
+    {
+        MPI_Comm_rank(comm_, &rank_);
+        MPI_Comm_size(comm_, &size_);
+
+        // EXCEPTION CHECKS
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::DistributedKet::DistributedKet()",
+                            Exception::Type::DIMS_INVALID);
+
+        // the number of processes is the product of the leading dimensions,
+        // and at least one subsystem is local
+        idx P = 1;
+        while (g_ < dims.size() && P < static_cast<idx>(size_))
+            P *= dims[g_++];
+        if (P != static_cast<idx>(size_) || g_ == dims.size())
+            throw Exception("qpp::DistributedKet::DistributedKet()",
+                            "The number of processes must be the product of "
+                            "the leading dimensions!");
+        // END EXCEPTION CHECKS
+
+        pos_.resize(dims.size());
+        std::iota(std::begin(pos_), std::end(pos_), 0);
+
+        idx L = 1;
+        for (idx k = g_; k < dims.size(); ++k)
+            L *= dims[k];
+        local_ = ket::Zero(L);
+        if (rank_ == 0)
+            local_(0) = 1;
+    }
+
+    /**
+    * \brief Default copy constructor, the copy shares the communicator
+    */
+    DistributedKet(const DistributedKet&) = default;
+
+    /**
+    * \brief Default copy assignment operator, the copy shares the
+    * communicator
+    *
+    * \return Reference to the current instance
+    */
+    DistributedKet& operator=(const DistributedKet&) = default;
+
+    /**
+    * \brief Applies the controlled-gate \a A to the part \a subsys
+    * \see qpp::applyCTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys.
+    * Also, all control subsystems in \a ctrl must have the same dimension.
+    *
+    * \param A Eigen expression
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    template<typename Derived>
+    DistributedKet& applyCTRL(const Eigen::MatrixBase<Derived>& A,
+                              const std::vector<idx>& ctrl,
+                              const std::vector<idx>& subsys)
+    {
+        const cmat& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rA))
+            throw Exception("qpp::DistributedKet::applyCTRL()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix for the gate
+        if (!internal::check_square_mat(rA))
+            throw Exception("qpp::DistributedKet::applyCTRL()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check that ctrl + gate subsystem is valid
+        std::vector<idx> ctrlgate = ctrl;
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+        if (subsys.size() == 0 ||
+            !internal::check_subsys_match_dims(ctrlgate, dims_))
+            throw Exception("qpp::DistributedKet::applyCTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that all control subsystems have the same dimension
+        for (idx i = 1; i < ctrl.size(); ++i)
+            if (dims_[ctrl[i]] != dims_[ctrl[0]])
+                throw Exception("qpp::DistributedKet::applyCTRL()",
+                                Exception::Type::DIMS_NOT_EQUAL);
+
+        // check that gate matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims_[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, rA))
+            throw Exception("qpp::DistributedKet::applyCTRL()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+        // END EXCEPTION CHECKS
+
+        // global qubit controls: the gate acts only if they are all 1
+        std::vector<idx> lctrl;
+        bool active = true;
+        for (idx i : ctrl)
+        {
+            if (pos_[i] < g_ && dims_[i] == 2)
+                active = active && rank_digit_(pos_[i]) == 1;
+            else
+                lctrl.push_back(i);
+        }
+
+        // the exchanges are collective, even if the gate is not active here
+        std::vector<idx> lctrlgate = lctrl;
+        lctrlgate.insert(std::end(lctrlgate), std::begin(subsys),
+                         std::end(subsys));
+        localize_(lctrlgate, lctrlgate);
+        if (!active)
+            return *this;
+
+        std::vector<idx> lpdims(std::begin(pdims_) + g_, std::end(pdims_));
+        std::vector<idx> pctrl, psubsys;
+        for (idx i : lctrl)
+            pctrl.push_back(pos_[i] - g_);
+        for (idx i : subsys)
+            psubsys.push_back(pos_[i] - g_);
+        GatePlan<>(rA, pctrl, psubsys, lpdims).execute(local_);
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the gate \a A to the part \a subsys
+    * \see qpp::apply()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys
+    *
+    * \param A Eigen expression
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    template<typename Derived>
+    DistributedKet& apply(const Eigen::MatrixBase<Derived>& A,
+                          const std::vector<idx>& subsys)
+    {
+        return applyCTRL(A, {}, subsys);
+    }
+
+    /**
+    * \brief Sequentially measures the part \a subsys in the computational
+    * basis
+    * \see qpp::measure_seq()
+    *
+    * \note The measurement is non-destructive, i.e. the measured subsystems
+    * are left in the basis states given by the results. The subsystems are
+    * measured one at a time: the result of each is sampled by the rank 0
+    * process, using qpp::RandomDevices, then broadcast, and the state is
+    * projected and normalized before measuring the next one.
+    *
+    * \param subsys Subsystem indexes that are measured
+    * \return Tuple of: 1. Vector of outcome results of the measurement, in
+    * the order of \a subsys, and 2. Outcome probability
+    */
+    std::tuple<std::vector<idx>, double>
+    measure_seq(const std::vector<idx>& subsys)
+    {
+        // EXCEPTION CHECKS
+
+        // check that subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception("qpp::DistributedKet::measure_seq()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        idx L = static_cast<idx>(local_.size());
+        std::vector<idx> result(subsys.size());
+        double prob = 1;
+
+        // one subsystem at a time, so that only dims[i] partial
+        // probabilities are reduced
+        for (idx k = 0; k < subsys.size(); ++k)
+        {
+            idx p = pos_[subsys[k]];
+            idx d = dims_[subsys[k]];
+
+            // digit of subsys[k] in a local amplitude
+            auto digit = [&](idx j) -> idx
+            {
+                return p < g_ ? rank_digit_(p)
+                              : (j / stride_(p)) % pdims_[p];
+            };
+
+            std::vector<double> probs(d, 0), total(d, 0);
+            for (idx j = 0; j < L; ++j)
+                probs[digit(j)] += std::norm(local_(j));
+            MPI_Allreduce(probs.data(), total.data(), static_cast<int>(d),
+                          MPI_DOUBLE, MPI_SUM, comm_);
+
+            unsigned long long m = 0;
+            if (rank_ == 0)
+            {
+                std::discrete_distribution<idx> dd(std::begin(total),
+                                                   std::end(total));
+                m = dd(RandomDevices::get_instance().rng_);
+            }
+            MPI_Bcast(&m, 1, MPI_UNSIGNED_LONG_LONG, 0, comm_);
+
+            // projects and normalizes before the next subsystem
+            double sum = std::accumulate(std::begin(total), std::end(total),
+                                         0.);
+            double scale = std::sqrt(sum / total[m]);
+            for (idx j = 0; j < L; ++j)
+                local_(j) = digit(j) == m ? local_(j) * scale : 0.;
+
+            result[k] = static_cast<idx>(m);
+            prob *= total[m] / sum;
+        }
+
+        return std::make_tuple(result, prob);
+    }
+
+    /**
+    * \brief Norm of the state
+    *
+    * \return Norm
+    */
+    double norm() const
+    {
+        double local = local_.squaredNorm(), result = 0;
+        MPI_Allreduce(&local, &result, 1, MPI_DOUBLE, MPI_SUM, comm_);
+
+        return std::sqrt(result);
+    }
+
+    /**
+    * \brief Gathers the whole state vector on every process
+    *
+    * \note Takes O(D) memory per process, use it only for small states
+    *
+    * \return State vector, in the logical order of the subsystems
+    */
+    ket to_ket() const
+    {
+        idx L = static_cast<idx>(local_.size());
+        idx D = L * static_cast<idx>(size_);
+        ket physical(D);
+        MPI_Allgather(const_cast<cplx*>(local_.data()), static_cast<int>(2 * L),
+                      MPI_DOUBLE, physical.data(), static_cast<int>(2 * L),
+                      MPI_DOUBLE, comm_);
+
+        // physical to logical order
+        idx N = dims_.size();
+        std::vector<idx> strides(N);
+        idx stride = 1;
+        for (idx k = N; k-- > 0;)
+        {
+            strides[k] = stride;
+            stride *= pdims_[k];
+        }
+        ket result(D);
+        std::vector<idx> midx(N);
+        for (idx i = 0; i < D; ++i)
+        {
+            internal::n2multiidx(i, N, dims_.data(), midx.data());
+            idx j = 0;
+            for (idx k = 0; k < N; ++k)
+                j += midx[k] * strides[pos_[k]];
+            result(i) = physical(j);
+        }
+
+        return result;
+    }
+
+    /**
+    * \brief Local amplitudes, in the physical order
+    *
+    * \return Local amplitudes
+    */
+    const ket& get_local() const noexcept
+    {
+        return local_;
+    }
+
+    /**
+    * \brief Physical position of each subsystem, the first
+    * qpp::DistributedKet::get_num_global() ones being global
+    *
+    * \return Physical positions
+    */
+    const std::vector<idx>& get_layout() const noexcept
+    {
+        return pos_;
+    }
+
+    /**
+    * \brief Number of global physical positions
+    *
+    * \return Number of global physical positions
+    */
+    idx get_num_global() const noexcept
+    {
+        return g_;
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+
+    /**
+    * \brief Rank of the current process
+    *
+    * \return Rank
+    */
+    int get_rank() const noexcept
+    {
+        return rank_;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream the rank and the layout
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        return os << "rank " << rank_ << "/" << size_ << ", layout: "
+                  << disp(pos_, ", ");
+    }
+}; /* class DistributedKet */
+
+} /* namespace qpp */
+
+#endif /* MPI_DISTRIBUTED_KET_H_ */
@@ -0,0 +1,414 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/gate_fusion.h
+* \brief Gate fusion
+*/
+
+#ifndef CLASSES_GATE_FUSION_H_
+#define CLASSES_GATE_FUSION_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::GateFusion
+* \brief Merges a sequence of gates into dense blocks acting on at most
+* a given number of subsystems
+* \see qpp::GatePlan
+*
+* Gates are added one at a time. Each new gate can be moved backwards past
+* the blocks acting on disjoint subsystems, up to the first overlapping one.
+* Among those blocks, it is merged into the one that acquires the fewest new
+* subsystems (the most recent one on ties), provided the merged block acts on
+* at most \a max_subsys subsystems. Otherwise a new block is started.
+* qpp::GateFusion::execute() then sweeps the state once per block instead of
+* once per gate.
+*
+* Controlled gates are expanded to dense gates on the control and target
+* subsystems when these fit in a block. Larger controlled gates are kept as
+* blocks of their own, which are never merged into.
+*
+* \tparam Scalar Scalar type of the gates and of the states they act on,
+* default is qpp::cplx
+*/
+template<typename Scalar = cplx>
+class GateFusion
+{
+public:
+    /**
+    * \brief Fused block of gates
+    */
+    struct Block
+    {
+        dyn_mat<Scalar> A;          ///< product of the fused gates
+        std::vector<idx> ctrl;      ///< control subsystems, empty if fused
+        std::vector<idx> subsys;    ///< subsystems the block acts on
+        idx numgates;               ///< number of fused gates
+        GatePlan<Scalar> plan;      ///< plan of the block on the whole system
+    };
+
+private:
+    std::vector<idx> dims_;     ///< dimensions of the multi-partite system
+    idx max_subsys_;            ///< maximum number of subsystems of a block
+    std::vector<Block> blocks_; ///< fused blocks, in order of application
+    idx numgates_;              ///< number of gates added
+
+    /**
+    * \brief Expands the gate \a A acting on the subsystems \a pos of a
+    * system of local dimensions \a dims, controlled on the subsystems
+    * \a ctrl_pos, to the whole system, multiplying it from the left to the
+    * square matrix \a M
+    */
+    static void expand_mul_(const dyn_mat<Scalar>& A,
+                            const std::vector<idx>& ctrl_pos,
+                            const std::vector<idx>& pos,
+                            const std::vector<idx>& dims, dyn_mat<Scalar>& M)
+    {
+        GatePlan<Scalar> plan(A, ctrl_pos, pos, dims);
+        for (idx j = 0; j < static_cast<idx>(M.cols()); ++j)
+        {
+            auto col = M.col(j);
+            plan.execute(col);
+        }
+    }
+
+public:
+    /**
+    * \brief Constructs an empty sequence of gates on a multi-partite system
+    *
+    * \param dims Dimensions of the multi-partite system
+    * \param max_subsys Maximum number of subsystems a fused block may act on
+    */
+    explicit GateFusion(const std::vector<idx>& dims, idx max_subsys = 3) :
+            dims_{dims}, max_subsys_{max_subsys}, blocks_{}, numgates_{0}
+    {
+        // EXCEPTION CHECKS
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::GateFusion::GateFusion()",
+                            Exception::Type::DIMS_INVALID);
+
+        // check the maximum size of the blocks
+        if (max_subsys == 0)
+            throw Exception("qpp::GateFusion::GateFusion()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+    }
+
+    /**
+    * \brief Adds the gate \a A acting on the part \a subsys of the
+    * multi-partite system, fusing it with the previous gates if possible
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys
+    *
+    * \param A Eigen expression
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    template<typename Derived>
+    GateFusion& add(const Eigen::MatrixBase<Derived>& A,
+                    const std::vector<idx>& subsys)
+    {
+        const dyn_mat<typename Derived::Scalar>& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check types
+        if (!std::is_same<Scalar, typename Derived::Scalar>::value)
+            throw Exception("qpp::GateFusion::add()",
+                            Exception::Type::TYPE_MISMATCH);
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rA))
+            throw Exception("qpp::GateFusion::add()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix for the gate
+        if (!internal::check_square_mat(rA))
+            throw Exception("qpp::GateFusion::add()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception("qpp::GateFusion::add()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that gate matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims_[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, rA))
+            throw Exception("qpp::GateFusion::add()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+        // END EXCEPTION CHECKS
+
+        ++numgates_;
+
+        // scan the blocks backwards, the gate commutes with the blocks
+        // acting on disjoint subsystems; pick the one that grows the least
+        idx best = blocks_.size();
+        std::vector<idx> best_merged;
+        for (idx b = blocks_.size(); b-- > 0;)
+        {
+            const Block& block = blocks_[b];
+
+            // controlled blocks are never merged into, the gate can only be
+            // moved past them
+            if (!block.ctrl.empty())
+            {
+                bool overlap = false;
+                for (idx i : subsys)
+                    if (std::find(std::begin(block.ctrl), std::end(block.ctrl),
+                                  i) != std::end(block.ctrl) ||
+                        std::find(std::begin(block.subsys),
+                                  std::end(block.subsys), i) !=
+                        std::end(block.subsys))
+                        overlap = true;
+                if (overlap)
+                    break;
+                continue;
+            }
+
+            // union of the subsystems, the block ones first
+            std::vector<idx> merged = block.subsys;
+            bool overlap = false;
+            for (idx i : subsys)
+            {
+                if (std::find(std::begin(block.subsys), std::end(block.subsys),
+                              i) != std::end(block.subsys))
+                    overlap = true;
+                else
+                    merged.push_back(i);
+            }
+
+            if (merged.size() <= max_subsys_ &&
+                (best == blocks_.size() ||
+                 merged.size() - block.subsys.size() <
+                 best_merged.size() - blocks_[best].subsys.size()))
+            {
+                best = b;
+                best_merged = std::move(merged);
+            }
+
+            // cannot move the gate past an overlapping block
+            if (overlap)
+                break;
+        }
+
+        if (best < blocks_.size())
+        {
+            Block& block = blocks_[best];
+
+            std::vector<idx> merged_dims(best_merged.size());
+            idx Dmerged = 1;
+            for (idx i = 0; i < best_merged.size(); ++i)
+            {
+                merged_dims[i] = dims_[best_merged[i]];
+                Dmerged *= merged_dims[i];
+            }
+
+            // positions of the block and of the gate within best_merged
+            std::vector<idx> pos_block(block.subsys.size());
+            std::iota(std::begin(pos_block), std::end(pos_block), 0);
+            std::vector<idx> pos_gate(subsys.size());
+            for (idx i = 0; i < subsys.size(); ++i)
+                pos_gate[i] = static_cast<idx>(std::distance(
+                        std::begin(best_merged),
+                        std::find(std::begin(best_merged),
+                                  std::end(best_merged), subsys[i])));
+
+            // A * block, both expanded to the merged subsystems
+            dyn_mat<Scalar> M = dyn_mat<Scalar>::Identity(Dmerged, Dmerged);
+            expand_mul_(block.A, {}, pos_block, merged_dims, M);
+            expand_mul_(rA, {}, pos_gate, merged_dims, M);
+
+            block.A = std::move(M);
+            block.subsys = std::move(best_merged);
+            ++block.numgates;
+            block.plan = GatePlan<Scalar>(block.A, {}, block.subsys, dims_);
+
+            return *this;
+        }
+
+        blocks_.push_back(Block{rA, {}, subsys, 1,
+                                GatePlan<Scalar>(rA, {}, subsys, dims_)});
+
+        return *this;
+    }
+
+    /**
+    * \brief Adds the controlled-gate \a A acting on the part \a subsys of
+    * the multi-partite system, fusing it with the previous gates if possible
+    * \see qpp::Gates::CTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys.
+    * Also, all control subsystems in \a ctrl must have the same dimension.
+    *
+    * \param A Eigen expression
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    template<typename Derived>
+    GateFusion& add(const Eigen::MatrixBase<Derived>& A,
+                    const std::vector<idx>& ctrl,
+                    const std::vector<idx>& subsys)
+    {
+        const dyn_mat<typename Derived::Scalar>& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check types
+        if (!std::is_same<Scalar, typename Derived::Scalar>::value)
+            throw Exception("qpp::GateFusion::add()",
+                            Exception::Type::TYPE_MISMATCH);
+        // END EXCEPTION CHECKS
+
+        if (ctrl.size() == 0)
+            return add(rA, subsys);
+
+        // the remaining checks are done by the plan
+        GatePlan<Scalar> plan(rA, ctrl, subsys, dims_);
+
+        std::vector<idx> ctrlgate = ctrl; // ctrl + gate subsystem vector
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+
+        // small enough, expand to a dense gate on ctrl + gate and fuse it
+        if (ctrlgate.size() <= max_subsys_)
+        {
+            std::vector<idx> ctrlgate_dims(ctrlgate.size());
+            idx Dctrlgate = 1;
+            for (idx i = 0; i < ctrlgate.size(); ++i)
+            {
+                ctrlgate_dims[i] = dims_[ctrlgate[i]];
+                Dctrlgate *= ctrlgate_dims[i];
+            }
+            std::vector<idx> pos_ctrl(ctrl.size());
+            std::iota(std::begin(pos_ctrl), std::end(pos_ctrl), 0);
+            std::vector<idx> pos_gate(subsys.size());
+            std::iota(std::begin(pos_gate), std::end(pos_gate), ctrl.size());
+
+            dyn_mat<Scalar> M =
+                    dyn_mat<Scalar>::Identity(Dctrlgate, Dctrlgate);
+            expand_mul_(rA, pos_ctrl, pos_gate, ctrlgate_dims, M);
+
+            return add(M, ctrlgate);
+        }
+
+        ++numgates_;
+        blocks_.push_back(Block{rA, ctrl, subsys, 1, std::move(plan)});
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies in place all the fused blocks to the multi-partite state
+    * vector or density matrix \a state, one sweep per block
+    *
+    * \param state Column vector or density matrix, overwritten with the result
+    */
+    template<typename Derived>
+    void execute(Eigen::MatrixBase<Derived>& state) const
+    {
+        Derived& rstate = state.derived();
+
+        // EXCEPTION CHECKS
+
+        // check types
+        if (!std::is_same<Scalar, typename Derived::Scalar>::value)
+            throw Exception("qpp::GateFusion::execute()",
+                            Exception::Type::TYPE_MISMATCH);
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rstate))
+            throw Exception("qpp::GateFusion::execute()",
+                            Exception::Type::ZERO_SIZE);
+        // END EXCEPTION CHECKS
+
+        //************ ket ************//
+        if (internal::check_cvector(rstate))
+        {
+            // check that dims match state vector
+            if (!internal::check_dims_match_cvect(dims_, rstate))
+                throw Exception("qpp::GateFusion::execute()",
+                                Exception::Type::DIMS_MISMATCH_CVECTOR);
+
+            for (auto&& block : blocks_)
+                block.plan.execute(rstate);
+        }
+            //************ density matrix ************//
+        else if (internal::check_square_mat(rstate))
+        {
+            // check that dims match state matrix
+            if (!internal::check_dims_match_mat(dims_, rstate))
+                throw Exception("qpp::GateFusion::execute()",
+                                Exception::Type::DIMS_MISMATCH_MATRIX);
+
+            for (auto&& block : blocks_)
+                rstate = applyCTRL(rstate, block.A, block.ctrl, block.subsys,
+                                   dims_);
+        }
+            //************ Exception: not ket nor density matrix ************//
+        else
+            throw Exception("qpp::GateFusion::execute()",
+                            Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
+    }
+
+    /**
+    * \brief Fused blocks, in order of application
+    *
+    * \return Fused blocks
+    */
+    const std::vector<Block>& get_blocks() const noexcept
+    {
+        return blocks_;
+    }
+
+    /**
+    * \brief Number of gates added so far
+    *
+    * \return Number of gates
+    */
+    idx get_num_gates() const noexcept
+    {
+        return numgates_;
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+}; /* class GateFusion */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_GATE_FUSION_H_ */
@@ -0,0 +1,439 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/gate_plan.h
+* \brief Precomputed (controlled) gate applications
+*/
+
+#ifndef CLASSES_GATE_PLAN_H_
+#define CLASSES_GATE_PLAN_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::GatePlan
+* \brief Precomputed application of a controlled-gate to a fixed part of a
+* multi-partite system
+* \see qpp::applyCTRL_inplace()
+*
+* Validates the gate, the control and target subsystems and the dimensions
+* once, then precomputes the index tables and the non-trivial powers of the
+* gate. Use it when the same gate is applied many times on the same
+* subsystems, as qpp::GatePlan::execute() skips all the setup.
+*
+* \tparam Scalar Scalar type of the gate and of the states it acts on,
+* default is qpp::cplx
+*/
+template<typename Scalar = cplx>
+class GatePlan
+{
+    /**
+    * \brief Kind of gate, selects the kernel
+    */
+    enum class Kind
+    {
+        DENSE,    ///< general gate, gather/multiply/scatter
+        DIAGONAL, ///< diagonal gate, phase multiplications only
+        MONOMIAL  ///< permutation times phases, amplitude moves only
+    };
+
+    /**
+    * \brief Action of one non-trivial power \f$A^i\f$ of the gate
+    */
+    struct Step
+    {
+        dyn_mat<Scalar> Ai;     ///< power of the gate
+        idx ctrl_offset;        ///< offset of the control values (i, ..., i)
+        std::vector<idx> o;     ///< diagonal/monomial offsets
+        std::vector<Scalar> p;  ///< diagonal/monomial phases
+        std::vector<idx> start; ///< monomial cycle boundaries
+        bool permutation;       ///< monomial without phases
+    };
+
+    std::vector<idx> ctrl_;        ///< control subsystem indexes
+    std::vector<idx> subsys_;      ///< target subsystem indexes
+    std::vector<idx> dims_;        ///< dimensions of the multi-partite system
+    idx D_;                        ///< total dimension
+    Kind kind_;                    ///< kind of gate
+    std::vector<idx> offsets_;     ///< gate multi-index offsets within a group
+    std::vector<idx> fixed_dims_;  ///< ctrl+gate dimensions, increasing stride
+    std::vector<idx> fixed_strides_; ///< ctrl+gate strides, increasing stride
+    idx numgroups_;                ///< number of groups of amplitudes
+    std::vector<Step> steps_;      ///< one step per non-trivial power of A
+
+public:
+    /**
+    * \brief Constructs the plan of the controlled-gate \a A acting on the
+    * part \a subsys of a multi-partite system
+    * \see qpp::Gates::CTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys.
+    * Also, all control subsystems in \a ctrl must have the same dimension.
+    *
+    * \param A Eigen expression
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \param dims Dimensions of the multi-partite system
+    */
+    template<typename Derived>
+    GatePlan(const Eigen::MatrixBase<Derived>& A,
+             const std::vector<idx>& ctrl,
+             const std::vector<idx>& subsys,
+             const std::vector<idx>& dims) :
+            ctrl_{ctrl}, subsys_{subsys}, dims_{dims}, D_{1},
+            kind_{Kind::DENSE}, offsets_{}, fixed_dims_{}, fixed_strides_{},
+            numgroups_{1}, steps_{}
+    {
+        const dyn_mat<typename Derived::Scalar>& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check types
+        if (!std::is_same<Scalar, typename Derived::Scalar>::value)
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::TYPE_MISMATCH);
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rA))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix for the gate
+        if (!internal::check_square_mat(rA))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::DIMS_INVALID);
+
+        // check ctrl is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(ctrl, dims))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that all control subsystems have the same dimension
+        idx d = ctrl.size() > 0 ? dims[ctrl[0]] : 1;
+        for (idx i = 1; i < ctrl.size(); ++i)
+            if (dims[ctrl[i]] != d)
+                throw Exception("qpp::GatePlan::GatePlan()",
+                                Exception::Type::DIMS_NOT_EQUAL);
+
+        // check subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that gate matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, rA))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+
+        std::vector<idx> ctrlgate = ctrl; // ctrl + gate subsystem vector
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+        std::sort(std::begin(ctrlgate), std::end(ctrlgate));
+
+        // check that ctrl + gate subsystem is valid
+        // with respect to local dimensions
+        if (!internal::check_subsys_match_dims(ctrlgate, dims))
+            throw Exception("qpp::GatePlan::GatePlan()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        idx N = dims.size();                // total number of subsystems
+        idx ctrlsize = ctrl.size();         // number of ctrl subsystem
+        idx ctrlgatesize = ctrlgate.size(); // number of ctrl+gate subsystems
+        idx subsyssize = subsys.size();     // number of target subsystems
+        idx DA = static_cast<idx>(rA.rows()); // dimension of gate subsystem
+
+        idx Cdims[maxn];   // local dimensions
+        idx CdimsA[maxn];  // local dimensions
+        idx Cstrides[maxn]; // strides
+
+        for (idx k = 0; k < N; ++k)
+            Cdims[k] = dims[k];
+        for (idx k = 0; k < subsyssize; ++k)
+            CdimsA[k] = dims[subsys[k]];
+        internal::dims2strides(Cdims, N, Cstrides);
+
+        D_ = 1;
+        for (idx k = 0; k < N; ++k)
+            D_ *= dims[k];
+
+        // ctrl+gate subsystems in increasing order of their strides
+        fixed_dims_.resize(ctrlgatesize);
+        fixed_strides_.resize(ctrlgatesize);
+        for (idx k = 0; k < ctrlgatesize; ++k)
+        {
+            fixed_dims_[k] = dims[ctrlgate[ctrlgatesize - k - 1]];
+            fixed_strides_[k] = Cstrides[ctrlgate[ctrlgatesize - k - 1]];
+        }
+
+        numgroups_ = D_; // dimension of the rest
+        for (idx k = 0; k < ctrlgatesize; ++k)
+            numgroups_ /= fixed_dims_[k];
+
+        // offsets of the gate multi-indexes with respect to the group base
+        offsets_.resize(DA);
+        for (idx m = 0; m < DA; ++m)
+        {
+            idx CmidxA[maxn];
+            internal::n2multiidx(m, subsyssize, CdimsA, CmidxA);
+            offsets_[m] = 0;
+            for (idx k = 0; k < subsyssize; ++k)
+                offsets_[m] += CmidxA[k] * Cstrides[subsys[k]];
+        }
+
+        // offset of the control multi-index (1, 1, ..., 1)
+        idx ctrl_offset = 0;
+        for (idx k = 0; k < ctrlsize; ++k)
+            ctrl_offset += Cstrides[ctrl[k]];
+
+        // diagonal gates only rescale the amplitudes, no gather needed;
+        // monomial gates (e.g. permutations) only move the amplitudes around;
+        // the powers of such gates are of the same kind
+        if (internal::check_diagonal(rA))
+            kind_ = Kind::DIAGONAL;
+        else if (internal::check_monomial(rA))
+            kind_ = Kind::MONOMIAL;
+        else
+            kind_ = Kind::DENSE;
+
+        // construct the table of A^i, keep only the control values i for
+        // which A^i is not the identity, the rest of the state is left
+        // untouched (no control means A is applied once, i.e. A^1 acts on
+        // the whole state); controls of dimension 1 only take the value 0,
+        // so A is never applied
+        dyn_mat<Scalar> Id = dyn_mat<Scalar>::Identity(DA, DA);
+        dyn_mat<Scalar> Apow = Id;
+        idx numpow = ctrl.empty() ? 2 : d;
+        for (idx i = 1; i < numpow; ++i)
+        {
+            Apow = Apow * rA; // A^i
+            if (Apow == Id)
+                continue;
+
+            Step step{Apow, i * ctrl_offset, {}, {}, {}, false};
+            if (kind_ == Kind::DIAGONAL)
+                internal::diagonal_table(step.Ai, offsets_.data(),
+                                         step.ctrl_offset, step.o, step.p);
+            else if (kind_ == Kind::MONOMIAL)
+                step.permutation = internal::monomial_table(
+                        step.Ai, offsets_.data(), step.ctrl_offset,
+                        step.o, step.p, step.start);
+            steps_.push_back(std::move(step));
+        }
+    }
+
+    /**
+    * \brief Constructs the plan of the controlled-gate \a A acting on the
+    * part \a subsys of a multi-partite system of \a N qudits
+    * \see qpp::Gates::CTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys
+    *
+    * \param A Eigen expression
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \param N Number of subsystems
+    * \param d Subsystem dimensions
+    */
+    template<typename Derived>
+    GatePlan(const Eigen::MatrixBase<Derived>& A,
+             const std::vector<idx>& ctrl,
+             const std::vector<idx>& subsys,
+             idx N, idx d = 2) :
+            GatePlan(A, ctrl, subsys, std::vector<idx>(N, d))
+    {
+    }
+
+    /**
+    * \brief Applies in place the planned controlled-gate to the
+    * multi-partite state vector \a state
+    * \see qpp::applyCTRL_inplace()
+    *
+    * \note Only the amplitudes on which the gate acts non-trivially are
+    * overwritten. No copy of \a state is made.
+    *
+    * \param state Column vector, overwritten with the result
+    */
+    template<typename Derived>
+    void execute(Eigen::MatrixBase<Derived>& state) const
+    {
+        Derived& rstate = state.derived();
+
+        // EXCEPTION CHECKS
+
+        // check types
+        if (!std::is_same<Scalar, typename Derived::Scalar>::value)
+            throw Exception("qpp::GatePlan::execute()",
+                            Exception::Type::TYPE_MISMATCH);
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rstate))
+            throw Exception("qpp::GatePlan::execute()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check column vector
+        if (!internal::check_cvector(rstate))
+            throw Exception("qpp::GatePlan::execute()",
+                            Exception::Type::MATRIX_NOT_CVECTOR);
+
+        // check that dims match state vector
+        if (static_cast<idx>(rstate.rows()) != D_)
+            throw Exception("qpp::GatePlan::execute()",
+                            Exception::Type::DIMS_MISMATCH_CVECTOR);
+        // END EXCEPTION CHECKS
+
+        if (D_ == 1)
+            return;
+
+        idx numfixed = fixed_dims_.size();
+        for (auto&& step : steps_)
+        {
+            switch (kind_)
+            {
+                case Kind::DIAGONAL:
+                    internal::apply_groups_diagonal(
+                            rstate, step.o.data(), step.p.data(),
+                            step.o.size(), numgroups_, numfixed,
+                            fixed_strides_.data(), fixed_dims_.data());
+                    break;
+                case Kind::MONOMIAL:
+                    internal::apply_groups_monomial(
+                            rstate, step.o.data(), step.p.data(),
+                            step.start.data(), step.start.size() - 1,
+                            step.permutation, numgroups_, numfixed,
+                            fixed_strides_.data(), fixed_dims_.data());
+                    break;
+                case Kind::DENSE:
+                    internal::apply_groups(
+                            rstate, step.Ai, offsets_.data(),
+                            step.ctrl_offset, numgroups_, numfixed,
+                            fixed_strides_.data(), fixed_dims_.data());
+                    break;
+            }
+        }
+    }
+
+    /**
+    * \brief Applies in place the planned controlled-gate to each column of
+    * \a states, i.e. to a batch of multi-partite state vectors
+    * \see qpp::applyCTRL_batch()
+    *
+    * \note For dense gates the batch is transposed once, so that each group
+    * of amplitudes becomes a small matrix product over the whole batch.
+    * Diagonal and monomial gates are applied column by column.
+    *
+    * \param states Matrix whose columns are state vectors, overwritten with
+    * the result
+    */
+    template<typename Derived>
+    void execute_batch(Eigen::MatrixBase<Derived>& states) const
+    {
+        Derived& rstates = states.derived();
+
+        // EXCEPTION CHECKS
+
+        // check types
+        if (!std::is_same<Scalar, typename Derived::Scalar>::value)
+            throw Exception("qpp::GatePlan::execute_batch()",
+                            Exception::Type::TYPE_MISMATCH);
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rstates))
+            throw Exception("qpp::GatePlan::execute_batch()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check that dims match the state vectors
+        if (static_cast<idx>(rstates.rows()) != D_)
+            throw Exception("qpp::GatePlan::execute_batch()",
+                            Exception::Type::DIMS_MISMATCH_MATRIX);
+        // END EXCEPTION CHECKS
+
+        if (D_ == 1 || steps_.size() == 0)
+            return;
+
+        if (kind_ != Kind::DENSE)
+        {
+            for (idx b = 0; b < static_cast<idx>(rstates.cols()); ++b)
+            {
+                auto col = rstates.col(b);
+                execute(col);
+            }
+            return;
+        }
+
+        // one state vector per row, groups of amplitudes become contiguous
+        // columns
+        dyn_mat<Scalar> X = rstates.transpose();
+        for (auto&& step : steps_)
+            internal::apply_groups_batch(X, step.Ai, offsets_.data(),
+                                         step.ctrl_offset, numgroups_,
+                                         fixed_dims_.size(),
+                                         fixed_strides_.data(),
+                                         fixed_dims_.data());
+        rstates = X.transpose();
+    }
+
+    /**
+    * \brief Control subsystem indexes
+    *
+    * \return Control subsystem indexes
+    */
+    const std::vector<idx>& get_ctrl() const noexcept
+    {
+        return ctrl_;
+    }
+
+    /**
+    * \brief Target subsystem indexes
+    *
+    * \return Subsystem indexes where the gate is applied
+    */
+    const std::vector<idx>& get_subsys() const noexcept
+    {
+        return subsys_;
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+}; /* class GatePlan */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_GATE_PLAN_H_ */
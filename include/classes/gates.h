@@ -161,12 +161,11 @@ public:
 
         cmat result(D, D);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-        for (idx j = 0; j < D; ++j) // column major order for speed
-            for (idx i = 0; i < D; ++i)
-                result(i, j) = 1 / std::sqrt(D) * std::pow(omega(D), i * j);
+        // column major order for speed
+        parallel_for(D, D, [&](idx j, idx i)
+        {
+            result(i, j) = 1 / std::sqrt(D) * std::pow(omega(D), i * j);
+        });
 
         return result;
     }
@@ -188,7 +187,13 @@ public:
             throw Exception("qpp::Gates::Xd()", Exception::Type::DIMS_INVALID);
         // END EXCEPTION CHECKS
 
-        return Fd(D).inverse() * Zd(D) * Fd(D);
+        // built directly as a permutation matrix, so that it is exact
+        // (equal to Fd^{-1} Zd Fd)
+        cmat result = cmat::Zero(D, D);
+        for (idx j = 0; j < D; ++j)
+            result((j + 1) % D, j) = 1;
+
+        return result;
     }
 
     /**
@@ -480,6 +485,221 @@ public:
         return result;
     }
 
+    /**
+    * \brief Generates the multi-partite multiple-controlled-\a A gate
+    * as a sparse matrix
+    * \see qpp::Gates::CTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys
+    *
+    * \param A Eigen expression
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \param N Total number of subsystems
+    * \param d Subsystem dimensions
+    * \return CTRL-A gate, as a sparse matrix over the same scalar field as
+    * \a A, with at most \f$ D_A \f$ non-zero entries per column
+    */
+    template<typename Derived>
+    dyn_sp_mat<typename Derived::Scalar> CTRL_sparse(
+            const Eigen::MatrixBase<Derived>& A,
+            const std::vector<idx>& ctrl,
+            const std::vector<idx>& subsys,
+            idx N, idx d = 2) const
+    {
+        const dyn_mat<typename Derived::Scalar>& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check matrix zero size
+        if (!internal::check_nonzero_size(rA))
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix
+        if (!internal::check_square_mat(rA))
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check lists zero size
+        if (ctrl.size() == 0)
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::ZERO_SIZE);
+        if (subsys.size() == 0)
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check out of range
+        if (N == 0)
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::OUT_OF_RANGE);
+
+        // check valid local dimension
+        if (d == 0)
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::DIMS_INVALID);
+
+        // ctrl + gate subsystem vector
+        std::vector<idx> ctrlgate = ctrl;
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+        std::sort(std::begin(ctrlgate), std::end(ctrlgate));
+
+        std::vector<idx> dims(N, d); // local dimensions vector
+
+        // check that ctrl + gate subsystem is valid
+        // with respect to local dimensions
+        if (!internal::check_subsys_match_dims(ctrlgate, dims))
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that subsys list match the dimension of the matrix
+        if (rA.rows() != std::llround(std::pow(d, subsys.size())))
+            throw Exception("qpp::Gates::CTRL_sparse()",
+                            Exception::Type::DIMS_MISMATCH_MATRIX);
+        // END EXCEPTION CHECKS
+
+        idx Ngate = subsys.size();
+        idx Nctrl = ctrl.size();
+        idx D = static_cast<idx>(std::llround(std::pow(d, N)));
+        idx DA = static_cast<idx>(rA.rows());
+
+        idx Cstrides[maxn];
+        internal::dims2strides(dims.data(), N, Cstrides);
+
+        // offsets of the gate multi-indexes
+        std::vector<idx> offsets(DA);
+        for (idx a = 0; a < DA; ++a)
+        {
+            idx CdimsA[maxn];
+            idx midxA[maxn];
+            for (idx k = 0; k < Ngate; ++k)
+                CdimsA[k] = d;
+            internal::n2multiidx(a, Ngate, CdimsA, midxA);
+            offsets[a] = 0;
+            for (idx k = 0; k < Ngate; ++k)
+                offsets[a] += midxA[k] * Cstrides[subsys[k]];
+        }
+
+        // A^k is applied when all controls are in the state k
+        std::vector<dyn_mat<typename Derived::Scalar>> Ak(d);
+        Ak[0] = dyn_mat<typename Derived::Scalar>::Identity(DA, DA);
+        for (idx k = 1; k < d; ++k)
+            Ak[k] = Ak[k - 1] * rA;
+
+        // one column at a time, only the non-zero entries
+        std::vector<Eigen::Triplet<typename Derived::Scalar>> triplets;
+        triplets.reserve(D);
+        for (idx j = 0; j < D; ++j)
+        {
+            idx k = (j / Cstrides[ctrl[0]]) % d;
+            bool equal = true;
+            for (idx c = 1; c < Nctrl; ++c)
+                if ((j / Cstrides[ctrl[c]]) % d != k)
+                {
+                    equal = false;
+                    break;
+                }
+            if (!equal)
+            {
+                triplets.emplace_back(j, j, 1);
+                continue;
+            }
+
+            // gate column and first index of the group
+            idx b = 0, base = j;
+            for (idx c = 0; c < Ngate; ++c)
+            {
+                idx digit = (j / Cstrides[subsys[c]]) % d;
+                b = b * d + digit;
+                base -= digit * Cstrides[subsys[c]];
+            }
+            for (idx a = 0; a < DA; ++a)
+                if (Ak[k](a, b) != static_cast<typename Derived::Scalar>(0))
+                    triplets.emplace_back(base + offsets[a], j, Ak[k](a, b));
+        }
+
+        dyn_sp_mat<typename Derived::Scalar> result(D, D);
+        result.setFromTriplets(std::begin(triplets), std::end(triplets));
+
+        return result;
+    }
+
+    /**
+    * \brief Expands out as a sparse matrix
+    * \see qpp::Gates::expandout()
+    *
+    *  Expands out \a A as a sparse matrix in a multi-partite system.
+    *
+    * \param A Eigen expression
+    * \param pos Position
+    * \param dims Dimensions of the multi-partite system
+    * \return Tensor product
+    * \f$ I\otimes\cdots\otimes I\otimes A \otimes I \otimes\cdots\otimes I\f$,
+    * with \a A on position \a pos, as a sparse matrix
+    * over the same scalar field as \a A
+    */
+    template<typename Derived>
+    dyn_sp_mat<typename Derived::Scalar> expandout_sparse(
+            const Eigen::MatrixBase<Derived>& A, idx pos,
+            const std::vector<idx>& dims) const
+    {
+        const dyn_mat<typename Derived::Scalar>& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check zero-size
+        if (!internal::check_nonzero_size(rA))
+            throw Exception("qpp::Gates::expandout_sparse()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check that dims is a valid dimension vector
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::Gates::expandout_sparse()",
+                            Exception::Type::DIMS_INVALID);
+
+        // check square matrix
+        if (!internal::check_square_mat(rA))
+            throw Exception("qpp::Gates::expandout_sparse()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check that position is valid
+        if (pos > dims.size() - 1)
+            throw Exception("qpp::Gates::expandout_sparse()",
+                            Exception::Type::OUT_OF_RANGE);
+
+        // check that dims[pos] match the dimension of A
+        if (static_cast<idx>(rA.rows()) != dims[pos])
+            throw Exception("qpp::Gates::expandout_sparse()",
+                            Exception::Type::DIMS_MISMATCH_MATRIX);
+        // END EXCEPTION CHECKS
+
+        idx D = std::accumulate(std::begin(dims), std::end(dims),
+                                static_cast<idx>(1), std::multiplies<idx>());
+        idx DA = dims[pos];
+
+        idx Cstrides[maxn];
+        internal::dims2strides(dims.data(), dims.size(), Cstrides);
+        idx stride = Cstrides[pos];
+
+        std::vector<Eigen::Triplet<typename Derived::Scalar>> triplets;
+        triplets.reserve(D);
+        for (idx j = 0; j < D; ++j)
+        {
+            idx b = (j / stride) % DA;
+            idx base = j - b * stride;
+            for (idx a = 0; a < DA; ++a)
+                if (rA(a, b) != static_cast<typename Derived::Scalar>(0))
+                    triplets.emplace_back(base + a * stride, j, rA(a, b));
+        }
+
+        dyn_sp_mat<typename Derived::Scalar> result(D, D);
+        result.setFromTriplets(std::begin(triplets), std::end(triplets));
+
+        return result;
+    }
+
 }; /* class Gates */
 
 } /* namespace qpp */
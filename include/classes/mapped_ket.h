@@ -0,0 +1,482 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/mapped_ket.h
+* \brief Multi-partite state vector stored in a memory-mapped file
+*/
+
+#ifndef CLASSES_MAPPED_KET_H_
+#define CLASSES_MAPPED_KET_H_
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace qpp
+{
+
+/**
+* \class qpp::MappedKet
+* \brief Multi-partite state vector stored in a memory-mapped file, for
+* states larger than the available memory
+* \see qpp::GatePlan
+*
+* The amplitudes live in a file mapped in memory, in the standard
+* lexicographical order. The state is processed by chunks of contiguous
+* amplitudes: the trailing subsystems whose total dimension fits in a chunk
+* are \a low, the leading ones are \a high.
+*
+* Gates are queued, not applied right away. A run of queued gates whose
+* high subsystems, controls included, are at most \a max_high distinct ones
+* is applied in a single pass over the file: the chunks that differ only in
+* those high subsystems are copied into a buffer, all the gates of the run
+* are applied to the buffer, then the buffer is written back. Each pass
+* reads and writes every chunk once, sequentially within each chunk, so
+* the throughput is bounded by the disk bandwidth, and the buffer holds
+* \f$d^{max\_high}\f$ chunks. A gate with more than \a max_high high
+* subsystems is rejected.
+*
+* \note The pending gates are applied by qpp::MappedKet::flush(), which is
+* called by the accessors and by the destructor
+*/
+class MappedKet : public IDisplay
+{
+    /**
+    * \brief Queued controlled-gate
+    */
+    struct Gate
+    {
+        cmat A;                  ///< gate
+        std::vector<idx> ctrl;   ///< control subsystem indexes
+        std::vector<idx> subsys; ///< target subsystem indexes
+    };
+
+    std::string path_;          ///< path of the file
+    std::vector<idx> dims_;     ///< dimensions of the multi-partite system
+    idx D_;                     ///< total dimension
+    idx m_;                     ///< first low subsystem
+    idx chunk_;                 ///< number of amplitudes per chunk
+    idx max_high_;              ///< maximum number of high subsystems a pass
+    int fd_;                    ///< file descriptor
+    cplx* data_;                ///< mapped amplitudes
+    std::vector<Gate> pending_; ///< queued gates
+    std::vector<idx> high_;     ///< high subsystems of the queued gates
+    idx passes_;                ///< number of passes performed
+
+public:
+    /**
+    * \brief Creates, or truncates, the file \a path and maps in it the
+    * multi-partite state \f$|0\rangle^{\otimes N}\f$
+    *
+    * \param path Path of the file
+    * \param dims Dimensions of the multi-partite system
+    * \param chunk Maximum number of amplitudes per chunk
+    * \param max_high Maximum number of high subsystems per pass
+    */
+    MappedKet(const std::string& path, const std::vector<idx>& dims,
+              idx chunk = static_cast<idx>(1) << 20, idx max_high = 2) :
+            path_{path}, dims_{dims}, D_{1}, m_{0}, chunk_{1},
+            max_high_{max_high}, fd_{-1}, data_{nullptr}, pending_{},
+            high_{}, passes_{0}
+    {
+        // EXCEPTION CHECKS
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::MappedKet::MappedKet()",
+                            Exception::Type::DIMS_INVALID);
+
+        // check the chunk size
+        if (chunk < dims.back())
+            throw Exception("qpp::MappedKet::MappedKet()",
+                            Exception::Type::OUT_OF_RANGE);
+
+        // check that the file size fits in qpp::idx
+        for (idx d : dims)
+        {
+            if (D_ > std::numeric_limits<idx>::max() / d / sizeof(cplx))
+                throw Exception("qpp::MappedKet::MappedKet()",
+                                Exception::Type::OUT_OF_RANGE);
+            D_ *= d;
+        }
+        // END EXCEPTION CHECKS
+
+        // trailing subsystems that fit in a chunk
+        m_ = dims.size();
+        while (m_ > 0 && chunk_ * dims[m_ - 1] <= chunk)
+            chunk_ *= dims[--m_];
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0)
+            throw std::runtime_error(
+                    "qpp::MappedKet::MappedKet(): Error opening file \""
+                    + path + "\"!");
+
+        // the new file is zero-filled
+        std::size_t size = D_ * sizeof(cplx);
+        void* addr = MAP_FAILED;
+        if (::ftruncate(fd_, static_cast<off_t>(size)) == 0)
+            addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fd_, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(fd_);
+            throw std::runtime_error(
+                    "qpp::MappedKet::MappedKet(): Error mapping file \""
+                    + path + "\"!");
+        }
+        ::madvise(addr, size, MADV_SEQUENTIAL);
+        data_ = static_cast<cplx*>(addr);
+        data_[0] = 1;
+    }
+
+    /**
+    * \brief Not copyable, owns the mapping
+    */
+    MappedKet(const MappedKet&) = delete;
+
+    /**
+    * \brief Not copyable, owns the mapping
+    */
+    MappedKet& operator=(const MappedKet&) = delete;
+
+    /**
+    * \brief Applies the pending gates, then unmaps and closes the file,
+    * which is kept
+    */
+    ~MappedKet() override
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+        ::munmap(data_, D_ * sizeof(cplx));
+        ::close(fd_);
+    }
+
+    /**
+    * \brief Queues the controlled-gate \a A acting on the part \a subsys
+    * \see qpp::applyCTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys.
+    * Also, all control subsystems in \a ctrl must have the same dimension,
+    * and at most \a max_high of the subsystems in \a ctrl and \a subsys
+    * can be high.
+    *
+    * \param A Gate
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    MappedKet& applyCTRL(const cmat& A, const std::vector<idx>& ctrl,
+                         const std::vector<idx>& subsys)
+    {
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(A))
+            throw Exception("qpp::MappedKet::applyCTRL()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix for the gate
+        if (!internal::check_square_mat(A))
+            throw Exception("qpp::MappedKet::applyCTRL()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check that ctrl + gate subsystem is valid
+        std::vector<idx> ctrlgate = ctrl;
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+        if (subsys.size() == 0 ||
+            !internal::check_subsys_match_dims(ctrlgate, dims_))
+            throw Exception("qpp::MappedKet::applyCTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that all control subsystems have the same dimension
+        for (idx i = 1; i < ctrl.size(); ++i)
+            if (dims_[ctrl[i]] != dims_[ctrl[0]])
+                throw Exception("qpp::MappedKet::applyCTRL()",
+                                Exception::Type::DIMS_NOT_EQUAL);
+
+        // check that gate matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims_[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, A))
+            throw Exception("qpp::MappedKet::applyCTRL()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+
+        // check that the gate fits in a pass
+        std::vector<idx> gate_high;
+        for (idx i : ctrlgate)
+            if (i < m_)
+                gate_high.push_back(i);
+        if (gate_high.size() > max_high_)
+            throw Exception("qpp::MappedKet::applyCTRL()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        // high subsystems of the run with this gate
+        std::vector<idx> high = high_;
+        for (idx i : gate_high)
+            if (std::find(std::begin(high), std::end(high), i) ==
+                std::end(high))
+                high.push_back(i);
+
+        // does not fit in the current pass
+        if (pending_.size() > 0 && high.size() > max_high_)
+        {
+            flush();
+            high = gate_high;
+        }
+
+        pending_.push_back(Gate{A, ctrl, subsys});
+        high_ = high;
+
+        return *this;
+    }
+
+    /**
+    * \brief Queues the gate \a A acting on the part \a subsys
+    * \see qpp::apply()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys, and at most \a max_high of the subsystems
+    * in \a subsys can be high
+    *
+    * \param A Gate
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    MappedKet& apply(const cmat& A, const std::vector<idx>& subsys)
+    {
+        return applyCTRL(A, {}, subsys);
+    }
+
+    /**
+    * \brief Applies the queued gates, in a single pass over the file
+    *
+    * \return Reference to the current instance
+    */
+    MappedKet& flush()
+    {
+        if (pending_.size() == 0)
+            return *this;
+
+        idx N = dims_.size();
+        std::vector<idx> high = high_;
+        std::sort(std::begin(high), std::end(high));
+        idx h = high.size();
+
+        // the buffer is the system made of the high subsystems of the run,
+        // followed by the low ones
+        std::vector<idx> bdims, pos(N, 0);
+        for (idx k = 0; k < h; ++k)
+        {
+            pos[high[k]] = k;
+            bdims.push_back(dims_[high[k]]);
+        }
+        for (idx k = m_; k < N; ++k)
+        {
+            pos[k] = bdims.size();
+            bdims.push_back(dims_[k]);
+        }
+
+        std::vector<GatePlan<>> plans;
+        for (auto&& gate : pending_)
+        {
+            std::vector<idx> ctrl, subsys;
+            for (idx i : gate.ctrl)
+                ctrl.push_back(pos[i]);
+            for (idx i : gate.subsys)
+                subsys.push_back(pos[i]);
+            plans.emplace_back(gate.A, ctrl, subsys, bdims);
+        }
+
+        // strides of the full system
+        std::vector<idx> strides(N);
+        idx stride = 1;
+        for (idx k = N; k-- > 0;)
+        {
+            strides[k] = stride;
+            stride *= dims_[k];
+        }
+
+        // remaining high subsystems, enumerated by the outer loop
+        std::vector<idx> rest;
+        for (idx k = 0; k < m_; ++k)
+            if (!std::binary_search(std::begin(high), std::end(high), k))
+                rest.push_back(k);
+
+        idx Dhigh = 1, Drest = 1;
+        for (idx k : high)
+            Dhigh *= dims_[k];
+        for (idx k : rest)
+            Drest *= dims_[k];
+
+        // offset of a multi-index over the subsystems sub, given as a
+        // single index in lexicographical order
+        auto offset = [&](idx i, const std::vector<idx>& sub) -> idx
+        {
+            idx result = 0;
+            for (idx k = sub.size(); k-- > 0;)
+            {
+                result += (i % dims_[sub[k]]) * strides[sub[k]];
+                i /= dims_[sub[k]];
+            }
+            return result;
+        };
+
+        ket buffer(Dhigh * chunk_);
+        for (idx o = 0; o < Drest; ++o)
+        {
+            idx base = offset(o, rest);
+
+            for (idx i = 0; i < Dhigh; ++i)
+                std::memcpy(buffer.data() + i * chunk_,
+                            data_ + base + offset(i, high),
+                            chunk_ * sizeof(cplx));
+
+            for (auto&& plan : plans)
+                plan.execute(buffer);
+
+            for (idx i = 0; i < Dhigh; ++i)
+                std::memcpy(data_ + base + offset(i, high),
+                            buffer.data() + i * chunk_,
+                            chunk_ * sizeof(cplx));
+        }
+
+        pending_.clear();
+        high_.clear();
+        ++passes_;
+
+        return *this;
+    }
+
+    /**
+    * \brief Amplitude of the basis state \a i, in the standard
+    * lexicographical order
+    *
+    * \param i Index of the basis state
+    * \return Amplitude
+    */
+    cplx operator()(idx i)
+    {
+        // EXCEPTION CHECKS
+
+        // check out of range
+        if (i >= D_)
+            throw Exception("qpp::MappedKet::operator()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        flush();
+
+        return data_[i];
+    }
+
+    /**
+    * \brief Mapped amplitudes, after applying the pending gates
+    *
+    * \note Reading the whole map pages in the whole file
+    *
+    * \return Eigen map of the amplitudes, as a column vector
+    */
+    Eigen::Map<ket> get_map()
+    {
+        flush();
+
+        return Eigen::Map<ket>(data_, D_);
+    }
+
+    /**
+    * \brief Dense copy of the state vector, after applying the pending gates
+    *
+    * \return State vector
+    */
+    ket to_ket()
+    {
+        return get_map();
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+
+    /**
+    * \brief Number of amplitudes per chunk
+    *
+    * \return Number of amplitudes per chunk
+    */
+    idx get_chunk() const noexcept
+    {
+        return chunk_;
+    }
+
+    /**
+    * \brief Number of passes over the file performed so far
+    *
+    * \return Number of passes
+    */
+    idx get_num_passes() const noexcept
+    {
+        return passes_;
+    }
+
+    /**
+    * \brief Path of the file
+    *
+    * \return Path of the file
+    */
+    const std::string& get_path() const noexcept
+    {
+        return path_;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream the file, the chunk size and the
+    * number of passes
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        return os << "file: " << path_ << ", chunk: " << chunk_
+                  << ", passes: " << passes_;
+    }
+}; /* class MappedKet */
+
+} /* namespace qpp */
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif /* CLASSES_MAPPED_KET_H_ */
@@ -0,0 +1,682 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/mps.h
+* \brief Matrix product state
+*/
+
+#ifndef CLASSES_MPS_H_
+#define CLASSES_MPS_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::MPS
+* \brief Multi-partite state vector in the matrix product state form
+* \see qpp::schmidtcoeffs(), qpp::svd()
+*
+* The amplitude of the basis state \f$|s_0 s_1\ldots s_{N-1}\rangle\f$ is
+* \f$A_0^{s_0} A_1^{s_1}\cdots A_{N-1}^{s_{N-1}}\f$, where \f$A_k^{s}\f$ is a
+* \f$\chi_k\times\chi_{k+1}\f$ matrix and \f$\chi_0=\chi_N=1\f$. Memory is
+* O(N d \f$\chi^2\f$) instead of O(\f$d^N\f$).
+*
+* The state is kept in mixed canonical form around an orthogonality center:
+* the sites on its left are left-orthonormal, those on its right are
+* right-orthonormal. A two-site gate contracts the two sites, applies the
+* gate and splits them back with an SVD, which is truncated to at most
+* \a max_chi singular values and to a discarded weight of at most
+* \a max_discarded, relative to the total weight; singular values below
+* qpp::chop times the largest one are always dropped. The kept singular
+* values are rescaled so that the norm is preserved. Gates on non-adjacent
+* sites are applied by a network of SWAP gates.
+*
+* \note The sites are indexed as in the rest of the library, i.e. site 0 is
+* the most significant one in qpp::MPS::to_ket()
+*/
+class MPS : public IDisplay
+{
+    std::vector<idx> dims_;                ///< local dimensions
+    idx max_chi_;                          ///< maximum bond dimension
+    double max_discarded_;                 ///< maximum discarded weight
+    std::vector<std::vector<cmat>> As_;    ///< site tensors, As_[k][s]
+    idx center_;                           ///< orthogonality center
+    double discarded_;                     ///< total discarded weight
+
+    /**
+    * \brief Left bond dimension of the site \a k
+    */
+    idx chil_(idx k) const
+    {
+        return static_cast<idx>(As_[k][0].rows());
+    }
+
+    /**
+    * \brief Right bond dimension of the site \a k
+    */
+    idx chir_(idx k) const
+    {
+        return static_cast<idx>(As_[k][0].cols());
+    }
+
+    /**
+    * \brief Moves the orthogonality center one site to the right, by a
+    * QR decomposition of the current center
+    */
+    void shift_right_()
+    {
+        idx k = center_, d = dims_[k];
+        idx chil = chil_(k), chir = chir_(k);
+
+        // rows (a, s), columns b
+        cmat M(chil * d, chir);
+        for (idx s = 0; s < d; ++s)
+            for (idx a = 0; a < chil; ++a)
+                M.row(a * d + s) = As_[k][s].row(a);
+
+        Eigen::HouseholderQR<cmat> qr(M);
+        idx r = std::min(chil * d, chir);
+        cmat Q = qr.householderQ() * cmat::Identity(chil * d, r);
+        cmat R = qr.matrixQR().topRows(r).triangularView<Eigen::Upper>();
+
+        for (idx s = 0; s < d; ++s)
+        {
+            As_[k][s].resize(chil, r);
+            for (idx a = 0; a < chil; ++a)
+                As_[k][s].row(a) = Q.row(a * d + s);
+        }
+        for (auto&& A : As_[k + 1])
+            A = R * A;
+        ++center_;
+    }
+
+    /**
+    * \brief Moves the orthogonality center one site to the left, by a
+    * QR decomposition of the adjoint of the current center
+    */
+    void shift_left_()
+    {
+        idx k = center_, d = dims_[k];
+        idx chil = chil_(k), chir = chir_(k);
+
+        // rows a, columns (s, b), adjoint
+        cmat Mdag(d * chir, chil);
+        for (idx s = 0; s < d; ++s)
+            Mdag.middleRows(s * chir, chir) = adjoint(As_[k][s]);
+
+        Eigen::HouseholderQR<cmat> qr(Mdag);
+        idx r = std::min(d * chir, chil);
+        cmat Q = qr.householderQ() * cmat::Identity(d * chir, r);
+        cmat R = qr.matrixQR().topRows(r).triangularView<Eigen::Upper>();
+
+        for (idx s = 0; s < d; ++s)
+            As_[k][s] = adjoint(Q.middleRows(s * chir, chir));
+        for (auto&& A : As_[k - 1])
+            A = A * adjoint(R);
+        --center_;
+    }
+
+    /**
+    * \brief Moves the orthogonality center to the site \a k
+    */
+    void move_center_(idx k)
+    {
+        while (center_ < k)
+            shift_right_();
+        while (center_ > k)
+            shift_left_();
+    }
+
+    /**
+    * \brief Number of singular values to keep out of \a sv, sorted in
+    * decreasing order, and the corresponding discarded weight
+    */
+    idx truncation_(const dyn_col_vect<double>& sv, double& discarded) const
+    {
+        idx n = static_cast<idx>(sv.size());
+        double total = sv.squaredNorm();
+
+        // drop the numerical zeros, relative to the largest singular value,
+        // so that product states keep a unit bond dimension
+        idx keep = n;
+        while (keep > 1 && sv(keep - 1) <= chop * sv(0))
+            --keep;
+        keep = std::min(keep, max_chi_);
+
+        // then the smallest ones, as long as the discarded weight allows
+        discarded = 0;
+        for (idx j = keep; j < n; ++j)
+            discarded += sv(j) * sv(j);
+        while (keep > 1 &&
+               discarded + sv(keep - 1) * sv(keep - 1) <=
+               max_discarded_ * total)
+        {
+            --keep;
+            discarded += sv(keep) * sv(keep);
+        }
+        discarded = total > 0 ? discarded / total : 0;
+
+        return keep;
+    }
+
+    /**
+    * \brief Applies the two-site gate \a U to the adjacent sites \a k and
+    * \a k + 1, no checks, then moves the center to \a k + 1
+    *
+    * \note The output dimensions of the sites are \a e1 and \a e2, which
+    * differ from the input ones for a SWAP of sites of different dimensions
+    */
+    void apply2_(const cmat& U, idx k, idx e1, idx e2)
+    {
+        move_center_(k);
+
+        idx d1 = dims_[k], d2 = dims_[k + 1];
+        idx chil = chil_(k), chir = chir_(k + 1);
+
+        // contracted two-site tensor, theta[s1 * d2 + s2]
+        std::vector<cmat> theta(d1 * d2);
+        for (idx s1 = 0; s1 < d1; ++s1)
+            for (idx s2 = 0; s2 < d2; ++s2)
+                theta[s1 * d2 + s2] = As_[k][s1] * As_[k + 1][s2];
+
+        // rows (a, s1), columns (s2, b), in the output dimensions
+        cmat M = cmat::Zero(chil * e1, e2 * chir);
+        for (idx i = 0; i < e1 * e2; ++i)
+        {
+            cmat Utheta = cmat::Zero(chil, chir);
+            for (idx j = 0; j < d1 * d2; ++j)
+                if (U(i, j) != 0.)
+                    Utheta += U(i, j) * theta[j];
+            idx s1 = i / e2, s2 = i % e2;
+            for (idx a = 0; a < chil; ++a)
+                M.block(a * e1 + s1, s2 * chir, 1, chir) = Utheta.row(a);
+        }
+
+        Eigen::JacobiSVD<cmat> sv(M, Eigen::ComputeThinU | Eigen::ComputeThinV);
+        dyn_col_vect<double> svals = sv.singularValues();
+        double discarded;
+        idx r = truncation_(svals, discarded);
+        discarded_ += discarded;
+
+        // keeps the norm
+        double kept = svals.head(r).norm();
+        if (kept > 0)
+            svals *= svals.norm() / kept;
+
+        cmat Uleft = sv.matrixU().leftCols(r);
+        cmat SVdag = svals.head(r).asDiagonal() *
+                     adjoint(sv.matrixV().leftCols(r));
+        As_[k].resize(e1);
+        for (idx s1 = 0; s1 < e1; ++s1)
+        {
+            As_[k][s1].resize(chil, r);
+            for (idx a = 0; a < chil; ++a)
+                As_[k][s1].row(a) = Uleft.row(a * e1 + s1);
+        }
+        As_[k + 1].resize(e2);
+        for (idx s2 = 0; s2 < e2; ++s2)
+            As_[k + 1][s2] = SVdag.middleCols(s2 * chir, chir);
+        dims_[k] = e1;
+        dims_[k + 1] = e2;
+        center_ = k + 1;
+    }
+
+    /**
+    * \brief SWAP gate of two qudits of dimensions \a da and \a db
+    */
+    static cmat swap_(idx da, idx db)
+    {
+        cmat result = cmat::Zero(da * db, da * db);
+        for (idx a = 0; a < da; ++a)
+            for (idx b = 0; b < db; ++b)
+                result(b * da + a, a * db + b) = 1;
+
+        return result;
+    }
+
+    /**
+    * \brief Swaps the adjacent sites \a k and \a k + 1
+    */
+    void swap_sites_(idx k)
+    {
+        apply2_(swap_(dims_[k], dims_[k + 1]), k, dims_[k + 1], dims_[k]);
+    }
+
+    /**
+    * \brief Total dimension, throws if it does not fit in qpp::idx
+    */
+    idx total_dim_(const std::string& context) const
+    {
+        idx D = 1;
+        for (idx d : dims_)
+        {
+            if (D > std::numeric_limits<idx>::max() / d)
+                throw Exception(context, Exception::Type::OUT_OF_RANGE);
+            D *= d;
+        }
+
+        return D;
+    }
+
+public:
+    /**
+    * \brief Constructs the multi-partite basis state \f$|mask\rangle\f$
+    * \see qpp::mket()
+    *
+    * \param mask Multi-index of the basis state
+    * \param dims Dimensions of the multi-partite system
+    * \param max_chi Maximum bond dimension kept by the truncations
+    * \param max_discarded Maximum weight discarded by each truncation,
+    * relative to the total weight
+    */
+    MPS(const std::vector<idx>& mask, const std::vector<idx>& dims,
+        idx max_chi = std::numeric_limits<idx>::max(),
+        double max_discarded = 0) :
+            dims_{dims}, max_chi_{max_chi}, max_discarded_{max_discarded},
+            As_{}, center_{0}, discarded_{0}
+    {
+        // EXCEPTION CHECKS
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::MPS::MPS()", Exception::Type::DIMS_INVALID);
+
+        // check mask and dims have the same size
+        if (mask.size() != dims.size())
+            throw Exception("qpp::MPS::MPS()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check mask is a valid vector
+        for (idx i = 0; i < mask.size(); ++i)
+            if (mask[i] >= dims[i])
+                throw Exception("qpp::MPS::MPS()",
+                                Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check the truncation parameters
+        if (max_chi == 0 || max_discarded < 0 || max_discarded >= 1)
+            throw Exception("qpp::MPS::MPS()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        As_.resize(dims.size());
+        for (idx k = 0; k < dims.size(); ++k)
+        {
+            As_[k].assign(dims[k], cmat::Zero(1, 1));
+            As_[k][mask[k]](0, 0) = 1;
+        }
+    }
+
+    /**
+    * \brief Constructs the matrix product state of the multi-partite state
+    * vector \a psi, by successive SVDs
+    *
+    * \param psi Eigen expression
+    * \param dims Dimensions of the multi-partite system
+    * \param max_chi Maximum bond dimension kept by the truncations
+    * \param max_discarded Maximum weight discarded by each truncation,
+    * relative to the total weight
+    */
+    template<typename Derived>
+    MPS(const Eigen::MatrixBase<Derived>& psi, const std::vector<idx>& dims,
+        idx max_chi = std::numeric_limits<idx>::max(),
+        double max_discarded = 0) :
+            dims_{dims}, max_chi_{max_chi}, max_discarded_{max_discarded},
+            As_{}, center_{0}, discarded_{0}
+    {
+        const dyn_mat<typename Derived::Scalar>& rpsi = psi.derived();
+
+        // EXCEPTION CHECKS
+
+        // check zero-size
+        if (!internal::check_nonzero_size(rpsi))
+            throw Exception("qpp::MPS::MPS()", Exception::Type::ZERO_SIZE);
+
+        // check column vector
+        if (!internal::check_cvector(rpsi))
+            throw Exception("qpp::MPS::MPS()",
+                            Exception::Type::MATRIX_NOT_CVECTOR);
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::MPS::MPS()", Exception::Type::DIMS_INVALID);
+
+        // check that dims match psi column vector
+        if (!internal::check_dims_match_cvect(dims, rpsi))
+            throw Exception("qpp::MPS::MPS()",
+                            Exception::Type::DIMS_MISMATCH_CVECTOR);
+
+        // check the truncation parameters
+        if (max_chi == 0 || max_discarded < 0 || max_discarded >= 1)
+            throw Exception("qpp::MPS::MPS()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        idx N = dims.size();
+        As_.resize(N);
+
+        // remainder, rows a, columns the remaining sites
+        cmat rest = rpsi.transpose();
+        for (idx k = 0; k + 1 < N; ++k)
+        {
+            idx d = dims[k], chil = static_cast<idx>(rest.rows());
+            idx cols = static_cast<idx>(rest.cols()) / d;
+
+            // rows (a, s), columns the remaining sites
+            cmat M(chil * d, cols);
+            for (idx a = 0; a < chil; ++a)
+                for (idx s = 0; s < d; ++s)
+                    M.row(a * d + s) = rest.block(a, s * cols, 1, cols);
+
+            Eigen::JacobiSVD<cmat> sv(M, Eigen::ComputeThinU |
+                                         Eigen::ComputeThinV);
+            dyn_col_vect<double> svals = sv.singularValues();
+            double discarded;
+            idx r = truncation_(svals, discarded);
+            discarded_ += discarded;
+            double kept = svals.head(r).norm();
+            if (kept > 0)
+                svals *= svals.norm() / kept;
+
+            cmat Uleft = sv.matrixU().leftCols(r);
+            As_[k].resize(d);
+            for (idx s = 0; s < d; ++s)
+            {
+                As_[k][s].resize(chil, r);
+                for (idx a = 0; a < chil; ++a)
+                    As_[k][s].row(a) = Uleft.row(a * d + s);
+            }
+            rest = svals.head(r).asDiagonal() *
+                   adjoint(sv.matrixV().leftCols(r));
+        }
+
+        As_[N - 1].resize(dims[N - 1]);
+        for (idx s = 0; s < dims[N - 1]; ++s)
+            As_[N - 1][s] = rest.col(s);
+        center_ = N - 1;
+    }
+
+    /**
+    * \brief Applies the gate \a U to the part \a subsys
+    *
+    * \note The dimension of the gate \a U must match the dimension of
+    * \a subsys, which contains one or two sites. Two non-adjacent sites are
+    * first brought next to each other by SWAP gates, then swapped back.
+    *
+    * \param U Gate
+    * \param subsys Subsystem indexes where the gate \a U is applied
+    * \return Reference to the current instance
+    */
+    MPS& apply(const cmat& U, const std::vector<idx>& subsys)
+    {
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(U))
+            throw Exception("qpp::MPS::apply()", Exception::Type::ZERO_SIZE);
+
+        // check square matrix for the gate
+        if (!internal::check_square_mat(U))
+            throw Exception("qpp::MPS::apply()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check that subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception("qpp::MPS::apply()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check one- or two-site gate
+        if (subsys.size() == 0 || subsys.size() > 2)
+            throw Exception("qpp::MPS::apply()",
+                            "Only 1- and 2-site gates are supported!");
+
+        // check that gate matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims_[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, U))
+            throw Exception("qpp::MPS::apply()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+        // END EXCEPTION CHECKS
+
+        //************ one site ************//
+        if (subsys.size() == 1)
+        {
+            idx k = subsys[0];
+            move_center_(k);
+            std::vector<cmat> As(dims_[k], cmat::Zero(chil_(k), chir_(k)));
+            for (idx s = 0; s < dims_[k]; ++s)
+                for (idx t = 0; t < dims_[k]; ++t)
+                    if (U(s, t) != 0.)
+                        As[s] += U(s, t) * As_[k][t];
+            As_[k] = std::move(As);
+
+            return *this;
+        }
+
+        //************ two sites ************//
+        idx i = std::min(subsys[0], subsys[1]);
+        idx j = std::max(subsys[0], subsys[1]);
+
+        // gate in the order of the sites
+        cmat V = subsys[0] < subsys[1] ? U : cmat(
+                syspermute(U, {1, 0}, {dims_[subsys[0]], dims_[subsys[1]]}));
+
+        // brings the site j next to i, applies, then moves it back
+        for (idx k = j - 1; k > i; --k)
+            swap_sites_(k);
+        apply2_(V, i, dims_[i], dims_[i + 1]);
+        for (idx k = i + 1; k < j; ++k)
+            swap_sites_(k);
+
+        return *this;
+    }
+
+    /**
+    * \brief Sequentially measures the part \a subsys in the computational
+    * basis
+    * \see qpp::measure_seq()
+    *
+    * \note The measurement is non-destructive, i.e. the measured sites are
+    * left in the basis states given by the results. The results are
+    * sampled using qpp::RandomDevices.
+    *
+    * \param subsys Subsystem indexes that are measured
+    * \return Tuple of: 1. Vector of outcome results of the measurement
+    * (ordered in increasing order with respect to \a subsys, i.e. first
+    * measurement result corresponds to the subsystem with the smallest
+    * index), and 2. Outcome probability
+    */
+    std::tuple<std::vector<idx>, double> measure_seq(std::vector<idx> subsys)
+    {
+        // EXCEPTION CHECKS
+
+        // check that subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception("qpp::MPS::measure_seq()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        std::sort(std::begin(subsys), std::end(subsys));
+
+        std::vector<idx> result;
+        double prob = 1;
+        for (idx k : subsys)
+        {
+            // the center carries the whole norm
+            move_center_(k);
+            std::vector<double> p(dims_[k]);
+            for (idx s = 0; s < dims_[k]; ++s)
+                p[s] = As_[k][s].squaredNorm();
+
+            std::discrete_distribution<idx> dd(std::begin(p), std::end(p));
+            idx m = dd(RandomDevices::get_instance().rng_);
+            double total = std::accumulate(std::begin(p), std::end(p), 0.);
+
+            for (idx s = 0; s < dims_[k]; ++s)
+                if (s != m)
+                    As_[k][s].setZero();
+            As_[k][m] *= std::sqrt(total / p[m]);
+            result.push_back(m);
+            prob *= p[m] / total;
+        }
+
+        return std::make_tuple(result, prob);
+    }
+
+    /**
+    * \brief Inner product \f$\langle\psi|\phi\rangle\f$, where
+    * \f$|\psi\rangle\f$ is the current state
+    *
+    * \param phi Matrix product state on the same system
+    * \return Inner product
+    */
+    cplx dot(const MPS& phi) const
+    {
+        // EXCEPTION CHECKS
+
+        // check that the dimensions match
+        if (phi.dims_ != dims_)
+            throw Exception("qpp::MPS::dot()", Exception::Type::DIMS_NOT_EQUAL);
+        // END EXCEPTION CHECKS
+
+        // transfer matrix, contracted from the left
+        cmat E = cmat::Ones(1, 1);
+        for (idx k = 0; k < dims_.size(); ++k)
+        {
+            cmat F = cmat::Zero(chir_(k), phi.chir_(k));
+            for (idx s = 0; s < dims_[k]; ++s)
+                F += adjoint(As_[k][s]) * E * phi.As_[k][s];
+            E = std::move(F);
+        }
+
+        return E(0, 0);
+    }
+
+    /**
+    * \brief Norm of the state
+    *
+    * \return Norm
+    */
+    double norm() const
+    {
+        return std::sqrt(std::abs(dot(*this)));
+    }
+
+    /**
+    * \brief Expectation value of the observable \a A acting on the part
+    * \a subsys
+    *
+    * \note The observable acts on one or two sites, see
+    * qpp::MPS::apply()
+    *
+    * \param A Observable
+    * \param subsys Subsystem indexes where the observable \a A acts
+    * \return Expectation value \f$\langle\psi|A|\psi\rangle\f$
+    */
+    cplx expval(const cmat& A, const std::vector<idx>& subsys) const
+    {
+        // no truncation, A is not necessarily unitary
+        MPS Apsi{*this};
+        Apsi.max_chi_ = std::numeric_limits<idx>::max();
+        Apsi.max_discarded_ = 0;
+        Apsi.apply(A, subsys);
+
+        return dot(Apsi);
+    }
+
+    /**
+    * \brief Dense state vector
+    *
+    * \return State vector of dimension the product of the local dimensions
+    */
+    ket to_ket() const
+    {
+        idx D = total_dim_("qpp::MPS::to_ket()");
+
+        // rows the basis states of the sites contracted so far
+        cmat psi = cmat::Ones(1, 1);
+        for (idx k = 0; k < dims_.size(); ++k)
+        {
+            idx d = dims_[k];
+            cmat next(psi.rows() * d, chir_(k));
+            for (idx i = 0; i < static_cast<idx>(psi.rows()); ++i)
+                for (idx s = 0; s < d; ++s)
+                    next.row(i * d + s) = psi.row(i) * As_[k][s];
+            psi = std::move(next);
+        }
+        assert(static_cast<idx>(psi.rows()) == D);
+        (void) D;
+
+        return psi.col(0);
+    }
+
+    /**
+    * \brief Bond dimensions \f$\chi_1,\ldots,\chi_{N-1}\f$
+    *
+    * \return Bond dimensions
+    */
+    std::vector<idx> get_bond_dims() const
+    {
+        std::vector<idx> result;
+        for (idx k = 0; k + 1 < dims_.size(); ++k)
+            result.push_back(chir_(k));
+
+        return result;
+    }
+
+    /**
+    * \brief Sum of the relative weights discarded by all the truncations,
+    * an estimate of the infidelity of the state
+    *
+    * \return Total discarded weight
+    */
+    double get_discarded() const noexcept
+    {
+        return discarded_;
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream the bond dimensions
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        return os << "bond dims: " << disp(get_bond_dims(), ", ");
+    }
+}; /* class MPS */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_MPS_H_ */
@@ -0,0 +1,352 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/qcircuit.h
+* \brief Quantum circuit description
+*/
+
+#ifndef CLASSES_QCIRCUIT_H_
+#define CLASSES_QCIRCUIT_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::QCircuit
+* \brief Quantum circuit description
+* \see qpp::QEngine
+*
+* Records, in order, the gates, controlled gates, channels and measurements
+* acting on a multi-partite system of fixed dimensions. Nothing is computed
+* when recording; the circuit is executed by a qpp::QEngine, which may
+* reorder and fuse its steps.
+*
+* \note Measurements are non-destructive, i.e. the measured subsystems are
+* kept, in the post-measurement state, and the dimensions of the system
+* never change along the circuit.
+*/
+class QCircuit : public IDisplay
+{
+public:
+    /**
+    * \brief Type of a circuit step
+    */
+    enum class Type
+    {
+        GATE,        ///< gate
+        CTRL_GATE,   ///< controlled gate
+        CHANNEL,     ///< quantum channel, given by its Kraus operators
+        MEASUREMENT  ///< measurement, given by its Kraus operators
+    };
+
+    /**
+    * \brief Circuit step
+    */
+    struct Step
+    {
+        Type type;               ///< type of the step
+        std::vector<cmat> ops;   ///< gate or Kraus operators
+        std::vector<idx> ctrl;   ///< control subsystem indexes
+        std::vector<idx> subsys; ///< subsystem indexes acted on
+        std::string name;        ///< optional name
+        bool computational;      ///< computational-basis measurement, no ops
+    };
+
+private:
+    std::vector<idx> dims_;   ///< dimensions of the multi-partite system
+    std::vector<Step> steps_; ///< circuit steps, in order
+    idx nummeas_;             ///< number of measurements
+
+    /**
+    * \brief Checks that the square operators \a ops match the subsystems
+    * \a subsys, throws otherwise
+    */
+    void check_ops_(const std::vector<cmat>& ops,
+                    const std::vector<idx>& subsys,
+                    const std::string& context) const
+    {
+        // check subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception(context, Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check the operators
+        if (ops.size() == 0)
+            throw Exception(context, Exception::Type::ZERO_SIZE);
+
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims_[subsys[i]];
+        for (auto&& it : ops)
+        {
+            if (!internal::check_nonzero_size(it))
+                throw Exception(context, Exception::Type::ZERO_SIZE);
+            if (!internal::check_square_mat(it))
+                throw Exception(context, Exception::Type::MATRIX_NOT_SQUARE);
+            if (!internal::check_dims_match_mat(subsys_dims, it))
+                throw Exception(context,
+                                Exception::Type::MATRIX_MISMATCH_SUBSYS);
+        }
+    }
+
+public:
+    /**
+    * \brief Constructs an empty circuit on a multi-partite system
+    *
+    * \param dims Dimensions of the multi-partite system
+    */
+    explicit QCircuit(const std::vector<idx>& dims) :
+            dims_{dims}, steps_{}, nummeas_{0}
+    {
+        // EXCEPTION CHECKS
+
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception("qpp::QCircuit::QCircuit()",
+                            Exception::Type::DIMS_INVALID);
+        // END EXCEPTION CHECKS
+    }
+
+    /**
+    * \brief Constructs an empty circuit on \a N qudits
+    *
+    * \param N Number of subsystems
+    * \param d Subsystem dimensions
+    */
+    explicit QCircuit(idx N, idx d = 2) :
+            QCircuit(std::vector<idx>(N, d))
+    {
+    }
+
+    /**
+    * \brief Appends the gate \a U acting on the part \a subsys
+    *
+    * \note The dimension of the gate \a U must match
+    * the dimension of \a subsys
+    *
+    * \param U Gate
+    * \param subsys Subsystem indexes where the gate \a U is applied
+    * \param name Optional name of the gate
+    * \return Reference to the current instance
+    */
+    QCircuit& gate(const cmat& U, const std::vector<idx>& subsys,
+                   const std::string& name = {})
+    {
+        check_ops_({U}, subsys, "qpp::QCircuit::gate()");
+        steps_.push_back(Step{Type::GATE, {U}, {}, subsys, name, false});
+
+        return *this;
+    }
+
+    /**
+    * \brief Appends the controlled-gate \a U acting on the part \a subsys
+    * \see qpp::Gates::CTRL()
+    *
+    * \note The dimension of the gate \a U must match
+    * the dimension of \a subsys.
+    * Also, all control subsystems in \a ctrl must have the same dimension.
+    *
+    * \param U Gate
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a U is applied
+    * \param name Optional name of the gate
+    * \return Reference to the current instance
+    */
+    QCircuit& CTRL(const cmat& U, const std::vector<idx>& ctrl,
+                   const std::vector<idx>& subsys,
+                   const std::string& name = {})
+    {
+        // EXCEPTION CHECKS
+
+        check_ops_({U}, subsys, "qpp::QCircuit::CTRL()");
+
+        // check ctrl is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(ctrl, dims_))
+            throw Exception("qpp::QCircuit::CTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that all control subsystems have the same dimension
+        for (idx i = 1; i < ctrl.size(); ++i)
+            if (dims_[ctrl[i]] != dims_[ctrl[0]])
+                throw Exception("qpp::QCircuit::CTRL()",
+                                Exception::Type::DIMS_NOT_EQUAL);
+
+        // check that ctrl + gate subsystem is valid
+        std::vector<idx> ctrlgate = ctrl;
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+        if (!internal::check_subsys_match_dims(ctrlgate, dims_))
+            throw Exception("qpp::QCircuit::CTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        steps_.push_back(Step{Type::CTRL_GATE, {U}, ctrl, subsys, name,
+                              false});
+
+        return *this;
+    }
+
+    /**
+    * \brief Appends the channel specified by the set of Kraus operators
+    * \a Ks acting on the part \a subsys
+    *
+    * \note The dimension of all \a Ks must match the dimension of \a subsys
+    *
+    * \param Ks Set of Kraus operators
+    * \param subsys Subsystem indexes where the channel is applied
+    * \param name Optional name of the channel
+    * \return Reference to the current instance
+    */
+    QCircuit& channel(const std::vector<cmat>& Ks,
+                      const std::vector<idx>& subsys,
+                      const std::string& name = {})
+    {
+        check_ops_(Ks, subsys, "qpp::QCircuit::channel()");
+        steps_.push_back(Step{Type::CHANNEL, Ks, {}, subsys, name, false});
+
+        return *this;
+    }
+
+    /**
+    * \brief Appends the measurement of the part \a subsys using the set
+    * of Kraus operators \a Ks
+    *
+    * \note The dimension of all \a Ks must match the dimension of \a subsys
+    *
+    * \param Ks Set of Kraus operators
+    * \param subsys Subsystem indexes that are measured
+    * \param name Optional name of the measurement
+    * \return Reference to the current instance
+    */
+    QCircuit& measure(const std::vector<cmat>& Ks,
+                      const std::vector<idx>& subsys,
+                      const std::string& name = {})
+    {
+        check_ops_(Ks, subsys, "qpp::QCircuit::measure()");
+        steps_.push_back(Step{Type::MEASUREMENT, Ks, {}, subsys, name,
+                              false});
+        ++nummeas_;
+
+        return *this;
+    }
+
+    /**
+    * \brief Appends the measurement of the part \a subsys in the
+    * computational basis
+    *
+    * \note Stored as a flag, see qpp::QCircuit::Step::computational, with
+    * no operators
+    *
+    * \param subsys Subsystem indexes that are measured
+    * \param name Optional name of the measurement
+    * \return Reference to the current instance
+    */
+    QCircuit& measure(const std::vector<idx>& subsys,
+                      const std::string& name = {})
+    {
+        // EXCEPTION CHECKS
+
+        // check subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception("qpp::QCircuit::measure()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        // no projectors are stored, the outcomes are the basis states of
+        // subsys, ordered as in qpp::measure()
+        steps_.push_back(Step{Type::MEASUREMENT, {}, {}, subsys, name, true});
+        ++nummeas_;
+
+        return *this;
+    }
+
+    /**
+    * \brief Circuit steps, in order
+    *
+    * \return Circuit steps
+    */
+    const std::vector<Step>& get_steps() const noexcept
+    {
+        return steps_;
+    }
+
+    /**
+    * \brief Number of measurements
+    *
+    * \return Number of measurements
+    */
+    idx get_num_measurements() const noexcept
+    {
+        return nummeas_;
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream one line per circuit step
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        os << "dims: " << disp(dims_, ", ");
+        for (auto&& step : steps_)
+        {
+            os << '\n';
+            switch (step.type)
+            {
+                case Type::GATE:
+                    os << "GATE";
+                    break;
+                case Type::CTRL_GATE:
+                    os << "CTRL_GATE";
+                    break;
+                case Type::CHANNEL:
+                    os << "CHANNEL";
+                    break;
+                case Type::MEASUREMENT:
+                    os << "MEASUREMENT";
+                    break;
+            }
+            if (step.name.size() > 0)
+                os << " \"" << step.name << '"';
+            if (step.ctrl.size() > 0)
+                os << ", ctrl: " << disp(step.ctrl, ", ");
+            os << ", subsys: " << disp(step.subsys, ", ");
+        }
+
+        return os;
+    }
+}; /* class QCircuit */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_QCIRCUIT_H_ */
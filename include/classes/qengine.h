@@ -0,0 +1,299 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/qengine.h
+* \brief Quantum circuit execution engine
+*/
+
+#ifndef CLASSES_QENGINE_H_
+#define CLASSES_QENGINE_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::QEngine
+* \brief Executes a qpp::QCircuit on state vectors or density matrices
+* \see qpp::QCircuit, qpp::GateFusion
+*
+* The circuit is compiled once, at construction: each run of consecutive
+* (controlled) gates is fused into dense blocks by a qpp::GateFusion, whose
+* plans are reused by every call to qpp::QEngine::execute(). Channels and
+* measurements separate the runs.
+*
+* \note A state vector is turned into the corresponding density matrix when
+* the first channel is reached. Measurement results are sampled using
+* qpp::RandomDevices.
+*/
+class QEngine : public IDisplay
+{
+protected:
+    /**
+    * \brief Compiled part of the circuit
+    */
+    struct Segment
+    {
+        bool fused; ///< run of gates, otherwise a channel or a measurement
+        idx pos;    ///< index of the fusion or of the circuit step
+    };
+
+    QCircuit qc_;                       ///< circuit
+    std::vector<GateFusion<>> fusions_; ///< fused runs of gates
+    std::vector<Segment> segments_;     ///< compiled circuit, in order
+
+private:
+    cmat state_;                        ///< current state
+    std::vector<idx> results_;          ///< measurement results
+    std::vector<double> probs_;         ///< measurement result probabilities
+
+public:
+    /**
+    * \brief Compiles the circuit \a qc
+    *
+    * \param qc Quantum circuit, copied
+    * \param max_subsys Maximum number of subsystems a fused block may act on
+    */
+    explicit QEngine(const QCircuit& qc, idx max_subsys = 3) :
+            qc_{qc}, fusions_{}, segments_{}, state_{}, results_{}, probs_{}
+    {
+        // EXCEPTION CHECKS
+
+        // check the maximum size of the blocks
+        if (max_subsys == 0)
+            throw Exception("qpp::QEngine::QEngine()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        const std::vector<QCircuit::Step>& steps = qc_.get_steps();
+        for (idx i = 0; i < steps.size(); ++i)
+        {
+            switch (steps[i].type)
+            {
+                case QCircuit::Type::GATE:
+                case QCircuit::Type::CTRL_GATE:
+                    // start a new run of gates if needed
+                    if (segments_.size() == 0 || !segments_.back().fused)
+                    {
+                        fusions_.emplace_back(qc_.get_dims(), max_subsys);
+                        segments_.push_back(Segment{true,
+                                                    fusions_.size() - 1});
+                    }
+                    fusions_.back().add(steps[i].ops[0], steps[i].ctrl,
+                                        steps[i].subsys);
+                    break;
+                case QCircuit::Type::CHANNEL:
+                case QCircuit::Type::MEASUREMENT:
+                    segments_.push_back(Segment{false, i});
+                    break;
+            }
+        }
+    }
+
+    /**
+    * \brief Executes the circuit on the multi-partite state vector or
+    * density matrix \a state
+    *
+    * \note Clears the measurement results of the previous execution
+    *
+    * \param state Eigen expression
+    * \return Output state, a density matrix if the circuit contains channels
+    * and a state vector otherwise if \a state is a state vector
+    */
+    template<typename Derived>
+    const cmat& execute(const Eigen::MatrixBase<Derived>& state)
+    {
+        const std::vector<idx>& dims = qc_.get_dims();
+
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(state))
+            throw Exception("qpp::QEngine::execute()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check ket or density matrix matching the dims
+        if (internal::check_cvector(state))
+        {
+            if (!internal::check_dims_match_cvect(dims, state))
+                throw Exception("qpp::QEngine::execute()",
+                                Exception::Type::DIMS_MISMATCH_CVECTOR);
+        } else if (internal::check_square_mat(state))
+        {
+            if (!internal::check_dims_match_mat(dims, state))
+                throw Exception("qpp::QEngine::execute()",
+                                Exception::Type::DIMS_MISMATCH_MATRIX);
+        } else
+            throw Exception("qpp::QEngine::execute()",
+                            Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
+        // END EXCEPTION CHECKS
+
+        state_ = state.derived();
+        results_.clear();
+        probs_.clear();
+
+        const std::vector<QCircuit::Step>& steps = qc_.get_steps();
+        for (auto&& segment : segments_)
+        {
+            if (segment.fused)
+            {
+                fusions_[segment.pos].execute(state_);
+                continue;
+            }
+
+            const QCircuit::Step& step = steps[segment.pos];
+            bool is_ket = internal::check_cvector(state_);
+
+            //************ channel ************//
+            if (step.type == QCircuit::Type::CHANNEL)
+            {
+                if (is_ket)
+                    state_ = state_ * adjoint(state_);
+                state_ = apply(state_, step.ops, step.subsys, dims);
+                continue;
+            }
+
+            //************ measurement ************//
+            idx result;
+            double prob;
+            if (is_ket)
+            {
+                // probabilities first, then only the result is applied
+                std::tuple<idx, std::vector<double>> tmp =
+                        step.computational
+                        ? measure_inplace(state_, step.subsys, dims)
+                        : measure_inplace(state_, step.ops, step.subsys,
+                                          dims);
+                result = std::get<0>(tmp);
+                prob = std::get<1>(tmp)[result];
+            } else
+            {
+                // probabilities from the diagonal of the density matrix, or
+                // from the reduced state of subsys
+                std::vector<double> probs_rho;
+                if (step.computational)
+                    probs_rho = probs(state_, step.subsys, dims);
+                else
+                {
+                    cmat rho_subsys =
+                            internal::reduced_state(state_, step.subsys, dims);
+                    probs_rho.resize(step.ops.size());
+                    for (idx i = 0; i < step.ops.size(); ++i)
+                        probs_rho[i] = std::abs(trace(
+                                step.ops[i] * rho_subsys
+                                * adjoint(step.ops[i])));
+                }
+
+                // sample from the probability distribution
+                std::discrete_distribution<idx> dd(std::begin(probs_rho),
+                                                   std::end(probs_rho));
+                result = dd(RandomDevices::get_instance().rng_);
+                prob = probs_rho[result];
+
+                // normalized post-measurement state
+                if (step.computational)
+                    internal::collapse_inplace(state_, result, prob,
+                                               step.subsys, dims);
+                else
+                    state_ = apply(state_, step.ops[result], step.subsys,
+                                   dims) / prob;
+            }
+            results_.push_back(result);
+            probs_.push_back(prob);
+        }
+
+        return state_;
+    }
+
+    /**
+    * \brief Output state of the last execution
+    *
+    * \return Output state
+    */
+    const cmat& get_state() const noexcept
+    {
+        return state_;
+    }
+
+    /**
+    * \brief Measurement results of the last execution, in the order of the
+    * measurements in the circuit
+    *
+    * \return Measurement results
+    */
+    const std::vector<idx>& get_results() const noexcept
+    {
+        return results_;
+    }
+
+    /**
+    * \brief Probabilities of the measurement results of the last execution
+    *
+    * \return Probabilities of the measurement results
+    */
+    const std::vector<double>& get_probs() const noexcept
+    {
+        return probs_;
+    }
+
+    /**
+    * \brief Executed circuit
+    *
+    * \return Quantum circuit
+    */
+    const QCircuit& get_circuit() const noexcept
+    {
+        return qc_;
+    }
+
+    /**
+    * \brief Number of state sweeps performed by the compiled circuit, i.e.
+    * the number of fused blocks plus the number of channels and measurements
+    *
+    * \return Number of state sweeps
+    */
+    idx get_num_sweeps() const noexcept
+    {
+        idx result = 0;
+        for (auto&& segment : segments_)
+            result += segment.fused
+                      ? fusions_[segment.pos].get_blocks().size() : 1;
+
+        return result;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream the measurement results of the last
+    * execution
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        return os << disp(results_, " ");
+    }
+}; /* class QEngine */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_QENGINE_H_ */
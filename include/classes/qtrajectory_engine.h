@@ -0,0 +1,332 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/qtrajectory_engine.h
+* \brief Monte Carlo wavefunction (quantum trajectories) circuit engine
+*/
+
+#ifndef CLASSES_QTRAJECTORY_ENGINE_H_
+#define CLASSES_QTRAJECTORY_ENGINE_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::QTrajectoryEngine
+* \brief Executes a noisy qpp::QCircuit on state vectors by sampling quantum
+* trajectories
+* \see qpp::QEngine
+*
+* Each trajectory evolves a state vector through the compiled circuit. At
+* every channel a single Kraus operator \f$K_i\f$ is applied, sampled with
+* probability \f$\|K_i|\psi\rangle\|^2\f$, and the state is renormalized;
+* measurements are sampled in the same way. Memory is O(D) per thread,
+* instead of the O(D^2) of a density matrix.
+*
+* Trajectories are independent and run in parallel. Each one draws from its
+* own std::mt19937 stream, seeded from qpp::RandomDevices before the run, so
+* the results do not depend on the number of threads.
+*
+* \note The channels are assumed to be trace preserving
+*/
+class QTrajectoryEngine : public QEngine
+{
+    /**
+    * \brief Observable, together with the subsystems it acts on
+    */
+    struct Observable
+    {
+        cmat A;                  ///< observable
+        std::vector<idx> subsys; ///< subsystem indexes acted on
+    };
+
+    std::vector<Observable> observables_;      ///< registered observables
+    std::vector<cplx> expvals_;                ///< averaged expectation values
+    cmat rho_;                                 ///< averaged density matrix
+    std::vector<std::vector<idx>> traj_results_; ///< measurement results
+
+    /**
+    * \brief Applies to \a psi the Kraus operator of the channel or
+    * measurement \a step sampled with the generator \a gen, then normalizes
+    * \a psi
+    *
+    * \note A computational-basis measurement collapses \a psi onto the
+    * sampled basis state of the measured subsystems
+    *
+    * \return Index of the sampled Kraus operator, or of the basis state
+    */
+    idx sample_kraus_(const QCircuit::Step& step, ket& psi,
+                      std::mt19937& gen) const
+    {
+        const std::vector<idx>& dims = qc_.get_dims();
+        if (step.computational)
+        {
+            std::vector<double> prob = probs(psi, step.subsys, dims);
+            idx result = std::discrete_distribution<idx>(
+                    std::begin(prob), std::end(prob))(gen);
+            internal::collapse_inplace(psi, result, prob[result],
+                                       step.subsys, dims);
+
+            return result;
+        }
+
+        double u = std::uniform_real_distribution<>{0, 1}(gen);
+        double cumul = 0;
+        idx last = 0; // last Kraus operator with non-zero weight
+
+        for (idx i = 0; i < step.ops.size(); ++i)
+        {
+            ket phi = apply(psi, step.ops[i], step.subsys, dims);
+            double p = phi.squaredNorm();
+            if (p == 0)
+                continue;
+            cumul += p;
+            last = i;
+            if (u < cumul)
+            {
+                psi = phi / std::sqrt(p);
+                return i;
+            }
+        }
+
+        // round-off, the weights sum to slightly less than 1
+        psi = apply(psi, step.ops[last], step.subsys, dims);
+        psi /= norm(psi);
+
+        return last;
+    }
+
+public:
+    /**
+    * \brief Compiles the circuit \a qc
+    *
+    * \param qc Quantum circuit, copied
+    * \param max_subsys Maximum number of subsystems a fused block may act on
+    */
+    explicit QTrajectoryEngine(const QCircuit& qc, idx max_subsys = 3) :
+            QEngine(qc, max_subsys), observables_{}, expvals_{}, rho_{},
+            traj_results_{}
+    {
+    }
+
+    /**
+    * \brief Registers the observable \a A acting on the part \a subsys,
+    * whose expectation value is averaged over the trajectories
+    *
+    * \note The dimension of \a A must match the dimension of \a subsys
+    *
+    * \param A Observable
+    * \param subsys Subsystem indexes where the observable \a A acts
+    * \return Reference to the current instance
+    */
+    QTrajectoryEngine& observable(const cmat& A,
+                                  const std::vector<idx>& subsys)
+    {
+        const std::vector<idx>& dims = qc_.get_dims();
+
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(A))
+            throw Exception("qpp::QTrajectoryEngine::observable()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix
+        if (!internal::check_square_mat(A))
+            throw Exception("qpp::QTrajectoryEngine::observable()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims))
+            throw Exception("qpp::QTrajectoryEngine::observable()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that the observable matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, A))
+            throw Exception("qpp::QTrajectoryEngine::observable()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+        // END EXCEPTION CHECKS
+
+        observables_.push_back(Observable{A, subsys});
+
+        return *this;
+    }
+
+    /**
+    * \brief Runs \a num_traj trajectories starting from the multi-partite
+    * state vector \a psi
+    *
+    * \note Clears the averages and measurement results of the previous run
+    *
+    * \param psi Eigen expression
+    * \param num_traj Number of trajectories
+    * \param with_rho If true, also averages the output density matrix, which
+    * takes O(D^2) memory per thread
+    */
+    template<typename Derived>
+    void run(const Eigen::MatrixBase<Derived>& psi, idx num_traj,
+             bool with_rho = false)
+    {
+        const dyn_mat<typename Derived::Scalar>& rpsi = psi.derived();
+        const std::vector<idx>& dims = qc_.get_dims();
+
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rpsi))
+            throw Exception("qpp::QTrajectoryEngine::run()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check column vector
+        if (!internal::check_cvector(rpsi))
+            throw Exception("qpp::QTrajectoryEngine::run()",
+                            Exception::Type::MATRIX_NOT_CVECTOR);
+
+        // check that dims match state vector
+        if (!internal::check_dims_match_cvect(dims, rpsi))
+            throw Exception("qpp::QTrajectoryEngine::run()",
+                            Exception::Type::DIMS_MISMATCH_CVECTOR);
+
+        // check the number of trajectories
+        if (num_traj == 0)
+            throw Exception("qpp::QTrajectoryEngine::run()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        idx D = static_cast<idx>(rpsi.rows());
+        idx numobs = observables_.size();
+        const std::vector<QCircuit::Step>& steps = qc_.get_steps();
+
+        // one random stream per trajectory
+        std::vector<std::mt19937::result_type> seeds(num_traj);
+        for (auto&& seed : seeds)
+            seed = RandomDevices::get_instance().rng_();
+
+        rho_ = with_rho ? cmat::Zero(D, D) : cmat{};
+        traj_results_.assign(num_traj, {});
+
+        // per-thread partial sums, combined once at the end
+        struct Sums
+        {
+            std::vector<cplx> expvals;
+            cmat rho;
+        };
+        Sums zero{std::vector<cplx>(numobs, 0),
+                  with_rho ? cmat::Zero(D, D) : cmat{}};
+
+        Sums sums = parallel_reduce(num_traj, zero, [&](idx t, Sums& partial)
+        {
+            std::mt19937 gen{seeds[t]};
+            ket state = rpsi;
+
+            for (auto&& segment : segments_)
+            {
+                if (segment.fused)
+                {
+                    fusions_[segment.pos].execute(state);
+                    continue;
+                }
+
+                const QCircuit::Step& step = steps[segment.pos];
+                idx result = sample_kraus_(step, state, gen);
+                if (step.type == QCircuit::Type::MEASUREMENT)
+                    traj_results_[t].push_back(result);
+            }
+
+            for (idx k = 0; k < numobs; ++k)
+            {
+                ket Astate = apply(state, observables_[k].A,
+                                   observables_[k].subsys, dims);
+                partial.expvals[k] += state.dot(Astate);
+            }
+            if (with_rho)
+                partial.rho.noalias() += state * adjoint(state);
+        }, [&](Sums& result, const Sums& partial)
+        {
+            for (idx k = 0; k < numobs; ++k)
+                result.expvals[k] += partial.expvals[k];
+            if (with_rho)
+                result.rho += partial.rho;
+        }, 1);
+
+        expvals_ = std::move(sums.expvals);
+        if (with_rho)
+            rho_ = std::move(sums.rho);
+        for (auto&& it : expvals_)
+            it /= static_cast<double>(num_traj);
+        if (with_rho)
+            rho_ /= static_cast<double>(num_traj);
+    }
+
+    /**
+    * \brief Expectation values of the registered observables, averaged over
+    * the trajectories of the last run
+    *
+    * \return Averaged expectation values, in the order of registration
+    */
+    const std::vector<cplx>& get_expvals() const noexcept
+    {
+        return expvals_;
+    }
+
+    /**
+    * \brief Output density matrix, averaged over the trajectories of the
+    * last run
+    *
+    * \return Averaged density matrix, empty if the last run was not asked
+    * to compute it
+    */
+    const cmat& get_rho() const noexcept
+    {
+        return rho_;
+    }
+
+    /**
+    * \brief Measurement results of each trajectory of the last run
+    *
+    * \return Measurement results, one vector per trajectory
+    */
+    const std::vector<std::vector<idx>>& get_traj_results() const noexcept
+    {
+        return traj_results_;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream the averaged expectation values of
+    * the last run
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        return os << disp(expvals_, " ");
+    }
+}; /* class QTrajectoryEngine */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_QTRAJECTORY_ENGINE_H_ */
@@ -0,0 +1,796 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/sparse_ket.h
+* \brief Sparse multi-partite state vector
+*/
+
+#ifndef CLASSES_SPARSE_KET_H_
+#define CLASSES_SPARSE_KET_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::SparseKet
+* \brief Multi-partite state vector that stores only its non-zero amplitudes
+* \see qpp::mket()
+*
+* The amplitudes are kept in a hash map, keyed by their index in the standard
+* lexicographical order. A gate is applied one non-zero amplitude at a time,
+* skipping the zero entries of the gate, so permutation and diagonal gates
+* preserve the number of non-zero amplitudes exactly, and a gate acting on
+* DA dimensions multiplies it by at most DA. Cost and memory scale with the
+* number of non-zero amplitudes, not with the total dimension.
+*
+* Amplitudes whose absolute value is at most the pruning threshold are
+* dropped after each operation. The default threshold, 0, only drops exact
+* zeros; use e.g. qpp::chop to also drop round-off residues.
+*
+* \note The total dimension must fit in qpp::idx, e.g. at most 64 qubits
+*/
+class SparseKet : public IDisplay
+{
+    std::vector<idx> dims_;              ///< dimensions of the system
+    idx D_;                              ///< total dimension
+    double chop_;                        ///< pruning threshold
+    std::unordered_map<idx, cplx> amps_; ///< non-zero amplitudes
+
+    /**
+    * \brief Constructs the zero vector, no checks
+    */
+    SparseKet(const std::vector<idx>& dims, double chop, idx D) :
+            dims_{dims}, D_{D}, chop_{chop}, amps_{}
+    {
+    }
+
+    /**
+    * \brief Total dimension of \a dims, throws if it does not fit in
+    * qpp::idx
+    */
+    static idx total_dim_(const std::vector<idx>& dims,
+                          const std::string& context)
+    {
+        // check that dimension is valid
+        if (!internal::check_dims(dims))
+            throw Exception(context, Exception::Type::DIMS_INVALID);
+
+        idx D = 1;
+        for (idx d : dims)
+        {
+            if (D > std::numeric_limits<idx>::max() / d)
+                throw Exception(context, Exception::Type::OUT_OF_RANGE);
+            D *= d;
+        }
+
+        return D;
+    }
+
+    /**
+    * \brief Removes the amplitudes of absolute value at most the pruning
+    * threshold
+    */
+    void prune_()
+    {
+        for (auto it = std::begin(amps_); it != std::end(amps_);)
+        {
+            if (std::abs(it->second) <= chop_)
+                it = amps_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+public:
+    /**
+    * \brief Constructs the computational basis state \f$|mask\rangle\f$
+    * \see qpp::mket()
+    *
+    * \param mask Multi-index of the basis state
+    * \param dims Dimensions of the multi-partite system
+    * \param chop Pruning threshold
+    */
+    SparseKet(const std::vector<idx>& mask, const std::vector<idx>& dims,
+              double chop = 0) :
+            dims_{dims}, D_{total_dim_(dims, "qpp::SparseKet::SparseKet()")},
+            chop_{chop}, amps_{}
+    {
+        // EXCEPTION CHECKS
+
+        // check equal sizes
+        if (mask.size() != dims.size())
+            throw Exception("qpp::SparseKet::SparseKet()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check mask is a valid multi-index
+        for (idx i = 0; i < mask.size(); ++i)
+            if (mask[i] >= dims[i])
+                throw Exception("qpp::SparseKet::SparseKet()",
+                                Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check the pruning threshold
+        if (chop < 0)
+            throw Exception("qpp::SparseKet::SparseKet()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        amps_[internal::multiidx2n(mask.data(), mask.size(), dims.data())] = 1;
+    }
+
+    /**
+    * \brief Constructs the sparse version of the multi-partite state
+    * vector \a psi
+    *
+    * \param psi Eigen expression
+    * \param dims Dimensions of the multi-partite system
+    * \param chop Pruning threshold, amplitudes of \a psi whose absolute value
+    * is at most \a chop are dropped
+    */
+    template<typename Derived>
+    SparseKet(const Eigen::MatrixBase<Derived>& psi,
+              const std::vector<idx>& dims, double chop = 0) :
+            dims_{dims}, D_{total_dim_(dims, "qpp::SparseKet::SparseKet()")},
+            chop_{chop}, amps_{}
+    {
+        const dyn_mat<typename Derived::Scalar>& rpsi = psi.derived();
+
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rpsi))
+            throw Exception("qpp::SparseKet::SparseKet()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check column vector
+        if (!internal::check_cvector(rpsi))
+            throw Exception("qpp::SparseKet::SparseKet()",
+                            Exception::Type::MATRIX_NOT_CVECTOR);
+
+        // check that dims match state vector
+        if (!internal::check_dims_match_cvect(dims, rpsi))
+            throw Exception("qpp::SparseKet::SparseKet()",
+                            Exception::Type::DIMS_MISMATCH_CVECTOR);
+
+        // check the pruning threshold
+        if (chop < 0)
+            throw Exception("qpp::SparseKet::SparseKet()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        for (idx i = 0; i < D_; ++i)
+            if (std::abs(rpsi(i)) > chop_)
+                amps_[i] = rpsi(i);
+    }
+
+    /**
+    * \brief Amplitude of the basis state of index \a i
+    *
+    * \param i Index in the standard lexicographical order
+    * \return Amplitude, 0 if it is not stored
+    */
+    cplx operator()(idx i) const
+    {
+        // EXCEPTION CHECKS
+
+        if (i >= D_)
+            throw Exception("qpp::SparseKet::operator()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        auto it = amps_.find(i);
+
+        return it == std::end(amps_) ? 0 : it->second;
+    }
+
+    /**
+    * \brief Amplitude of the basis state \f$|mask\rangle\f$
+    *
+    * \param mask Multi-index of the basis state
+    * \return Amplitude, 0 if it is not stored
+    */
+    cplx operator()(const std::vector<idx>& mask) const
+    {
+        // EXCEPTION CHECKS
+
+        if (mask.size() != dims_.size())
+            throw Exception("qpp::SparseKet::operator()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        for (idx i = 0; i < mask.size(); ++i)
+            if (mask[i] >= dims_[i])
+                throw Exception("qpp::SparseKet::operator()",
+                                Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        // no subsystems left, e.g. after measuring all of them
+        if (dims_.size() == 0)
+            return (*this)(0);
+
+        return (*this)(internal::multiidx2n(mask.data(), mask.size(),
+                                            dims_.data()));
+    }
+
+    /**
+    * \brief Applies in place the controlled-gate \a A to the part \a subsys
+    * \see qpp::applyCTRL(), qpp::Gates::CTRL()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys.
+    * Also, all control subsystems in \a ctrl must have the same dimension.
+    *
+    * \param A Eigen expression
+    * \param ctrl Control subsystem indexes
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    template<typename Derived>
+    SparseKet& applyCTRL(const Eigen::MatrixBase<Derived>& A,
+                         const std::vector<idx>& ctrl,
+                         const std::vector<idx>& subsys)
+    {
+        const cmat& rA = A.derived();
+
+        // EXCEPTION CHECKS
+
+        // check zero sizes
+        if (!internal::check_nonzero_size(rA))
+            throw Exception("qpp::SparseKet::applyCTRL()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix for the gate
+        if (!internal::check_square_mat(rA))
+            throw Exception("qpp::SparseKet::applyCTRL()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        // check ctrl is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(ctrl, dims_))
+            throw Exception("qpp::SparseKet::applyCTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that all control subsystems have the same dimension
+        idx d = ctrl.size() > 0 ? dims_[ctrl[0]] : 1;
+        for (idx i = 1; i < ctrl.size(); ++i)
+            if (dims_[ctrl[i]] != d)
+                throw Exception("qpp::SparseKet::applyCTRL()",
+                                Exception::Type::DIMS_NOT_EQUAL);
+
+        // check subsys is valid w.r.t. dims
+        if (!internal::check_subsys_match_dims(subsys, dims_))
+            throw Exception("qpp::SparseKet::applyCTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+        // check that gate matches the dimensions of the subsys
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+            subsys_dims[i] = dims_[subsys[i]];
+        if (!internal::check_dims_match_mat(subsys_dims, rA))
+            throw Exception("qpp::SparseKet::applyCTRL()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+
+        // check that ctrl + gate subsystem is valid
+        std::vector<idx> ctrlgate = ctrl;
+        ctrlgate.insert(std::end(ctrlgate), std::begin(subsys),
+                        std::end(subsys));
+        if (!internal::check_subsys_match_dims(ctrlgate, dims_))
+            throw Exception("qpp::SparseKet::applyCTRL()",
+                            Exception::Type::SUBSYS_MISMATCH_DIMS);
+        // END EXCEPTION CHECKS
+
+        idx N = dims_.size();
+        idx DA = static_cast<idx>(rA.rows());
+        idx Cstrides[maxn];
+        internal::dims2strides(dims_.data(), N, Cstrides);
+
+        // offsets of the gate multi-indexes
+        std::vector<idx> offsets(DA);
+        for (idx m = 0; m < DA; ++m)
+        {
+            idx CmidxA[maxn];
+            internal::n2multiidx(m, subsys.size(), subsys_dims.data(),
+                                 CmidxA);
+            offsets[m] = 0;
+            for (idx k = 0; k < subsys.size(); ++k)
+                offsets[m] += CmidxA[k] * Cstrides[subsys[k]];
+        }
+
+        // A^i is applied when all controls are in the state i; no control
+        // means A^1, powers equal to the identity are skipped
+        cmat Id = cmat::Identity(DA, DA);
+        std::vector<cmat> Apow(std::max(d, static_cast<idx>(2)), Id);
+        std::vector<bool> trivial(Apow.size(), true);
+        for (idx i = 1; i < Apow.size(); ++i)
+        {
+            Apow[i] = Apow[i - 1] * rA;
+            trivial[i] = (Apow[i] == Id);
+        }
+
+        std::unordered_map<idx, cplx> result;
+        result.reserve(amps_.size());
+        for (auto&& it : amps_)
+        {
+            idx i = it.first;
+
+            // control value, 0 if the controls differ
+            idx c = 1;
+            if (ctrl.size() > 0)
+            {
+                c = (i / Cstrides[ctrl[0]]) % d;
+                for (idx k = 1; k < ctrl.size(); ++k)
+                    if ((i / Cstrides[ctrl[k]]) % d != c)
+                    {
+                        c = 0;
+                        break;
+                    }
+            }
+            if (trivial[c])
+            {
+                result[i] += it.second;
+                continue;
+            }
+
+            // column of the gate and index of the first amplitude of the
+            // group
+            idx col = 0, base = i;
+            for (idx k = 0; k < subsys.size(); ++k)
+            {
+                idx digit = (i / Cstrides[subsys[k]]) % subsys_dims[k];
+                col = col * subsys_dims[k] + digit;
+                base -= digit * Cstrides[subsys[k]];
+            }
+
+            // zero entries of the gate are skipped, so permutations and
+            // diagonal gates do not create new amplitudes
+            const cmat& U = Apow[c];
+            for (idx m = 0; m < DA; ++m)
+                if (U(m, col) != 0.)
+                    result[base + offsets[m]] += U(m, col) * it.second;
+        }
+        amps_ = std::move(result);
+        prune_();
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies in place the gate \a A to the part \a subsys
+    * \see qpp::apply()
+    *
+    * \note The dimension of the gate \a A must match
+    * the dimension of \a subsys
+    *
+    * \param A Eigen expression
+    * \param subsys Subsystem indexes where the gate \a A is applied
+    * \return Reference to the current instance
+    */
+    template<typename Derived>
+    SparseKet& apply(const Eigen::MatrixBase<Derived>& A,
+                     const std::vector<idx>& subsys)
+    {
+        return applyCTRL(A, {}, subsys);
+    }
+
+    /**
+    * \brief Removes the amplitudes whose absolute value is at most \a chop,
+    * and sets \a chop as the pruning threshold of the subsequent operations
+    *
+    * \param chop Pruning threshold
+    * \return Reference to the current instance
+    */
+    SparseKet& prune(double chop = qpp::chop)
+    {
+        // EXCEPTION CHECKS
+
+        if (chop < 0)
+            throw Exception("qpp::SparseKet::prune()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        chop_ = chop;
+        prune_();
+
+        return *this;
+    }
+
+    /**
+    * \brief Inner product \f$\langle\phi|\psi\rangle\f$, where
+    * \f$|\phi\rangle\f$ is the current instance
+    * \see qpp::ip()
+    *
+    * \param psi Sparse state vector with the same dimensions
+    * \return Inner product
+    */
+    cplx dot(const SparseKet& psi) const
+    {
+        // EXCEPTION CHECKS
+
+        if (psi.dims_ != dims_)
+            throw Exception("qpp::SparseKet::dot()",
+                            Exception::Type::DIMS_NOT_EQUAL);
+        // END EXCEPTION CHECKS
+
+        // iterate over the smaller support
+        bool smaller = amps_.size() <= psi.amps_.size();
+        const std::unordered_map<idx, cplx>& small =
+                smaller ? amps_ : psi.amps_;
+        const std::unordered_map<idx, cplx>& large =
+                smaller ? psi.amps_ : amps_;
+
+        cplx result = 0;
+        for (auto&& it : small)
+        {
+            auto jt = large.find(it.first);
+            if (jt != std::end(large))
+                result += smaller ? std::conj(it.second) * jt->second
+                                  : std::conj(jt->second) * it.second;
+        }
+
+        return result;
+    }
+
+    /**
+    * \brief Euclidean norm
+    *
+    * \return Euclidean norm
+    */
+    double norm() const
+    {
+        double result = 0;
+        for (auto&& it : amps_)
+            result += std::norm(it.second);
+
+        return std::sqrt(result);
+    }
+
+    /**
+    * \brief Dense version of the state vector
+    *
+    * \note Allocates the full state vector
+    *
+    * \return Dense state vector
+    */
+    ket dense() const
+    {
+        ket result = ket::Zero(D_);
+        for (auto&& it : amps_)
+            result(it.first) = it.second;
+
+        return result;
+    }
+
+    /**
+    * \brief Dimensions of the multi-partite system
+    *
+    * \return Dimensions of the multi-partite system
+    */
+    const std::vector<idx>& get_dims() const noexcept
+    {
+        return dims_;
+    }
+
+    /**
+    * \brief Total dimension
+    *
+    * \return Total dimension
+    */
+    idx get_D() const noexcept
+    {
+        return D_;
+    }
+
+    /**
+    * \brief Pruning threshold
+    *
+    * \return Pruning threshold
+    */
+    double get_chop() const noexcept
+    {
+        return chop_;
+    }
+
+    /**
+    * \brief Number of stored (non-zero) amplitudes
+    *
+    * \return Number of stored amplitudes
+    */
+    idx get_nnz() const noexcept
+    {
+        return amps_.size();
+    }
+
+    /**
+    * \brief Stored amplitudes, keyed by their index in the standard
+    * lexicographical order
+    *
+    * \return Stored amplitudes
+    */
+    const std::unordered_map<idx, cplx>& get_amplitudes() const noexcept
+    {
+        return amps_;
+    }
+
+    friend std::tuple<std::vector<idx>, double, SparseKet>
+    measure_seq(const SparseKet& psi, std::vector<idx> subsys);
+
+    friend SparseKet ip(const SparseKet& phi, const SparseKet& psi,
+                        const std::vector<idx>& subsys);
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream one line per stored amplitude,
+    * in increasing order of the basis states
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        std::vector<idx> indexes;
+        indexes.reserve(amps_.size());
+        for (auto&& it : amps_)
+            indexes.push_back(it.first);
+        std::sort(std::begin(indexes), std::end(indexes));
+
+        std::vector<idx> midx(dims_.size());
+        bool first = true;
+        for (idx i : indexes)
+        {
+            if (!first)
+                os << '\n';
+            first = false;
+            internal::n2multiidx(i, dims_.size(), dims_.data(), midx.data());
+            os << disp(midx, "", "|", ">: ") << disp(amps_.at(i));
+        }
+
+        return os;
+    }
+}; /* class SparseKet */
+
+/**
+* \brief Applies the controlled-gate \a A to the part \a subsys
+* of the sparse multi-partite state vector \a psi
+* \see qpp::SparseKet::applyCTRL()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys.
+* Also, all control subsystems in \a ctrl must have the same dimension.
+*
+* \param psi Sparse state vector
+* \param A Eigen expression
+* \param ctrl Control subsystem indexes
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \return CTRL-A gate applied to the part \a subsys of \a psi
+*/
+template<typename Derived>
+SparseKet applyCTRL(const SparseKet& psi, const Eigen::MatrixBase<Derived>& A,
+                    const std::vector<idx>& ctrl,
+                    const std::vector<idx>& subsys)
+{
+    SparseKet result = psi;
+
+    return result.applyCTRL(A, ctrl, subsys);
+}
+
+/**
+* \brief Applies the gate \a A to the part \a subsys
+* of the sparse multi-partite state vector \a psi
+* \see qpp::SparseKet::apply()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param psi Sparse state vector
+* \param A Eigen expression
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \return Gate \a A applied to the part \a subsys of \a psi
+*/
+template<typename Derived>
+SparseKet apply(const SparseKet& psi, const Eigen::MatrixBase<Derived>& A,
+                const std::vector<idx>& subsys)
+{
+    SparseKet result = psi;
+
+    return result.apply(A, subsys);
+}
+
+/**
+* \brief Measures the part \a subsys of the sparse multi-partite state
+* vector \a psi in the computational basis
+* \see qpp::measure_seq()
+*
+* \note The measurement is destructive, i.e. the measured subsystems are
+* removed from the post-measurement state. The joint outcome is sampled at
+* once, from the amplitudes of \a psi, which is equivalent to measuring the
+* subsystems one after the other.
+*
+* \param psi Sparse state vector
+* \param subsys Subsystem indexes that are measured
+* \return Tuple of: 1. Vector of outcome results of the
+* measurement (ordered in increasing order with respect to \a subsys, i.e. first
+* measurement result corresponds to the subsystem with the smallest index), 2.
+* Outcome probability, and 3. Post-measurement normalized state
+*/
+inline std::tuple<std::vector<idx>, double, SparseKet>
+measure_seq(const SparseKet& psi, std::vector<idx> subsys)
+{
+    // EXCEPTION CHECKS
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, psi.dims_))
+        throw Exception("qpp::measure_seq()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+    // check zero state
+    if (psi.amps_.size() == 0)
+        throw Exception("qpp::measure_seq()", Exception::Type::ZERO_SIZE);
+    // END EXCEPTION CHECKS
+
+    std::sort(std::begin(subsys), std::end(subsys));
+
+    idx N = psi.dims_.size();
+    idx Cstrides[maxn];
+    internal::dims2strides(psi.dims_.data(), N, Cstrides);
+
+    // dimensions of the rest
+    std::vector<bool> measured(N, false);
+    for (idx i : subsys)
+        measured[i] = true;
+    std::vector<idx> dims_bar;
+    idx D_bar = 1;
+    for (idx i = 0; i < N; ++i)
+        if (!measured[i])
+        {
+            dims_bar.push_back(psi.dims_[i]);
+            D_bar *= psi.dims_[i];
+        }
+
+    // splits a basis index into the measured and the rest indexes
+    auto split = [&](idx i, idx& sub, idx& rest)
+    {
+        sub = 0;
+        rest = 0;
+        for (idx k = 0; k < N; ++k)
+        {
+            idx digit = (i / Cstrides[k]) % psi.dims_[k];
+            if (measured[k])
+                sub = sub * psi.dims_[k] + digit;
+            else
+                rest = rest * psi.dims_[k] + digit;
+        }
+    };
+
+    // probabilities of the outcomes with non-zero probability, ordered
+    std::map<idx, double> probs;
+    for (auto&& it : psi.amps_)
+    {
+        idx sub, rest;
+        split(it.first, sub, rest);
+        probs[sub] += std::norm(it.second);
+    }
+
+    std::vector<idx> outcomes;
+    std::vector<double> weights;
+    for (auto&& it : probs)
+    {
+        outcomes.push_back(it.first);
+        weights.push_back(it.second);
+    }
+    std::discrete_distribution<idx> dd(std::begin(weights),
+                                       std::end(weights));
+    idx pos = dd(RandomDevices::get_instance().rng_);
+    idx outcome = outcomes[pos];
+    double norm2 = 0;
+    for (double w : weights)
+        norm2 += w;
+    double prob = weights[pos] / norm2;
+
+    // post-measurement state on the rest
+    SparseKet result(dims_bar, psi.chop_, D_bar);
+    double scale = std::sqrt(weights[pos]);
+    for (auto&& it : psi.amps_)
+    {
+        idx sub, rest;
+        split(it.first, sub, rest);
+        if (sub == outcome)
+            result.amps_[rest] = it.second / scale;
+    }
+
+    std::vector<idx> subsys_dims(subsys.size());
+    for (idx k = 0; k < subsys.size(); ++k)
+        subsys_dims[k] = psi.dims_[subsys[k]];
+    std::vector<idx> results(subsys.size());
+    internal::n2multiidx(outcome, subsys.size(), subsys_dims.data(),
+                         results.data());
+
+    return std::make_tuple(results, prob, result);
+}
+
+/**
+* \brief Generalized inner product of sparse state vectors
+* \see qpp::ip()
+*
+* \param phi Sparse state vector on the part \a subsys
+* \param psi Sparse multi-partite state vector
+* \param subsys Subsystem indexes over which \a phi is defined
+* \return Inner product \f$\langle \phi_{subsys}|\psi\rangle\f$, as a sparse
+* state vector on the complement of \a subsys
+*/
+inline SparseKet ip(const SparseKet& phi, const SparseKet& psi,
+                    const std::vector<idx>& subsys)
+{
+    // EXCEPTION CHECKS
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, psi.dims_))
+        throw Exception("qpp::ip()", Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+    // check that phi lives on subsys
+    std::vector<idx> subsys_dims(subsys.size());
+    for (idx k = 0; k < subsys.size(); ++k)
+        subsys_dims[k] = psi.dims_[subsys[k]];
+    if (phi.dims_ != subsys_dims)
+        throw Exception("qpp::ip()", Exception::Type::DIMS_MISMATCH_CVECTOR);
+    // END EXCEPTION CHECKS
+
+    idx N = psi.dims_.size();
+    idx Cstrides[maxn];
+    internal::dims2strides(psi.dims_.data(), N, Cstrides);
+
+    std::vector<bool> is_subsys(N, false);
+    for (idx i : subsys)
+        is_subsys[i] = true;
+    std::vector<idx> dims_bar;
+    idx D_bar = 1;
+    for (idx i = 0; i < N; ++i)
+        if (!is_subsys[i])
+        {
+            dims_bar.push_back(psi.dims_[i]);
+            D_bar *= psi.dims_[i];
+        }
+
+    // the digits of phi follow the order of subsys
+    idx Cstrides_subsys[maxn];
+    internal::dims2strides(subsys_dims.data(), subsys.size(),
+                           Cstrides_subsys);
+
+    SparseKet result(dims_bar, psi.chop_, D_bar);
+    for (auto&& it : psi.amps_)
+    {
+        idx sub = 0, rest = 0;
+        for (idx k = 0; k < subsys.size(); ++k)
+            sub += ((it.first / Cstrides[subsys[k]]) % subsys_dims[k])
+                   * Cstrides_subsys[k];
+        for (idx k = 0; k < N; ++k)
+            if (!is_subsys[k])
+                rest = rest * psi.dims_[k]
+                       + (it.first / Cstrides[k]) % psi.dims_[k];
+
+        auto jt = phi.amps_.find(sub);
+        if (jt != std::end(phi.amps_))
+            result.amps_[rest] += std::conj(jt->second) * it.second;
+    }
+    result.prune_();
+
+    return result;
+}
+
+} /* namespace qpp */
+
+#endif /* CLASSES_SPARSE_KET_H_ */
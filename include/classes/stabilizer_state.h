@@ -0,0 +1,638 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file classes/stabilizer_state.h
+* \brief Stabilizer state of n qubits, in the tableau representation
+*/
+
+#ifndef CLASSES_STABILIZER_STATE_H_
+#define CLASSES_STABILIZER_STATE_H_
+
+namespace qpp
+{
+
+/**
+* \class qpp::StabilizerState
+* \brief Stabilizer state of n qubits, evolved by Clifford gates and
+* computational basis measurements
+*
+* Implements the tableau algorithm of S. Aaronson and D. Gottesman, Phys.
+* Rev. A 70, 052328 (2004). The state is described by n destabilizer and n
+* stabilizer Pauli operators, i.e. 2n rows of 2n bits plus a sign bit.
+*
+* The tableau is stored bit-packed by columns: for each qubit, the X bits,
+* then the Z bits, of all the rows are packed in 64-bit words. A gate then
+* updates one or two columns, i.e. O(n/64) words, and a measurement with a
+* random outcome multiplies all the rows anti-commuting with
+* \f$Z_j\f$ by one row at once, in O(n^2/64) operations. A measurement with
+* a deterministic outcome takes O(n^2) bit operations.
+*
+* \note The qubits are indexed as in the rest of the library, i.e. qubit 0
+* is the most significant one in qpp::StabilizerState::to_ket()
+*/
+class StabilizerState : public IDisplay
+{
+    idx n_;                           ///< number of qubits
+    idx W_;                           ///< number of words per column
+    std::vector<std::uint64_t> x_;    ///< X bits, column-major
+    std::vector<std::uint64_t> z_;    ///< Z bits, column-major
+    std::vector<std::uint64_t> r_;    ///< sign bits
+
+    /**
+    * \brief Bit of the row \a i in the column \a j of \a v
+    */
+    bool get_(const std::vector<std::uint64_t>& v, idx j, idx i) const
+    {
+        return (v[j * W_ + i / 64] >> (i % 64)) & 1;
+    }
+
+    /**
+    * \brief Sets to \a b the bit of the row \a i in the column \a j of \a v
+    */
+    void set_(std::vector<std::uint64_t>& v, idx j, idx i, bool b)
+    {
+        std::uint64_t mask = static_cast<std::uint64_t>(1) << (i % 64);
+        if (b)
+            v[j * W_ + i / 64] |= mask;
+        else
+            v[j * W_ + i / 64] &= ~mask;
+    }
+
+    /**
+    * \brief Exponent of \a i in the product of the single-qubit Pauli
+    * operators encoded by \a x1 \a z1 and by \a x2 \a z2
+    */
+    static int g_(bool x1, bool z1, bool x2, bool z2)
+    {
+        if (x1 && z1) // Y
+            return static_cast<int>(z2) - static_cast<int>(x2);
+        if (x1) // X
+            return z2 ? 2 * static_cast<int>(x2) - 1 : 0;
+        if (z1) // Z
+            return x2 ? 1 - 2 * static_cast<int>(z2) : 0;
+
+        return 0;
+    }
+
+    /**
+    * \brief Checks that the qubits \a qubits are distinct and in range,
+    * throws otherwise
+    */
+    void check_qubits_(const std::vector<idx>& qubits,
+                       const std::string& context) const
+    {
+        for (idx i = 0; i < qubits.size(); ++i)
+        {
+            if (qubits[i] >= n_)
+                throw Exception(context, Exception::Type::OUT_OF_RANGE);
+            for (idx k = 0; k < i; ++k)
+                if (qubits[k] == qubits[i])
+                    throw Exception(context,
+                                    Exception::Type::SUBSYS_MISMATCH_DIMS);
+        }
+    }
+
+    /**
+    * \brief Measures the qubit \a j in the computational basis, no checks
+    *
+    * \param j Qubit index
+    * \param outcome Outcome used when the result is random
+    * \return Result of the measurement
+    */
+    idx measure_(idx j, bool outcome)
+    {
+        // first stabilizer anti-commuting with Z_j
+        idx p = 2 * n_;
+        for (idx i = n_; i < 2 * n_; ++i)
+            if (get_(x_, j, i))
+            {
+                p = i;
+                break;
+            }
+
+        //************ deterministic outcome ************//
+        if (p == 2 * n_)
+        {
+            // product of the stabilizers whose destabilizers anti-commute
+            // with Z_j, accumulated in a scratch row
+            std::vector<bool> sx(n_, false), sz(n_, false);
+            int exponent = 0; // power of i, mod 4
+            for (idx i = 0; i < n_; ++i)
+            {
+                if (!get_(x_, j, i))
+                    continue;
+                idx s = i + n_;
+                exponent += 2 * static_cast<int>(get_(r_, 0, s));
+                for (idx k = 0; k < n_; ++k)
+                {
+                    bool x1 = get_(x_, k, s), z1 = get_(z_, k, s);
+                    exponent += g_(x1, z1, sx[k], sz[k]);
+                    sx[k] = sx[k] != x1;
+                    sz[k] = sz[k] != z1;
+                }
+                exponent = ((exponent % 4) + 4) % 4;
+            }
+
+            return exponent == 2 ? 1 : 0;
+        }
+
+        //************ random outcome ************//
+        // rows to be multiplied by the row p, i.e. all the other rows that
+        // anti-commute with Z_j
+        std::vector<std::uint64_t> rows(std::begin(x_) + j * W_,
+                                        std::begin(x_) + (j + 1) * W_);
+        rows[p / 64] &= ~(static_cast<std::uint64_t>(1) << (p % 64));
+        bool rp = get_(r_, 0, p);
+
+        // exponent of i of each row product, mod 4, in two bit-planes
+        std::vector<std::uint64_t> c0(W_, 0), c1(W_, 0);
+        for (idx k = 0; k < n_; ++k)
+        {
+            bool x1 = get_(x_, k, p), z1 = get_(z_, k, p);
+            if (!x1 && !z1)
+                continue;
+            std::uint64_t* xk = &x_[k * W_];
+            std::uint64_t* zk = &z_[k * W_];
+            for (idx w = 0; w < W_; ++w)
+            {
+                std::uint64_t plus, minus;
+                if (x1 && z1) // Y
+                {
+                    plus = ~xk[w] & zk[w];
+                    minus = xk[w] & ~zk[w];
+                } else if (x1) // X
+                {
+                    plus = xk[w] & zk[w];
+                    minus = ~xk[w] & zk[w];
+                } else // Z
+                {
+                    plus = xk[w] & ~zk[w];
+                    minus = xk[w] & zk[w];
+                }
+                plus &= rows[w];
+                minus &= rows[w];
+
+                std::uint64_t carry = c0[w] & plus;
+                c0[w] ^= plus;
+                c1[w] ^= carry;
+                std::uint64_t borrow = ~c0[w] & minus;
+                c0[w] ^= minus;
+                c1[w] ^= borrow;
+
+                if (x1)
+                    xk[w] ^= rows[w];
+                if (z1)
+                    zk[w] ^= rows[w];
+            }
+        }
+        // the exponents are even, the new sign is r_h + r_p + exponent / 2
+        for (idx w = 0; w < W_; ++w)
+            r_[w] ^= rows[w] & (rp ? ~c1[w] : c1[w]);
+
+        // the destabilizer p - n becomes the row p, and the row p becomes
+        // (-1)^outcome Z_j
+        for (idx k = 0; k < n_; ++k)
+        {
+            set_(x_, k, p - n_, get_(x_, k, p));
+            set_(z_, k, p - n_, get_(z_, k, p));
+            set_(x_, k, p, false);
+            set_(z_, k, p, false);
+        }
+        set_(r_, 0, p - n_, rp);
+        set_(z_, j, p, true);
+        set_(r_, 0, p, outcome);
+
+        return outcome ? 1 : 0;
+    }
+
+public:
+    /**
+    * \brief Constructs the state \f$|0\rangle^{\otimes n}\f$
+    *
+    * \param n Number of qubits
+    */
+    explicit StabilizerState(idx n) :
+            n_{n}, W_{(2 * n + 63) / 64}, x_{}, z_{}, r_{}
+    {
+        // EXCEPTION CHECKS
+
+        // check the number of qubits
+        if (n == 0)
+            throw Exception("qpp::StabilizerState::StabilizerState()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        x_.assign(n_ * W_, 0);
+        z_.assign(n_ * W_, 0);
+        r_.assign(W_, 0);
+
+        // destabilizers X_i, stabilizers Z_i
+        for (idx i = 0; i < n_; ++i)
+        {
+            set_(x_, i, i, true);
+            set_(z_, i, i + n_, true);
+        }
+    }
+
+    /**
+    * \brief Applies the Hadamard gate to the qubit \a j
+    *
+    * \param j Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& H(idx j)
+    {
+        check_qubits_({j}, "qpp::StabilizerState::H()");
+
+        std::uint64_t* xj = &x_[j * W_];
+        std::uint64_t* zj = &z_[j * W_];
+        for (idx w = 0; w < W_; ++w)
+        {
+            r_[w] ^= xj[w] & zj[w];
+            std::swap(xj[w], zj[w]);
+        }
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the phase gate \f$S = \mathrm{diag}(1, i)\f$ to the
+    * qubit \a j
+    *
+    * \param j Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& S(idx j)
+    {
+        check_qubits_({j}, "qpp::StabilizerState::S()");
+
+        std::uint64_t* xj = &x_[j * W_];
+        std::uint64_t* zj = &z_[j * W_];
+        for (idx w = 0; w < W_; ++w)
+        {
+            r_[w] ^= xj[w] & zj[w];
+            zj[w] ^= xj[w];
+        }
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the Pauli \f$X\f$ gate to the qubit \a j
+    *
+    * \param j Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& X(idx j)
+    {
+        check_qubits_({j}, "qpp::StabilizerState::X()");
+
+        for (idx w = 0; w < W_; ++w)
+            r_[w] ^= z_[j * W_ + w];
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the Pauli \f$Y\f$ gate to the qubit \a j
+    *
+    * \param j Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& Y(idx j)
+    {
+        check_qubits_({j}, "qpp::StabilizerState::Y()");
+
+        for (idx w = 0; w < W_; ++w)
+            r_[w] ^= x_[j * W_ + w] ^ z_[j * W_ + w];
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the Pauli \f$Z\f$ gate to the qubit \a j
+    *
+    * \param j Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& Z(idx j)
+    {
+        check_qubits_({j}, "qpp::StabilizerState::Z()");
+
+        for (idx w = 0; w < W_; ++w)
+            r_[w] ^= x_[j * W_ + w];
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the controlled-NOT gate
+    *
+    * \param ctrl Control qubit index
+    * \param target Target qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& CNOT(idx ctrl, idx target)
+    {
+        check_qubits_({ctrl, target}, "qpp::StabilizerState::CNOT()");
+
+        std::uint64_t* xa = &x_[ctrl * W_];
+        std::uint64_t* za = &z_[ctrl * W_];
+        std::uint64_t* xb = &x_[target * W_];
+        std::uint64_t* zb = &z_[target * W_];
+        for (idx w = 0; w < W_; ++w)
+        {
+            r_[w] ^= xa[w] & zb[w] & ~(xb[w] ^ za[w]);
+            xb[w] ^= xa[w];
+            za[w] ^= zb[w];
+        }
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the controlled-phase gate
+    *
+    * \param a Qubit index
+    * \param b Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& CZ(idx a, idx b)
+    {
+        check_qubits_({a, b}, "qpp::StabilizerState::CZ()");
+
+        std::uint64_t* xa = &x_[a * W_];
+        std::uint64_t* za = &z_[a * W_];
+        std::uint64_t* xb = &x_[b * W_];
+        std::uint64_t* zb = &z_[b * W_];
+        for (idx w = 0; w < W_; ++w)
+        {
+            r_[w] ^= xa[w] & xb[w] & (za[w] ^ zb[w]);
+            za[w] ^= xb[w];
+            zb[w] ^= xa[w];
+        }
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the SWAP gate
+    *
+    * \param a Qubit index
+    * \param b Qubit index
+    * \return Reference to the current instance
+    */
+    StabilizerState& SWAP(idx a, idx b)
+    {
+        check_qubits_({a, b}, "qpp::StabilizerState::SWAP()");
+
+        for (idx w = 0; w < W_; ++w)
+        {
+            std::swap(x_[a * W_ + w], x_[b * W_ + w]);
+            std::swap(z_[a * W_ + w], z_[b * W_ + w]);
+        }
+
+        return *this;
+    }
+
+    /**
+    * \brief Applies the gate \a U to the part \a subsys
+    *
+    * \note \a U must be, up to a global phase, one of the gates
+    * qpp::Gates::Id2, qpp::Gates::X, qpp::Gates::Y, qpp::Gates::Z,
+    * qpp::Gates::H, qpp::Gates::S or its adjoint acting on one qubit, or
+    * qpp::Gates::CNOT, qpp::Gates::CZ or qpp::Gates::SWAP acting on two qubits
+    *
+    * \param U Clifford gate
+    * \param subsys Subsystem indexes where the gate \a U is applied
+    * \return Reference to the current instance
+    */
+    StabilizerState& apply(const cmat& U, const std::vector<idx>& subsys)
+    {
+        // EXCEPTION CHECKS
+
+        // check zero size
+        if (!internal::check_nonzero_size(U))
+            throw Exception("qpp::StabilizerState::apply()",
+                            Exception::Type::ZERO_SIZE);
+
+        // check square matrix
+        if (!internal::check_square_mat(U))
+            throw Exception("qpp::StabilizerState::apply()",
+                            Exception::Type::MATRIX_NOT_SQUARE);
+
+        check_qubits_(subsys, "qpp::StabilizerState::apply()");
+
+        // check that the gate matches the subsystems
+        if (subsys.size() == 0 || subsys.size() > 2 ||
+            static_cast<idx>(U.rows()) != (subsys.size() == 1 ? 2 : 4))
+            throw Exception("qpp::StabilizerState::apply()",
+                            Exception::Type::MATRIX_MISMATCH_SUBSYS);
+        // END EXCEPTION CHECKS
+
+        const Gates& gates = Gates::get_instance();
+        // equal up to a global phase, i.e. U = c G with |c| = 1, where
+        // c = tr(G^dagger U) / dim is the best fitting phase
+        auto equal = [&U](const cmat& G) -> bool
+        {
+            cplx c = trace(adjoint(G) * U) / static_cast<double>(G.rows());
+            if (std::abs(std::abs(c) - 1) >= eps)
+                return false;
+            return norm(U - c * G) < eps;
+        };
+
+        if (subsys.size() == 1)
+        {
+            idx j = subsys[0];
+            if (equal(gates.Id2))
+                return *this;
+            if (equal(gates.X))
+                return X(j);
+            if (equal(gates.Y))
+                return Y(j);
+            if (equal(gates.Z))
+                return Z(j);
+            if (equal(gates.H))
+                return H(j);
+            if (equal(gates.S))
+                return S(j);
+            if (equal(adjoint(gates.S)))
+                return S(j).S(j).S(j);
+        } else
+        {
+            if (equal(gates.CNOT))
+                return CNOT(subsys[0], subsys[1]);
+            if (equal(gates.CZ))
+                return CZ(subsys[0], subsys[1]);
+            if (equal(gates.SWAP))
+                return SWAP(subsys[0], subsys[1]);
+        }
+
+        throw Exception("qpp::StabilizerState::apply()",
+                        "Not a supported Clifford gate!");
+    }
+
+    /**
+    * \brief Measures the qubit \a j in the computational basis
+    *
+    * \note The measurement is non-destructive, i.e. the qubit \a j is
+    * left in the basis state given by the result. A random result is
+    * sampled using qpp::RandomDevices.
+    *
+    * \param j Qubit index
+    * \return Result of the measurement, 0 or 1
+    */
+    idx measure(idx j)
+    {
+        check_qubits_({j}, "qpp::StabilizerState::measure()");
+
+        std::bernoulli_distribution bd{0.5};
+
+        return measure_(j, bd(RandomDevices::get_instance().rng_));
+    }
+
+    /**
+    * \brief Sequentially measures the qubits \a subsys in the computational
+    * basis
+    * \see qpp::StabilizerState::measure()
+    *
+    * \param subsys Qubit indexes that are measured
+    * \return Results of the measurements, in the order of \a subsys
+    */
+    std::vector<idx> measure_seq(const std::vector<idx>& subsys)
+    {
+        check_qubits_(subsys, "qpp::StabilizerState::measure_seq()");
+
+        std::vector<idx> result;
+        result.reserve(subsys.size());
+        std::bernoulli_distribution bd{0.5};
+        for (idx j : subsys)
+            result.push_back(
+                    measure_(j, bd(RandomDevices::get_instance().rng_)));
+
+        return result;
+    }
+
+    /**
+    * \brief Dense state vector
+    *
+    * \note The global phase is fixed by the amplitude of the first
+    * computational basis state in the support of the state, which is real
+    * and positive. Takes O(n 2^n) time and O(2^n) memory.
+    *
+    * \return State vector of dimension \f$2^n\f$
+    */
+    ket to_ket() const
+    {
+        // EXCEPTION CHECKS
+
+        // check that the dimension fits in an idx
+        if (n_ >= static_cast<idx>(std::numeric_limits<idx>::digits))
+            throw Exception("qpp::StabilizerState::to_ket()",
+                            Exception::Type::OUT_OF_RANGE);
+        // END EXCEPTION CHECKS
+
+        idx D = static_cast<idx>(1) << n_;
+
+        // a basis state in the support, measuring 0 whenever random
+        StabilizerState copy{*this};
+        idx b = 0;
+        for (idx j = 0; j < n_; ++j)
+            b = 2 * b + copy.measure_(j, false);
+
+        // projects onto the +1 eigenspace of each stabilizer
+        ket psi = ket::Zero(D);
+        psi(b) = 1;
+        for (idx i = n_; i < 2 * n_; ++i)
+        {
+            idx xmask = 0, zmask = 0, numY = 0;
+            for (idx k = 0; k < n_; ++k)
+            {
+                bool xk = get_(x_, k, i), zk = get_(z_, k, i);
+                idx bit = static_cast<idx>(1) << (n_ - 1 - k);
+                if (xk)
+                    xmask |= bit;
+                if (zk)
+                    zmask |= bit;
+                if (xk && zk)
+                    ++numY;
+            }
+            // sign times i^(number of Y's)
+            cplx phase = std::pow(1_i, static_cast<double>(numY));
+            if (get_(r_, 0, i))
+                phase = -phase;
+
+            ket gpsi = ket::Zero(D);
+            for (idx k = 0; k < D; ++k)
+            {
+                if (psi(k) == 0.)
+                    continue;
+                idx parity = 0;
+                for (idx m = k & zmask; m != 0; m &= m - 1)
+                    parity ^= 1;
+                gpsi(k ^ xmask) += (parity ? -phase : phase) * psi(k);
+            }
+            psi = (psi + gpsi) / 2.;
+        }
+
+        return psi / psi.norm();
+    }
+
+    /**
+    * \brief Number of qubits
+    *
+    * \return Number of qubits
+    */
+    idx get_n() const noexcept
+    {
+        return n_;
+    }
+
+private:
+    /**
+    * \brief qpp::IDisplay::display() override
+    *
+    * \param os Output stream
+    * \return Writes to the output stream the stabilizer generators, one per
+    * line, e.g. +XZI
+    */
+    std::ostream& display(std::ostream& os) const override
+    {
+        for (idx i = n_; i < 2 * n_; ++i)
+        {
+            if (i > n_)
+                os << '\n';
+            os << (get_(r_, 0, i) ? '-' : '+');
+            for (idx k = 0; k < n_; ++k)
+            {
+                bool xk = get_(x_, k, i), zk = get_(z_, k, i);
+                os << (xk ? (zk ? 'Y' : 'X') : (zk ? 'Z' : 'I'));
+            }
+        }
+
+        return os;
+    }
+}; /* class StabilizerState */
+
+} /* namespace qpp */
+
+#endif /* CLASSES_STABILIZER_STATE_H_ */
@@ -868,13 +868,12 @@ dyn_mat <OutputScalar> cwise(const Eigen::MatrixBase<Derived>& A,
 
     dyn_mat<OutputScalar> result(rA.rows(), rA.cols());
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
     // column major order for speed
-    for (idx j = 0; j < static_cast<idx>(rA.cols()); ++j)
-        for (idx i = 0; i < static_cast<idx>(rA.rows()); ++i)
-            result(i, j) = (*f)(rA(i, j));
+    parallel_for(static_cast<idx>(rA.cols()), static_cast<idx>(rA.rows()),
+                 [&](idx j, idx i)
+                 {
+                     result(i, j) = (*f)(rA(i, j));
+                 });
 
     return result;
 }
@@ -1487,7 +1486,7 @@ inline ket mket(const std::vector<idx>& mask,
                             Exception::Type::SUBSYS_MISMATCH_DIMS);
     // END EXCEPTION CHECKS
 
-    ket result = ket::Zero(D);
+    ket result = internal::numa_zero<ket>(D, 1);
     idx pos = multiidx2n(mask, dims);
     result(pos) = 1;
 
@@ -1528,7 +1527,7 @@ inline ket mket(const std::vector<idx>& mask, idx d = 2)
                             Exception::Type::SUBSYS_MISMATCH_DIMS);
     // END EXCEPTION CHECKS
 
-    ket result = ket::Zero(D);
+    ket result = internal::numa_zero<ket>(D, 1);
     std::vector<idx> dims(N, d);
     idx pos = multiidx2n(mask, dims);
     result(pos) = 1;
@@ -1576,7 +1575,7 @@ inline cmat mprj(const std::vector<idx>& mask,
                             Exception::Type::SUBSYS_MISMATCH_DIMS);
     // END EXCEPTION CHECKS
 
-    cmat result = cmat::Zero(D, D);
+    cmat result = internal::numa_zero<cmat>(D, D);
     idx pos = multiidx2n(mask, dims);
     result(pos, pos) = 1;
 
@@ -1619,7 +1618,7 @@ inline cmat mprj(const std::vector<idx>& mask, idx d = 2)
                             Exception::Type::SUBSYS_MISMATCH_DIMS);
     // END EXCEPTION CHECKS
 
-    cmat result = cmat::Zero(D, D);
+    cmat result = internal::numa_zero<cmat>(D, D);
     std::vector<idx> dims(N, d);
     idx pos = multiidx2n(mask, dims);
     result(pos, pos) = 1;
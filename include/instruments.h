@@ -30,6 +30,143 @@
 // instruments
 namespace qpp
 {
+
+namespace internal
+{
+
+// reduced density matrix of the part subsys of the state vector or density
+// matrix A, with the subsystems in the order of subsys; the probabilities of
+// the outcomes of a measurement of subsys follow from it, without
+// constructing the post-measurement states
+template<typename Derived>
+dyn_mat<typename Derived::Scalar> reduced_state(
+        const Eigen::MatrixBase<Derived>& A,
+        const std::vector<idx>& subsys,
+        const std::vector<idx>& dims)
+{
+    // no error checks, done by the callers
+    std::vector<idx> subsys_sorted = subsys;
+    std::sort(std::begin(subsys_sorted), std::end(subsys_sorted));
+
+    dyn_mat<typename Derived::Scalar> result =
+            ptrace(A, complement(subsys_sorted, dims.size()), dims);
+
+    // back to the order of subsys
+    if (!std::is_sorted(std::begin(subsys), std::end(subsys)))
+    {
+        std::vector<idx> perm(subsys.size());
+        std::vector<idx> subsys_dims(subsys.size());
+        for (idx i = 0; i < subsys.size(); ++i)
+        {
+            perm[i] = static_cast<idx>(
+                    std::lower_bound(std::begin(subsys_sorted),
+                                     std::end(subsys_sorted), subsys[i])
+                    - std::begin(subsys_sorted));
+            subsys_dims[i] = dims[subsys_sorted[i]];
+        }
+        result = syspermute(result, perm, subsys_dims);
+    }
+
+    return result;
+}
+
+// collapses in place the state vector or density matrix A onto the outcome
+// m of a computational-basis measurement of subsys, of probability p, i.e.
+// keeps and rescales the entries of the outcome and zeroes the rest
+template<typename Derived>
+void collapse_inplace(Eigen::MatrixBase<Derived>& A, idx m, double p,
+                      const std::vector<idx>& subsys,
+                      const std::vector<idx>& dims)
+{
+    // no error checks, done by the callers
+    Derived& rA = A.derived();
+    idx D = static_cast<idx>(rA.rows());
+
+    //************ ket ************//
+    if (rA.cols() == 1)
+    {
+        typename Derived::Scalar scale =
+                static_cast<typename Derived::Scalar>(1 / std::sqrt(p));
+        parallel_chunks(D, [&](idx begin, idx end)
+        {
+            SubsysIndex k(subsys, dims, begin);
+            for (idx i = begin; i < end; ++i, ++k)
+            {
+                if (k() == m)
+                    rA(i) *= scale;
+                else
+                    rA(i) = 0;
+            }
+        });
+        return;
+    }
+
+    //************ density matrix ************//
+    std::vector<char> keep(D);
+    parallel_chunks(D, [&](idx begin, idx end)
+    {
+        SubsysIndex k(subsys, dims, begin);
+        for (idx i = begin; i < end; ++i, ++k)
+            keep[i] = k() == m;
+    });
+    typename Derived::Scalar scale =
+            static_cast<typename Derived::Scalar>(1 / p);
+    parallel_for(D, [&](idx j)
+    {
+        for (idx i = 0; i < D; ++i)
+        {
+            if (keep[i] && keep[j])
+                rA(i, j) *= scale;
+            else
+                rA(i, j) = 0;
+        }
+    }, std::max<idx>(1, parallel_config().grain / D));
+}
+
+} /* namespace internal */
+
+/**
+* \brief Inner products of two batches of state vectors
+* \see qpp::ip()
+*
+* \note The Gram matrix of a batch \a Psis is overlaps(Psis, Psis)
+*
+* \param Phis Eigen expression, matrix whose columns are state vectors
+* \param Psis Eigen expression, matrix whose columns are state vectors
+* \return Matrix of inner products
+* \f$\langle \phi_i|\psi_j\rangle\f$, computed as a single matrix product
+*/
+template<typename Derived1, typename Derived2>
+dyn_mat<typename Derived1::Scalar> overlaps(
+        const Eigen::MatrixBase<Derived1>& Phis,
+        const Eigen::MatrixBase<Derived2>& Psis)
+{
+    const dyn_mat<typename Derived1::Scalar>& rPhis = Phis.derived();
+    const dyn_mat<typename Derived2::Scalar>& rPsis = Psis.derived();
+
+    // EXCEPTION CHECKS
+
+    // check types
+    if (!std::is_same<typename Derived1::Scalar,
+            typename Derived2::Scalar>::value)
+        throw Exception("qpp::overlaps()", Exception::Type::TYPE_MISMATCH);
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rPhis))
+        throw Exception("qpp::overlaps()", Exception::Type::ZERO_SIZE);
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rPsis))
+        throw Exception("qpp::overlaps()", Exception::Type::ZERO_SIZE);
+
+    // check equal dimensions
+    if (rPhis.rows() != rPsis.rows())
+        throw Exception("qpp::overlaps()", Exception::Type::DIMS_NOT_EQUAL);
+    // END EXCEPTION CHECKS
+
+    return rPhis.adjoint() * rPsis;
+}
+
 /**
 * \brief Generalized inner product
 *
@@ -163,11 +300,10 @@ dyn_col_vect<typename Derived::Scalar> ip(
     }; /* end worker */
 
     dyn_col_vect<typename Derived::Scalar> result(Dsubsys_bar);
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-    for (idx m = 0; m < Dsubsys_bar; ++m)
+    parallel_for(Dsubsys_bar, [&](idx m)
+    {
         result(m) = worker(m);
+    });
 
     return result;
 }
@@ -218,8 +354,10 @@ dyn_col_vect<typename Derived::Scalar> ip(
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
-measure(const Eigen::MatrixBase<Derived>& A, const std::vector<cmat>& Ks)
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
+measure(const Eigen::MatrixBase<Derived>& A,
+        const std::vector<dyn_mat<typename Derived::Scalar>>& Ks)
 {
     const dyn_mat<typename Derived::Scalar>& rA = A.derived();
 
@@ -245,18 +383,22 @@ measure(const Eigen::MatrixBase<Derived>& A, const std::vector<cmat>& Ks)
     // probabilities
     std::vector<double> prob(Ks.size());
     // resulting states
-    std::vector<cmat> outstates(Ks.size());
+    std::vector<dyn_mat<typename Derived::Scalar>> outstates(Ks.size());
 
     //************ density matrix ************//
     if (internal::check_square_mat(rA)) // square matrix
     {
         for (idx i = 0; i < Ks.size(); ++i)
         {
-            outstates[i] = cmat::Zero(rA.rows(), rA.rows());
-            cmat tmp = Ks[i] * rA * adjoint(Ks[i]); // un-normalized;
+            outstates[i] = dyn_mat<typename Derived::Scalar>::Zero(
+                    rA.rows(), rA.rows());
+            // un-normalized
+            dyn_mat<typename Derived::Scalar> tmp =
+                    Ks[i] * rA * adjoint(Ks[i]);
             prob[i] = std::abs(trace(tmp)); // probability
-            if (prob[i] > eps)
-                outstates[i] = tmp / prob[i]; // normalized
+            if (prob[i] > eps) // normalized
+                outstates[i] =
+                        tmp / static_cast<typename Derived::Scalar>(prob[i]);
         }
     }
         //************ ket ************//
@@ -264,12 +406,15 @@ measure(const Eigen::MatrixBase<Derived>& A, const std::vector<cmat>& Ks)
     {
         for (idx i = 0; i < Ks.size(); ++i)
         {
-            outstates[i] = ket::Zero(rA.rows());
-            ket tmp = Ks[i] * rA; // un-normalized;
+            outstates[i] =
+                    dyn_col_vect<typename Derived::Scalar>::Zero(rA.rows());
+            // un-normalized
+            dyn_col_vect<typename Derived::Scalar> tmp = Ks[i] * rA;
             // probability
             prob[i] = std::pow(norm(tmp), 2);
-            if (prob[i] > eps)
-                outstates[i] = tmp / std::sqrt(prob[i]); // normalized
+            if (prob[i] > eps) // normalized
+                outstates[i] = tmp / static_cast<typename Derived::Scalar>(
+                        std::sqrt(prob[i]));
         }
     } else
         throw Exception("qpp::measure()",
@@ -296,11 +441,97 @@ measure(const Eigen::MatrixBase<Derived>& A, const std::vector<cmat>& Ks)
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const std::initializer_list<cmat>& Ks)
+        const std::initializer_list<dyn_mat<typename Derived::Scalar>>& Ks)
 {
-    return measure(A, std::vector<cmat>(Ks));
+    return measure(A, std::vector<dyn_mat<typename Derived::Scalar>>(Ks));
+}
+
+/**
+* \brief Measures the state \a A using the set of sparse Kraus operators
+* \a Ks
+*
+* \param A Eigen expression
+* \param Ks Set of sparse Kraus operators
+* \return Tuple of: 1. Result of the measurement, 2.
+* Vector of outcome probabilities, and 3. Vector of post-measurement
+* normalized states
+*/
+template<typename Derived>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
+measure(const Eigen::MatrixBase<Derived>& A,
+        const std::vector<dyn_sp_mat<typename Derived::Scalar>>& Ks)
+{
+    const dyn_mat<typename Derived::Scalar>& rA = A.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rA))
+        throw Exception("qpp::measure()", Exception::Type::ZERO_SIZE);
+
+    // check the Kraus operators
+    if (Ks.size() == 0)
+        throw Exception("qpp::measure()", Exception::Type::ZERO_SIZE);
+    if (Ks[0].rows() != Ks[0].cols())
+        throw Exception("qpp::measure()", Exception::Type::MATRIX_NOT_SQUARE);
+    if (Ks[0].rows() != rA.rows())
+        throw Exception("qpp::measure()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+    for (auto&& it : Ks)
+        if (it.rows() != Ks[0].rows() || it.cols() != Ks[0].rows())
+            throw Exception("qpp::measure()", Exception::Type::DIMS_NOT_EQUAL);
+    // END EXCEPTION CHECKS
+
+    // probabilities
+    std::vector<double> prob(Ks.size());
+    // resulting states
+    std::vector<dyn_mat<typename Derived::Scalar>> outstates(Ks.size());
+
+    //************ density matrix ************//
+    if (internal::check_square_mat(rA)) // square matrix
+    {
+        for (idx i = 0; i < Ks.size(); ++i)
+        {
+            outstates[i] = dyn_mat<typename Derived::Scalar>::Zero(
+                    rA.rows(), rA.rows());
+            // un-normalized
+            dyn_mat<typename Derived::Scalar> KA = Ks[i] * rA;
+            dyn_mat<typename Derived::Scalar> tmp = KA * Ks[i].adjoint();
+            prob[i] = std::abs(trace(tmp)); // probability
+            if (prob[i] > eps) // normalized
+                outstates[i] =
+                        tmp / static_cast<typename Derived::Scalar>(prob[i]);
+        }
+    }
+        //************ ket ************//
+    else if (internal::check_cvector(rA)) // column vector
+    {
+        for (idx i = 0; i < Ks.size(); ++i)
+        {
+            outstates[i] =
+                    dyn_col_vect<typename Derived::Scalar>::Zero(rA.rows());
+            // un-normalized
+            dyn_col_vect<typename Derived::Scalar> tmp = Ks[i] * rA;
+            // probability
+            prob[i] = std::pow(norm(tmp), 2);
+            if (prob[i] > eps) // normalized
+                outstates[i] = tmp / static_cast<typename Derived::Scalar>(
+                        std::sqrt(prob[i]));
+        }
+    } else
+        throw Exception("qpp::measure()",
+                        Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
+
+    // sample from the probability distribution
+    std::discrete_distribution<idx> dd(std::begin(prob),
+                                       std::end(prob));
+    idx result = dd(RandomDevices::get_instance().rng_);
+
+    return std::make_tuple(result, prob, outstates);
 }
 
 /**
@@ -314,8 +545,10 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
-measure(const Eigen::MatrixBase<Derived>& A, const cmat& U)
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
+measure(const Eigen::MatrixBase<Derived>& A,
+        const dyn_mat<typename Derived::Scalar>& U)
 {
     const dyn_mat<typename Derived::Scalar>& rA = A.derived();
 
@@ -335,7 +568,7 @@ measure(const Eigen::MatrixBase<Derived>& A, const cmat& U)
                         Exception::Type::DIMS_MISMATCH_MATRIX);
     // END EXCEPTION CHECKS
 
-    std::vector<cmat> Ks(U.rows());
+    std::vector<dyn_mat<typename Derived::Scalar>> Ks(U.rows());
     for (idx i = 0; i < static_cast<idx>(U.rows()); ++i)
         Ks[i] = U.col(i) * adjoint(U.col(i));
 
@@ -361,9 +594,10 @@ measure(const Eigen::MatrixBase<Derived>& A, const cmat& U)
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const std::vector<cmat>& Ks,
+        const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
         const std::vector<idx>& subsys,
         const std::vector<idx>& dims)
 {
@@ -417,21 +651,25 @@ measure(const Eigen::MatrixBase<Derived>& A,
     // probabilities
     std::vector<double> prob(Ks.size());
     // resulting states
-    std::vector<cmat> outstates(Ks.size(), cmat::Zero(Dsubsys_bar, Dsubsys_bar));
+    std::vector<dyn_mat<typename Derived::Scalar>> outstates(
+            Ks.size(),
+            dyn_mat<typename Derived::Scalar>::Zero(Dsubsys_bar, Dsubsys_bar));
 
     //************ density matrix ************//
     if (internal::check_square_mat(rA)) // square matrix
     {
         for (idx i = 0; i < Ks.size(); ++i)
         {
-            cmat tmp = apply(rA, Ks[i], subsys, dims);
+            dyn_mat<typename Derived::Scalar> tmp =
+                    apply(rA, Ks[i], subsys, dims);
             tmp = ptrace(tmp, subsys, dims);
             prob[i] = std::abs(trace(tmp)); // probability
             if (prob[i] > eps)
             {
                 // normalized output state
                 // corresponding to measurement result i
-                outstates[i] = tmp / prob[i];
+                outstates[i] =
+                        tmp / static_cast<typename Derived::Scalar>(prob[i]);
             }
         }
     }
@@ -440,13 +678,15 @@ measure(const Eigen::MatrixBase<Derived>& A,
     {
         for (idx i = 0; i < Ks.size(); ++i)
         {
-            ket tmp = apply(rA, Ks[i], subsys, dims);
+            dyn_col_vect<typename Derived::Scalar> tmp =
+                    apply(rA, Ks[i], subsys, dims);
             prob[i] = std::pow(norm(tmp), 2);
             if (prob[i] > eps)
             {
                 // normalized output state
                 // corresponding to measurement result i
-                tmp /= std::sqrt(prob[i]);
+                tmp /= static_cast<typename Derived::Scalar>(
+                        std::sqrt(prob[i]));
                 outstates[i] = ptrace(tmp, subsys, dims);
             }
         }
@@ -483,13 +723,15 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const std::initializer_list<cmat>& Ks,
+        const std::initializer_list<dyn_mat<typename Derived::Scalar>>& Ks,
         const std::vector<idx>& subsys,
         const std::vector<idx>& dims)
 {
-    return measure(A, std::vector<cmat>(Ks), subsys, dims);
+    return measure(A, std::vector<dyn_mat<typename Derived::Scalar>>(Ks),
+                   subsys, dims);
 }
 
 /**
@@ -510,9 +752,10 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const std::vector<cmat>& Ks,
+        const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
         const std::vector<idx>& subsys,
         idx d = 2)
 {
@@ -557,13 +800,15 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const std::initializer_list<cmat>& Ks,
+        const std::initializer_list<dyn_mat<typename Derived::Scalar>>& Ks,
         const std::vector<idx>& subsys,
         idx d = 2)
 {
-    return measure(A, std::vector<cmat>(Ks), subsys, d);
+    return measure(A, std::vector<dyn_mat<typename Derived::Scalar>>(Ks),
+                   subsys, d);
 }
 
 /**
@@ -585,9 +830,10 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const cmat& V,
+        const dyn_mat<typename Derived::Scalar>& V,
         const std::vector<idx>& subsys,
         const std::vector<idx>& dims)
 {
@@ -631,21 +877,23 @@ measure(const Eigen::MatrixBase<Derived>& A,
     //************ ket ************//
     if (internal::check_cvector(rA))
     {
-        const ket& rpsi = A.derived();
+        const dyn_col_vect<typename Derived::Scalar>& rpsi = A.derived();
         // check that dims match state vector
         if (!internal::check_dims_match_cvect(dims, rA))
             throw Exception("qpp::measure()",
                             Exception::Type::DIMS_MISMATCH_CVECTOR);
 
         std::vector<double> prob(M); // probabilities
-        std::vector<cmat> outstates(M); // resulting states
+        // resulting states
+        std::vector<dyn_mat<typename Derived::Scalar>> outstates(M);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-        for (idx i = 0; i < M; ++i)
-            outstates[i] = ip(static_cast<const ket&>(V.col(i)),
-                              rpsi, subsys, dims);
+        // one inner product per chunk, each one a full sweep over rpsi
+        parallel_for(M, [&](idx i)
+        {
+            outstates[i] = ip(
+                    dyn_col_vect<typename Derived::Scalar>(V.col(i)), rpsi,
+                    subsys, dims);
+        }, 1);
 
         for (idx i = 0; i < M; ++i)
         {
@@ -655,7 +903,7 @@ measure(const Eigen::MatrixBase<Derived>& A,
             {
                 // normalized output state
                 // corresponding to measurement result m
-                outstates[i] /= tmp;
+                outstates[i] /= static_cast<typename Derived::Scalar>(tmp);
             }
         }
 
@@ -674,7 +922,7 @@ measure(const Eigen::MatrixBase<Derived>& A,
             throw Exception("qpp::measure()",
                             Exception::Type::DIMS_MISMATCH_MATRIX);
 
-        std::vector<cmat> Ks(M);
+        std::vector<dyn_mat<typename Derived::Scalar>> Ks(M);
         for (idx i = 0; i < M; ++i)
             Ks[i] = V.col(i) * adjoint(V.col(i));
 
@@ -704,9 +952,10 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * normalized states
 */
 template<typename Derived>
-std::tuple<idx, std::vector<double>, std::vector<cmat>>
+std::tuple<idx, std::vector<double>,
+        std::vector<dyn_mat<typename Derived::Scalar>>>
 measure(const Eigen::MatrixBase<Derived>& A,
-        const cmat& V,
+        const dyn_mat<typename Derived::Scalar>& V,
         const std::vector<idx>& subsys,
         idx d = 2)
 {
@@ -730,6 +979,435 @@ measure(const Eigen::MatrixBase<Derived>& A,
     return measure(rA, V, subsys, dims);
 }
 
+/**
+* \brief Measures the part \a subsys of
+* the multi-partite state vector or density matrix \a A
+* using the set of Kraus operators \a Ks, and constructs the
+* post-measurement state of the obtained outcome only
+* \see qpp::measure(), qpp::measure_inplace()
+*
+* \note The dimension of all \a Ks must match the dimension of \a subsys.
+* The measurement is destructive, i.e. the measured subsystems are traced away.
+*
+* \note The outcome probabilities are computed from the reduced state of
+* \a subsys, then only one post-measurement state is constructed, instead
+* of one per outcome as in qpp::measure()
+*
+* \param A Eigen expression
+* \param Ks Set of Kraus operators
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \return Tuple of: 1. Result of the measurement, 2.
+* Vector of outcome probabilities, and 3. Post-measurement normalized state
+* corresponding to the result
+*/
+template<typename Derived>
+std::tuple<idx, std::vector<double>, dyn_mat<typename Derived::Scalar>>
+measure_collapse(const Eigen::MatrixBase<Derived>& A,
+                 const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
+                 const std::vector<idx>& subsys,
+                 const std::vector<idx>& dims)
+{
+    const typename Eigen::MatrixBase<Derived>::EvalReturnType& rA
+            = A.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rA))
+        throw Exception("qpp::measure_collapse()", Exception::Type::ZERO_SIZE);
+
+    // check that dimension is valid
+    if (!internal::check_dims(dims))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::DIMS_INVALID);
+
+    // check that dims match the state vector or density matrix
+    if (!internal::check_dims_match_mat(dims, rA))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, dims))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+    std::vector<idx> subsys_dims(subsys.size());
+    for (idx i = 0; i < subsys.size(); ++i)
+        subsys_dims[i] = dims[subsys[i]];
+
+    idx Dsubsys = prod(std::begin(subsys_dims), std::end(subsys_dims));
+
+    // check the Kraus operators
+    if (Ks.size() == 0)
+        throw Exception("qpp::measure_collapse()", Exception::Type::ZERO_SIZE);
+    if (!internal::check_square_mat(Ks[0]))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::MATRIX_NOT_SQUARE);
+    if (Dsubsys != static_cast<idx>(Ks[0].rows()))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+    for (auto&& it : Ks)
+        if (it.rows() != Ks[0].rows() || it.cols() != Ks[0].rows())
+            throw Exception("qpp::measure_collapse()",
+                            Exception::Type::DIMS_NOT_EQUAL);
+
+    // check that A is a state vector or a density matrix
+    if (!internal::check_square_mat(rA) && !internal::check_cvector(rA))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
+    // END EXCEPTION CHECKS
+
+    // probabilities, from the reduced state of subsys
+    dyn_mat<typename Derived::Scalar> rho_subsys =
+            internal::reduced_state(rA, subsys, dims);
+    std::vector<double> prob(Ks.size());
+    parallel_for(Ks.size(), [&](idx i)
+    {
+        prob[i] = std::abs(trace(Ks[i] * rho_subsys * adjoint(Ks[i])));
+    }, 1);
+
+    // sample from the probability distribution
+    std::discrete_distribution<idx> dd(std::begin(prob),
+                                       std::end(prob));
+    idx result = dd(RandomDevices::get_instance().rng_);
+
+    // post-measurement state of the result only
+    dyn_mat<typename Derived::Scalar> outstate;
+    //************ density matrix ************//
+    if (internal::check_square_mat(rA)) // square matrix
+    {
+        outstate = ptrace(apply(rA, Ks[result], subsys, dims), subsys, dims)
+                   / static_cast<typename Derived::Scalar>(prob[result]);
+    }
+        //************ ket ************//
+    else // column vector
+    {
+        dyn_col_vect<typename Derived::Scalar> tmp =
+                apply(rA, Ks[result], subsys, dims);
+        tmp /= static_cast<typename Derived::Scalar>(std::sqrt(prob[result]));
+        outstate = ptrace(tmp, subsys, dims);
+    }
+
+    return std::make_tuple(result, prob, outstate);
+}
+
+// std::initializer_list overload, avoids ambiguity for 2-element lists, see
+// http://stackoverflow.com
+// /questions/26750039/ambiguity-when-using-initializer-list-as-parameter
+/**
+* \brief Measures the part \a subsys of
+* the multi-partite state vector or density matrix \a A
+* using the set of Kraus operators \a Ks, and constructs the
+* post-measurement state of the obtained outcome only
+* \see qpp::measure(), qpp::measure_inplace()
+*
+* \note The dimension of all \a Ks must match the dimension of \a subsys.
+* The measurement is destructive, i.e. the measured subsystems are traced away.
+*
+* \param A Eigen expression
+* \param Ks Set of Kraus operators
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \return Tuple of: 1. Result of the measurement, 2.
+* Vector of outcome probabilities, and 3. Post-measurement normalized state
+* corresponding to the result
+*/
+template<typename Derived>
+std::tuple<idx, std::vector<double>, dyn_mat<typename Derived::Scalar>>
+measure_collapse(const Eigen::MatrixBase<Derived>& A,
+                 const std::initializer_list<dyn_mat<typename Derived::Scalar>>&
+                 Ks,
+                 const std::vector<idx>& subsys,
+                 const std::vector<idx>& dims)
+{
+    return measure_collapse(A,
+                            std::vector<dyn_mat<typename Derived::Scalar>>(Ks),
+                            subsys, dims);
+}
+
+/**
+* \brief Measures the part \a subsys of
+* the multi-partite state vector or density matrix \a A
+* in the orthonormal basis or rank-1 POVM specified by the matrix \a V, and
+* constructs the post-measurement state of the obtained outcome only
+* \see qpp::measure(), qpp::measure_seq()
+*
+* \note The dimension of \a V must match the dimension of \a subsys.
+* The measurement is destructive, i.e. the measured subsystems are traced away.
+*
+* \note For state vectors, the outcome probabilities are the squared norms
+* of the partial inner products of \a V with \a A, computed in parallel, or
+* one pass over \a A if \a V is the identity, and a single post-measurement
+* state vector is constructed. Besides \a A and \a V, the memory used is
+* O(D / Dsubsys) per thread, instead of the number of outcomes times the
+* size of \a A
+*
+* \param A Eigen expression
+* \param V Matrix whose columns represent the measurement basis vectors or the
+* bra parts of the rank-1 POVM
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \return Tuple of: 1. Result of the measurement, 2.
+* Vector of outcome probabilities, and 3. Post-measurement normalized state
+* corresponding to the result
+*/
+template<typename Derived>
+std::tuple<idx, std::vector<double>, dyn_mat<typename Derived::Scalar>>
+measure_collapse(const Eigen::MatrixBase<Derived>& A,
+                 const dyn_mat<typename Derived::Scalar>& V,
+                 const std::vector<idx>& subsys,
+                 const std::vector<idx>& dims)
+{
+    const typename Eigen::MatrixBase<Derived>::EvalReturnType& rA
+            = A.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rA))
+        throw Exception("qpp::measure_collapse()", Exception::Type::ZERO_SIZE);
+
+    // check that dimension is valid
+    if (!internal::check_dims(dims))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::DIMS_INVALID);
+
+    // check that dims match the state vector or density matrix
+    if (!internal::check_dims_match_mat(dims, rA))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, dims))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+    std::vector<idx> subsys_dims(subsys.size());
+    for (idx i = 0; i < subsys.size(); ++i)
+        subsys_dims[i] = dims[subsys[i]];
+
+    idx Dsubsys = prod(std::begin(subsys_dims), std::end(subsys_dims));
+
+    // check the matrix V
+    if (!internal::check_nonzero_size(V))
+        throw Exception("qpp::measure_collapse()", Exception::Type::ZERO_SIZE);
+    if (Dsubsys != static_cast<idx>(V.rows()))
+        throw Exception("qpp::measure_collapse()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+    // END EXCEPTION CHECKS
+
+    // number of basis (rank-1 POVM) elements
+    idx M = static_cast<idx>(V.cols());
+
+    //************ ket ************//
+    if (internal::check_cvector(rA))
+    {
+        const dyn_col_vect<typename Derived::Scalar>& rpsi = A.derived();
+
+        // probabilities, in one pass over psi for the computational basis,
+        // otherwise as the squared norms of the partial inner products
+        std::vector<double> prob(M);
+        if (M == Dsubsys && V.isIdentity())
+            prob = internal::marginal_probs(
+                    [&](idx i) -> double { return std::norm(rpsi(i)); },
+                    subsys, dims);
+        else
+            parallel_for(M, [&](idx i)
+            {
+                prob[i] = ip(dyn_col_vect<typename Derived::Scalar>(
+                        V.col(i)), rpsi, subsys, dims).squaredNorm();
+            }, 1);
+
+        // sample from the probability distribution
+        std::discrete_distribution<idx> dd(std::begin(prob),
+                                           std::end(prob));
+        idx result = dd(RandomDevices::get_instance().rng_);
+
+        // post-measurement state of the result only
+        dyn_col_vect<typename Derived::Scalar> outstate =
+                ip(dyn_col_vect<typename Derived::Scalar>(V.col(result)),
+                   rpsi, subsys, dims);
+        outstate /= static_cast<typename Derived::Scalar>(norm(outstate));
+
+        return std::make_tuple(result, prob, outstate);
+    }
+        //************ density matrix ************//
+    else if (internal::check_square_mat(rA))
+    {
+        std::vector<dyn_mat<typename Derived::Scalar>> Ks(M);
+        for (idx i = 0; i < M; ++i)
+            Ks[i] = V.col(i) * adjoint(V.col(i));
+
+        return measure_collapse(rA, Ks, subsys, dims);
+    }
+    //************ Exception: not ket nor density matrix ************//
+    throw Exception("qpp::measure_collapse()",
+                    Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
+}
+
+/**
+* \brief Measures in place the part \a subsys of
+* the multi-partite state vector \a state
+* using the set of Kraus operators \a Ks
+* \see qpp::measure_collapse()
+*
+* \note The dimension of all \a Ks must match the dimension of \a subsys.
+* The measurement is non-destructive, i.e. the measured subsystems are kept,
+* and \a state is overwritten with the normalized post-measurement state
+* \f$K_i|\psi\rangle/\sqrt{p_i}\f$ of the result \a i. No copy of
+* \a state is made.
+*
+* \param state Column vector, overwritten with the post-measurement state
+* \param Ks Set of Kraus operators
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \return Tuple of: 1. Result of the measurement, and 2.
+* Vector of outcome probabilities
+*/
+template<typename Derived>
+std::tuple<idx, std::vector<double>>
+measure_inplace(Eigen::MatrixBase<Derived>& state,
+                const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
+                const std::vector<idx>& subsys,
+                const std::vector<idx>& dims)
+{
+    const Derived& rA = state.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rA))
+        throw Exception("qpp::measure_inplace()", Exception::Type::ZERO_SIZE);
+
+    // check that dimension is valid
+    if (!internal::check_dims(dims))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::DIMS_INVALID);
+
+    // check that dims match the state vector or density matrix
+    if (!internal::check_dims_match_mat(dims, rA))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, dims))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+
+    std::vector<idx> subsys_dims(subsys.size());
+    for (idx i = 0; i < subsys.size(); ++i)
+        subsys_dims[i] = dims[subsys[i]];
+
+    idx Dsubsys = prod(std::begin(subsys_dims), std::end(subsys_dims));
+
+    // check the Kraus operators
+    if (Ks.size() == 0)
+        throw Exception("qpp::measure_inplace()", Exception::Type::ZERO_SIZE);
+    if (!internal::check_square_mat(Ks[0]))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::MATRIX_NOT_SQUARE);
+    if (Dsubsys != static_cast<idx>(Ks[0].rows()))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+    for (auto&& it : Ks)
+        if (it.rows() != Ks[0].rows() || it.cols() != Ks[0].rows())
+            throw Exception("qpp::measure_inplace()",
+                            Exception::Type::DIMS_NOT_EQUAL);
+
+    // check column vector
+    if (!internal::check_cvector(rA))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::MATRIX_NOT_CVECTOR);
+    // END EXCEPTION CHECKS
+
+    // probabilities, from the reduced state of subsys
+    dyn_mat<typename Derived::Scalar> rho_subsys =
+            internal::reduced_state(rA, subsys, dims);
+    std::vector<double> prob(Ks.size());
+    parallel_for(Ks.size(), [&](idx i)
+    {
+        prob[i] = std::abs(trace(Ks[i] * rho_subsys * adjoint(Ks[i])));
+    }, 1);
+
+    // sample from the probability distribution
+    std::discrete_distribution<idx> dd(std::begin(prob),
+                                       std::end(prob));
+    idx result = dd(RandomDevices::get_instance().rng_);
+
+    apply_inplace(state, Ks[result], subsys, dims);
+    state /= static_cast<typename Derived::Scalar>(std::sqrt(prob[result]));
+
+    return std::make_tuple(result, prob);
+}
+
+/**
+* \brief Measures in place the part \a subsys of
+* the multi-partite state vector \a state in the computational basis
+* \see qpp::measure_collapse(), qpp::sample()
+*
+* \note The measurement is non-destructive, i.e. the measured subsystems are
+* kept, and \a state is overwritten with the normalized post-measurement
+* state. The outcome probabilities are accumulated in a single pass over
+* \a state, and the state is collapsed in a second one. No copy of \a state
+* is made.
+*
+* \param state Column vector, overwritten with the post-measurement state
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \return Tuple of: 1. Result of the measurement, the index of the measured
+* basis state of \a subsys, with the last subsystem of \a subsys varying
+* fastest (as in qpp::measure()), and 2. Vector of outcome probabilities
+*/
+template<typename Derived>
+std::tuple<idx, std::vector<double>>
+measure_inplace(Eigen::MatrixBase<Derived>& state,
+                const std::vector<idx>& subsys,
+                const std::vector<idx>& dims)
+{
+    Derived& rstate = state.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rstate))
+        throw Exception("qpp::measure_inplace()", Exception::Type::ZERO_SIZE);
+
+    // check that dimension is valid
+    if (!internal::check_dims(dims))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::DIMS_INVALID);
+
+    // check column vector
+    if (!internal::check_cvector(rstate))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::MATRIX_NOT_CVECTOR);
+
+    // check that dims match state vector
+    if (!internal::check_dims_match_cvect(dims, rstate))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::DIMS_MISMATCH_CVECTOR);
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, dims))
+        throw Exception("qpp::measure_inplace()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+    // END EXCEPTION CHECKS
+
+    std::vector<double> prob = internal::marginal_probs(
+            [&](idx i) -> double { return std::norm(rstate(i)); },
+            subsys, dims);
+
+    // sample from the probability distribution
+    std::discrete_distribution<idx> dd(std::begin(prob),
+                                       std::end(prob));
+    idx result = dd(RandomDevices::get_instance().rng_);
+
+    internal::collapse_inplace(rstate, result, prob[result], subsys, dims);
+
+    return std::make_tuple(result, prob);
+}
+
 /**
 * \brief Sequentially measures the part \a subsys
 * of the multi-partite state vector or density matrix \a A
@@ -745,7 +1423,7 @@ measure(const Eigen::MatrixBase<Derived>& A,
 * Outcome probability, and 3. Post-measurement normalized state
 */
 template<typename Derived>
-std::tuple<std::vector<idx>, double, cmat>
+std::tuple<std::vector<idx>, double, dyn_mat<typename Derived::Scalar>>
 measure_seq(const Eigen::MatrixBase<Derived>& A,
             std::vector<idx> subsys,
             std::vector<idx> dims)
@@ -789,13 +1467,16 @@ measure_seq(const Eigen::MatrixBase<Derived>& A,
     {
         while (subsys.size() > 0)
         {
-            auto tmp = measure(
-                    cA, Gates::get_instance().Id(dims[subsys[0]]),
+            // only the post-measurement state of the result is constructed
+            auto tmp = measure_collapse(
+                    cA, Gates::get_instance()
+                            .Id<dyn_mat<typename Derived::Scalar>>(
+                                    dims[subsys[0]]),
                     {subsys[0]}, dims
             );
             result.push_back(std::get<0>(tmp));
             prob *= std::get<1>(tmp)[std::get<0>(tmp)];
-            cA = std::get<2>(tmp)[std::get<0>(tmp)];
+            cA = std::get<2>(tmp);
 
             // remove the subsystem
             dims.erase(std::next(std::begin(dims), subsys[0]));
@@ -825,7 +1506,7 @@ measure_seq(const Eigen::MatrixBase<Derived>& A,
 * Outcome probability, and 3. Post-measurement normalized state
 */
 template<typename Derived>
-std::tuple<std::vector<idx>, double, cmat>
+std::tuple<std::vector<idx>, double, dyn_mat<typename Derived::Scalar>>
 measure_seq(const Eigen::MatrixBase<Derived>& A,
             std::vector<idx> subsys,
             idx d = 2)
@@ -850,6 +1531,162 @@ measure_seq(const Eigen::MatrixBase<Derived>& A,
     return measure_seq(rA, subsys, dims);
 }
 
+/**
+* \brief Probabilities of the outcomes of a computational-basis measurement
+* of the part \a subsys of the multi-partite state vector or density matrix
+* \a A
+* \see qpp::marginal(), qpp::sample()
+*
+* \note Accumulates \f$|\psi_i|^2\f$ (or the diagonal of the density
+* matrix) in a single streaming pass over \a A, with per-thread partial
+* histograms, instead of constructing the reduced state of \a subsys or the
+* post-measurement states as qpp::measure() does
+*
+* \param A Eigen expression
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \return Vector of outcome probabilities, one for each basis state of
+* \a subsys, with the last subsystem of \a subsys varying fastest (as in
+* qpp::measure())
+*/
+template<typename Derived>
+std::vector<double> probs(const Eigen::MatrixBase<Derived>& A,
+                          const std::vector<idx>& subsys,
+                          const std::vector<idx>& dims)
+{
+    const typename Eigen::MatrixBase<Derived>::EvalReturnType& rA
+            = A.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero-size
+    if (!internal::check_nonzero_size(rA))
+        throw Exception("qpp::probs()", Exception::Type::ZERO_SIZE);
+
+    // check that dimension is valid
+    if (!internal::check_dims(dims))
+        throw Exception("qpp::probs()", Exception::Type::DIMS_INVALID);
+
+    // check that dims match the state vector or density matrix
+    if (!internal::check_dims_match_mat(dims, rA))
+        throw Exception("qpp::probs()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, dims))
+        throw Exception("qpp::probs()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+    // END EXCEPTION CHECKS
+
+    //************ ket ************//
+    if (internal::check_cvector(rA))
+        return internal::marginal_probs(
+                [&](idx i) -> double { return std::norm(rA(i)); },
+                subsys, dims);
+    //************ density matrix ************//
+    else if (internal::check_square_mat(rA))
+        return internal::marginal_probs(
+                [&](idx i) -> double { return std::real(rA(i, i)); },
+                subsys, dims);
+    //************ Exception: not ket nor density matrix ************//
+    throw Exception("qpp::probs()",
+                    Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
+}
+
+/**
+* \brief Samples repeated computational-basis measurements of the part
+* \a subsys of the multi-partite state vector or density matrix \a A
+* \see qpp::sample_hist()
+*
+* \note The outcome distribution is computed once, by qpp::probs(), in a
+* single pass over \a A, then the shots are drawn in O(1) each from an alias
+* table, in parallel, with independent random streams seeded by
+* qpp::RandomDevices. The state \a A is not modified.
+*
+* \param A Eigen expression
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \param shots Number of measurements
+* \return Vector of \a shots outcomes, each one the index of the measured
+* basis state of \a subsys, with the last subsystem of \a subsys varying
+* fastest (as in qpp::measure())
+*/
+template<typename Derived>
+std::vector<idx> sample(const Eigen::MatrixBase<Derived>& A,
+                        const std::vector<idx>& subsys,
+                        const std::vector<idx>& dims,
+                        idx shots)
+{
+    // outcome distribution, computed once for all the shots
+    std::vector<double> prob = probs(A, subsys, dims);
+    internal::AliasTable table = internal::alias_table(prob);
+
+    // one random stream per block of shots
+    idx numstreams = (shots + internal::shots_per_stream - 1)
+                     / internal::shots_per_stream;
+    std::vector<std::mt19937::result_type> seeds(numstreams);
+    for (auto&& seed : seeds)
+        seed = RandomDevices::get_instance().rng_();
+
+    std::vector<idx> result(shots);
+    parallel_for(numstreams, [&](idx s)
+    {
+        std::mt19937 gen{seeds[s]};
+        idx end = std::min(shots, (s + 1) * internal::shots_per_stream);
+        for (idx i = s * internal::shots_per_stream; i < end; ++i)
+            result[i] = internal::alias_draw(table, gen);
+    }, 1);
+
+    return result;
+}
+
+/**
+* \brief Histogram of repeated computational-basis measurements of the part
+* \a subsys of the multi-partite state vector or density matrix \a A
+* \see qpp::sample()
+*
+* \note Draws the same outcomes as qpp::sample() would for the same state
+* of qpp::RandomDevices, without storing them
+*
+* \param A Eigen expression
+* \param subsys Subsystem indexes that are measured
+* \param dims Dimensions of the multi-partite system
+* \param shots Number of measurements
+* \return Vector of counts, one for each basis state of \a subsys, ordered
+* as the outcomes of qpp::sample()
+*/
+template<typename Derived>
+std::vector<idx> sample_hist(const Eigen::MatrixBase<Derived>& A,
+                             const std::vector<idx>& subsys,
+                             const std::vector<idx>& dims,
+                             idx shots)
+{
+    // outcome distribution, computed once for all the shots
+    std::vector<double> prob = probs(A, subsys, dims);
+    internal::AliasTable table = internal::alias_table(prob);
+
+    // one random stream per block of shots
+    idx numstreams = (shots + internal::shots_per_stream - 1)
+                     / internal::shots_per_stream;
+    std::vector<std::mt19937::result_type> seeds(numstreams);
+    for (auto&& seed : seeds)
+        seed = RandomDevices::get_instance().rng_();
+
+    // per-thread partial histograms
+    return parallel_reduce(numstreams, std::vector<idx>(prob.size(), 0),
+                           [&](idx s, std::vector<idx>& partial)
+    {
+        std::mt19937 gen{seeds[s]};
+        idx end = std::min(shots, (s + 1) * internal::shots_per_stream);
+        for (idx i = s * internal::shots_per_stream; i < end; ++i)
+            ++partial[internal::alias_draw(table, gen)];
+    }, [](std::vector<idx>& result, const std::vector<idx>& partial)
+    {
+        for (idx m = 0; m < result.size(); ++m)
+            result[m] += partial[m];
+    }, 1);
+}
+
 } /* namespace qpp */
 
 #endif /* INSTRUMENTS_H_ */
@@ -0,0 +1,344 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file internal/kernels.h
+* \brief Internal gate application kernels
+*/
+
+#ifndef INTERNAL_KERNELS_H_
+#define INTERNAL_KERNELS_H_
+
+namespace qpp
+{
+namespace internal
+{
+
+// applies in place the DA x DA matrix U to all groups of amplitudes
+// psi(base + offset + offsets[m]), m = 0, ..., DA - 1, where base runs over the
+// numgroups indexes having zero digits on the fixed positions;
+// the fixed positions must be sorted in increasing order of their strides
+template<typename Derived>
+void apply_groups(Eigen::MatrixBase<Derived>& psi,
+                  const dyn_mat<typename Derived::Scalar>& U,
+                  const idx* offsets, idx offset, idx numgroups,
+                  idx numfixed, const idx* fixed_strides,
+                  const idx* fixed_dims)
+{
+    // no error checks to improve speed
+    using Scalar = typename Derived::Scalar;
+    Derived& rpsi = psi.derived();
+    idx DA = static_cast<idx>(U.rows());
+
+    // groups come in contiguous runs of the smallest fixed stride; each
+    // chunk inserts the zero digits once, then walks its groups with
+    // qpp::internal::ZeroDigitsIndex, which only carries at the end of a run
+    idx run = numfixed > 0 ? fixed_strides[0] : 1;
+    idx numruns = numgroups / run;
+
+    //************ 1 qubit ************//
+    if (DA == 2)
+    {
+        const Scalar u00 = U(0, 0), u01 = U(0, 1);
+        const Scalar u10 = U(1, 0), u11 = U(1, 1);
+        const idx o0 = offset + offsets[0];
+        const idx o1 = offset + offsets[1];
+
+        // vectorized kernel, if available
+        const Scalar u[4] = {u00, u01, u10, u11};
+        const idx o[2] = {o0, o1};
+        if (simd_apply_dense(simd_data(psi), u, o, 2, numruns, run,
+                             numfixed, fixed_strides, fixed_dims))
+            return;
+
+        parallel_chunks(numgroups, [&](idx begin, idx end)
+        {
+            ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+            for (idx g = begin; g < end; ++g, ++index)
+            {
+                idx base = index();
+                Scalar a0 = rpsi(base + o0);
+                Scalar a1 = rpsi(base + o1);
+                rpsi(base + o0) = u00 * a0 + u01 * a1;
+                rpsi(base + o1) = u10 * a0 + u11 * a1;
+            }
+        });
+    }
+        //************ 2 qubits ************//
+    else if (DA == 4)
+    {
+        Scalar u[4][4];
+        idx o[4];
+        for (idx m = 0; m < 4; ++m)
+        {
+            o[m] = offset + offsets[m];
+            for (idx n = 0; n < 4; ++n)
+                u[m][n] = U(m, n);
+        }
+
+        // vectorized kernel, if available
+        if (simd_apply_dense(simd_data(psi), &u[0][0], o, 4, numruns, run,
+                             numfixed, fixed_strides, fixed_dims))
+            return;
+
+        parallel_chunks(numgroups, [&](idx begin, idx end)
+        {
+            ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+            for (idx g = begin; g < end; ++g, ++index)
+            {
+                idx base = index();
+                Scalar a0 = rpsi(base + o[0]);
+                Scalar a1 = rpsi(base + o[1]);
+                Scalar a2 = rpsi(base + o[2]);
+                Scalar a3 = rpsi(base + o[3]);
+                for (idx m = 0; m < 4; ++m)
+                    rpsi(base + o[m]) = u[m][0] * a0 + u[m][1] * a1
+                                        + u[m][2] * a2 + u[m][3] * a3;
+            }
+        });
+    }
+        //************ general case ************//
+    else
+    {
+        parallel_chunks(numgroups, [&](idx begin, idx end)
+        {
+            // per-chunk scratch space, holds one group of amplitudes
+            dyn_col_vect<Scalar> amplitudes(DA);
+
+            ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+            for (idx g = begin; g < end; ++g, ++index)
+            {
+                idx base = index() + offset;
+                // gather
+                for (idx m = 0; m < DA; ++m)
+                    amplitudes(m) = rpsi(base + offsets[m]);
+                // multiply and scatter
+                for (idx m = 0; m < DA; ++m)
+                {
+                    Scalar coeff = 0;
+                    for (idx n = 0; n < DA; ++n)
+                        coeff += U(m, n) * amplitudes(n);
+                    rpsi(base + offsets[m]) = coeff;
+                }
+            }
+        }, std::max<idx>(1, parallel_config().grain / DA));
+    }
+}
+
+// batched version of qpp::internal::apply_groups(), the B x D matrix X holds
+// one state vector per row; the DA columns X.col(base + offset + offsets[m])
+// of a group are contiguous, so each group is updated by one small
+// B x DA times DA x DA matrix product
+template<typename Derived>
+void apply_groups_batch(Eigen::MatrixBase<Derived>& X,
+                        const dyn_mat<typename Derived::Scalar>& U,
+                        const idx* offsets, idx offset, idx numgroups,
+                        idx numfixed, const idx* fixed_strides,
+                        const idx* fixed_dims)
+{
+    // no error checks to improve speed
+    using Scalar = typename Derived::Scalar;
+    Derived& rX = X.derived();
+    idx DA = static_cast<idx>(U.rows());
+    idx B = static_cast<idx>(rX.rows());
+    dyn_mat<Scalar> UT = U.transpose();
+
+    parallel_chunks(numgroups, [&](idx begin, idx end)
+    {
+        // per-chunk scratch space, holds one group of columns
+        dyn_mat<Scalar> G(B, DA);
+        dyn_mat<Scalar> R(B, DA);
+
+        ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+        for (idx g = begin; g < end; ++g, ++index)
+        {
+            idx base = index() + offset;
+            // gather
+            for (idx m = 0; m < DA; ++m)
+                G.col(m) = rX.col(base + offsets[m]);
+            // multiply and scatter
+            R.noalias() = G * UT;
+            for (idx m = 0; m < DA; ++m)
+                rX.col(base + offsets[m]) = R.col(m);
+        }
+    }, std::max<idx>(1, parallel_config().grain / (B * DA)));
+}
+
+// phase lookup table of the DA x DA diagonal matrix U acting on the amplitudes
+// offset + offsets[m], m = 0, ..., DA - 1, of a group; only the non-unit
+// phases p[k] are kept, together with their offsets o[k]
+template<typename Scalar>
+void diagonal_table(const dyn_mat<Scalar>& U, const idx* offsets,
+                    idx offset, std::vector<idx>& o, std::vector<Scalar>& p)
+{
+    // no error checks to improve speed
+    idx DA = static_cast<idx>(U.rows());
+
+    o.clear();
+    p.clear();
+    for (idx m = 0; m < DA; ++m)
+    {
+        if (U(m, m) != static_cast<Scalar>(1))
+        {
+            o.push_back(offset + offsets[m]);
+            p.push_back(U(m, m));
+        }
+    }
+}
+
+// cycle table of the DA x DA monomial matrix U (exactly one non-zero element
+// per row and column) acting on the amplitudes offset + offsets[m],
+// m = 0, ..., DA - 1, of a group; U|n> = phase[n]|image[n]> and the
+// non-trivial cycles n, image[n], image[image[n]], ... are stored one after
+// the other in o (offsets) and p (phases), the j-th cycle occupying
+// [start[j], start[j + 1]); returns true if U is a permutation matrix
+template<typename Scalar>
+bool monomial_table(const dyn_mat<Scalar>& U, const idx* offsets,
+                    idx offset, std::vector<idx>& o, std::vector<Scalar>& p,
+                    std::vector<idx>& start)
+{
+    // no error checks to improve speed
+    idx DA = static_cast<idx>(U.rows());
+
+    std::vector<idx> image(DA);
+    std::vector<Scalar> phase(DA);
+    for (idx n = 0; n < DA; ++n)
+        for (idx m = 0; m < DA; ++m)
+            if (U(m, n) != static_cast<Scalar>(0))
+            {
+                image[n] = m;
+                phase[n] = U(m, n);
+            }
+
+    o.clear();
+    p.clear();
+    start.clear();
+    std::vector<bool> visited(DA, false);
+    bool permutation = true; // no phases, only moves
+    for (idx n0 = 0; n0 < DA; ++n0)
+    {
+        if (visited[n0])
+            continue;
+        if (image[n0] == n0 && phase[n0] == static_cast<Scalar>(1))
+        {
+            visited[n0] = true;
+            continue;
+        }
+        start.push_back(o.size());
+        idx n = n0;
+        do
+        {
+            visited[n] = true;
+            o.push_back(offset + offsets[n]);
+            p.push_back(phase[n]);
+            if (phase[n] != static_cast<Scalar>(1))
+                permutation = false;
+            n = image[n];
+        } while (n != n0);
+    }
+    start.push_back(o.size());
+
+    return permutation;
+}
+
+// multiplies in place the amplitudes psi(base + o[k]) by p[k],
+// k = 0, ..., np - 1, see qpp::internal::diagonal_table(), where base runs
+// over the numgroups indexes having zero digits on the fixed positions;
+// the fixed positions must be sorted in increasing order of their strides
+template<typename Derived>
+void apply_groups_diagonal(Eigen::MatrixBase<Derived>& psi,
+                           const idx* o, const typename Derived::Scalar* p,
+                           idx np, idx numgroups, idx numfixed,
+                           const idx* fixed_strides, const idx* fixed_dims)
+{
+    // no error checks to improve speed
+    Derived& rpsi = psi.derived();
+
+    if (np == 0)
+        return;
+
+    idx run = numfixed > 0 ? fixed_strides[0] : 1;
+    idx numruns = numgroups / run;
+
+    // vectorized kernel, if available
+    if (simd_apply_diagonal(simd_data(psi), o, p, np, numruns, run,
+                            numfixed, fixed_strides, fixed_dims))
+        return;
+
+    parallel_chunks(numgroups, [&](idx begin, idx end)
+    {
+        ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+        for (idx g = begin; g < end; ++g, ++index)
+            for (idx k = 0; k < np; ++k)
+                rpsi(index() + o[k]) *= p[k];
+    });
+}
+
+// moves in place the amplitudes psi(base + o[k]) along the numcycles cycles
+// described by o, p and start, see qpp::internal::monomial_table(), where base
+// runs over the numgroups indexes having zero digits on the fixed positions;
+// no multiplications are performed if permutation is true; the fixed
+// positions must be sorted in increasing order of their strides
+template<typename Derived>
+void apply_groups_monomial(Eigen::MatrixBase<Derived>& psi,
+                           const idx* o, const typename Derived::Scalar* p,
+                           const idx* start, idx numcycles, bool permutation,
+                           idx numgroups, idx numfixed,
+                           const idx* fixed_strides, const idx* fixed_dims)
+{
+    // no error checks to improve speed
+    using Scalar = typename Derived::Scalar;
+    Derived& rpsi = psi.derived();
+
+    if (numcycles == 0)
+        return;
+
+    parallel_chunks(numgroups, [&](idx begin, idx end)
+    {
+        ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+        for (idx g = begin; g < end; ++g, ++index)
+        {
+            idx base = index();
+            for (idx c = 0; c < numcycles; ++c)
+            {
+                idx first = start[c], last = start[c + 1] - 1;
+                Scalar tmp = rpsi(base + o[last]);
+                if (permutation)
+                {
+                    for (idx k = last; k > first; --k)
+                        rpsi(base + o[k]) = rpsi(base + o[k - 1]);
+                    rpsi(base + o[first]) = tmp;
+                } else
+                {
+                    for (idx k = last; k > first; --k)
+                        rpsi(base + o[k]) = p[k - 1]
+                                            * rpsi(base + o[k - 1]);
+                    rpsi(base + o[first]) = p[last] * tmp;
+                }
+            }
+        }
+    });
+}
+
+} /* namespace internal */
+} /* namespace qpp */
+
+#endif /* INTERNAL_KERNELS_H_ */
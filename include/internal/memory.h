@@ -0,0 +1,133 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file internal/memory.h
+* \brief Internal NUMA-aware allocation of the state buffers
+*/
+
+#ifndef INTERNAL_MEMORY_H_
+#define INTERNAL_MEMORY_H_
+
+namespace qpp
+{
+namespace internal
+{
+
+// page placement of the large state buffers
+enum class Placement
+{
+    FIRST_TOUCH, // on the node of the thread that first writes the page
+    INTERLEAVE   // round-robin over all the nodes, needs WITH_NUMA_
+};
+
+// allocation policy of the large state buffers
+struct MemoryPolicy
+{
+    Placement placement = Placement::FIRST_TOUCH;
+    bool huge_pages = false; // transparent huge pages hint, Linux only
+    idx min_size = 32768;    // smaller buffers are allocated as usual
+};
+
+// current allocation policy; returned by reference, so it can be changed
+inline MemoryPolicy& memory_policy()
+{
+    static MemoryPolicy policy;
+
+    return policy;
+}
+
+// applies the placement hints to a freshly allocated, not yet touched buffer
+inline void place_pages(void* p, std::size_t bytes)
+{
+#ifdef __linux__
+    // the hints apply to whole pages only
+    std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(p) + page - 1)
+                           / page * page;
+    std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(p) + bytes)
+                         / page * page;
+    if (end <= begin)
+        return;
+#ifdef MADV_HUGEPAGE
+    if (memory_policy().huge_pages)
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+#ifdef WITH_NUMA_
+    if (memory_policy().placement == Placement::INTERLEAVE &&
+        numa_available() >= 0)
+        numa_interleave_memory(reinterpret_cast<void*>(begin), end - begin,
+                               numa_all_nodes_ptr);
+#endif // WITH_NUMA_
+#else
+    (void) p;
+    (void) bytes;
+#endif // __linux__
+}
+
+// zero matrix of type T, first touched by the threads of qpp::parallel_for(),
+// with the same static schedule as the kernels, so that each page lands on
+// the node of the thread that later sweeps it
+template<typename T>
+T numa_zero(idx rows, idx cols)
+{
+    T result(rows, cols);
+    idx n = rows * cols;
+    if (n < memory_policy().min_size)
+    {
+        result.setZero();
+        return result;
+    }
+
+    using Scalar = typename T::Scalar;
+    place_pages(result.data(), n * sizeof(Scalar));
+    Scalar* p = result.data();
+    parallel_for(n, [&](idx i) { p[i] = 0; });
+
+    return result;
+}
+
+// copy of A, first touched as in qpp::internal::numa_zero()
+template<typename Derived>
+dyn_mat<typename Derived::Scalar>
+numa_copy(const Eigen::MatrixBase<Derived>& A)
+{
+    const typename Eigen::MatrixBase<Derived>::EvalReturnType& rA =
+            A.derived();
+
+    idx n = static_cast<idx>(rA.size());
+    if (n < memory_policy().min_size)
+        return rA;
+
+    using Scalar = typename Derived::Scalar;
+    dyn_mat<Scalar> result(rA.rows(), rA.cols());
+    place_pages(result.data(), n * sizeof(Scalar));
+    Scalar* p = result.data();
+    const Scalar* q = rA.data();
+    parallel_for(n, [&](idx i) { p[i] = q[i]; });
+
+    return result;
+}
+
+} /* namespace internal */
+} /* namespace qpp */
+
+#endif /* INTERNAL_MEMORY_H_ */
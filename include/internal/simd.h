@@ -0,0 +1,390 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file internal/simd.h
+* \brief Internal vectorized gate application kernels (AVX2/AVX-512),
+* selected at runtime
+*/
+
+#ifndef INTERNAL_SIMD_H_
+#define INTERNAL_SIMD_H_
+
+namespace qpp
+{
+namespace internal
+{
+
+// instruction set extensions used by the vectorized kernels
+enum class SIMD
+{
+    NONE,
+    AVX2,
+    AVX512
+};
+
+// best instruction set supported by the CPU, detected once at runtime;
+// returned by reference, so it can be lowered (e.g. to test the fallbacks)
+inline SIMD& simd_isa()
+{
+    static SIMD isa = []
+    {
+#ifdef QPP_X86_SIMD_
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        {
+            if (__builtin_cpu_supports("avx512f"))
+                return SIMD::AVX512;
+            return SIMD::AVX2;
+        }
+#endif // QPP_X86_SIMD_
+        return SIMD::NONE;
+    }();
+
+    return isa;
+}
+
+// pointer to the contiguous storage of psi, or nullptr if the elements of psi
+// are not stored contiguously, in which case the scalar kernels are used
+template<typename Derived>
+typename std::enable_if<(Derived::Flags & Eigen::DirectAccessBit) &&
+                        Derived::InnerStrideAtCompileTime == 1,
+        typename Derived::Scalar*>::type
+simd_data(Eigen::MatrixBase<Derived>& psi)
+{
+    return psi.derived().data();
+}
+
+template<typename Derived>
+typename std::enable_if<!((Derived::Flags & Eigen::DirectAccessBit) &&
+                          Derived::InnerStrideAtCompileTime == 1),
+        typename Derived::Scalar*>::type
+simd_data(Eigen::MatrixBase<Derived>&)
+{
+    return nullptr;
+}
+
+#ifdef QPP_X86_SIMD_
+
+// the kernels below act on interleaved complex doubles, i.e.
+// (re, im, re, im, ...), 2 per AVX2 register and 4 per AVX-512 register;
+// with a = (re, im), u = (ure, uim) and as = (im, re), the product u * a is
+// addsub(a * ure, as * uim), so sums of products only need one addsub
+
+//************ AVX2 ************//
+
+// DA x DA gate (row-major u), vectorized over pairs of consecutive groups,
+// requires the run of contiguous groups to be even; processes the pairs
+// begin, ..., end - 1
+template<idx DA>
+__attribute__((target("avx2,fma")))
+inline void simd_apply_dense_avx2(cplx* psi, const cplx* u, const idx* o,
+                                  idx numfixed, const idx* fixed_strides,
+                                  const idx* fixed_dims, idx begin, idx end)
+{
+    double* data = reinterpret_cast<double*>(psi);
+    __m256d ure[DA * DA], uim[DA * DA];
+    for (idx k = 0; k < DA * DA; ++k)
+    {
+        ure[k] = _mm256_set1_pd(u[k].real());
+        uim[k] = _mm256_set1_pd(u[k].imag());
+    }
+    ZeroDigitsIndex index(2 * begin, numfixed, fixed_strides, fixed_dims,
+                          2);
+    for (idx i = begin; i < end; ++i, ++index)
+    {
+        idx base = index();
+        __m256d a[DA], as[DA];
+        for (idx n = 0; n < DA; ++n)
+        {
+            a[n] = _mm256_loadu_pd(data + 2 * (base + o[n]));
+            as[n] = _mm256_permute_pd(a[n], 0x5);
+        }
+        for (idx m = 0; m < DA; ++m)
+        {
+            __m256d x = _mm256_mul_pd(a[0], ure[m * DA]);
+            __m256d y = _mm256_mul_pd(as[0], uim[m * DA]);
+            for (idx n = 1; n < DA; ++n)
+            {
+                x = _mm256_fmadd_pd(a[n], ure[m * DA + n], x);
+                y = _mm256_fmadd_pd(as[n], uim[m * DA + n], y);
+            }
+            _mm256_storeu_pd(data + 2 * (base + o[m]),
+                             _mm256_addsub_pd(x, y));
+        }
+    }
+}
+
+// 1 qubit gate (row-major u) acting on the unit-stride subsystem, i.e. on
+// pairs of adjacent amplitudes, one group per register; processes the groups
+// begin, ..., end - 1
+__attribute__((target("avx2,fma")))
+inline void simd_apply_pair_avx2(cplx* psi, const cplx* u, idx o0,
+                                 idx numfixed, const idx* fixed_strides,
+                                 const idx* fixed_dims, idx begin, idx end)
+{
+    double* data = reinterpret_cast<double*>(psi);
+    // (u00, u11) multiplies (a0, a1), (u01, u10) multiplies (a1, a0)
+    const __m256d dre = _mm256_setr_pd(u[0].real(), u[0].real(),
+                                       u[3].real(), u[3].real());
+    const __m256d dim = _mm256_setr_pd(u[0].imag(), u[0].imag(),
+                                       u[3].imag(), u[3].imag());
+    const __m256d ore = _mm256_setr_pd(u[1].real(), u[1].real(),
+                                       u[2].real(), u[2].real());
+    const __m256d oim = _mm256_setr_pd(u[1].imag(), u[1].imag(),
+                                       u[2].imag(), u[2].imag());
+
+    ZeroDigitsIndex index(begin, numfixed, fixed_strides, fixed_dims);
+    for (idx h = begin; h < end; ++h, ++index)
+    {
+        idx base = index();
+        double* p = data + 2 * (base + o0);
+        __m256d a = _mm256_loadu_pd(p);
+        __m256d b = _mm256_permute2f128_pd(a, a, 0x01);
+        __m256d x = _mm256_fmadd_pd(b, ore, _mm256_mul_pd(a, dre));
+        __m256d y = _mm256_fmadd_pd(_mm256_permute_pd(b, 0x5), oim,
+                                    _mm256_mul_pd(_mm256_permute_pd(a, 0x5),
+                                                  dim));
+        _mm256_storeu_pd(p, _mm256_addsub_pd(x, y));
+    }
+}
+
+// diagonal gate (phases p at offsets o), vectorized over pairs of consecutive
+// groups, requires the run of contiguous groups to be even; processes the
+// pairs begin, ..., end - 1
+__attribute__((target("avx2,fma")))
+inline void simd_apply_diagonal_avx2(cplx* psi, const idx* o, const cplx* p,
+                                     idx np, idx numfixed,
+                                     const idx* fixed_strides,
+                                     const idx* fixed_dims, idx begin,
+                                     idx end)
+{
+    double* data = reinterpret_cast<double*>(psi);
+    ZeroDigitsIndex index(2 * begin, numfixed, fixed_strides, fixed_dims,
+                          2);
+    for (idx i = begin; i < end; ++i, ++index)
+    {
+        idx base = index();
+        for (idx k = 0; k < np; ++k)
+        {
+            double* q = data + 2 * (base + o[k]);
+            __m256d a = _mm256_loadu_pd(q);
+            __m256d x = _mm256_mul_pd(a, _mm256_set1_pd(p[k].real()));
+            __m256d y = _mm256_mul_pd(_mm256_permute_pd(a, 0x5),
+                                      _mm256_set1_pd(p[k].imag()));
+            _mm256_storeu_pd(q, _mm256_addsub_pd(x, y));
+        }
+    }
+}
+
+//************ AVX-512 ************//
+
+// DA x DA gate (row-major u), vectorized over quadruples of consecutive
+// groups, requires the run of contiguous groups to be a multiple of 4;
+// processes the quadruples begin, ..., end - 1
+template<idx DA>
+__attribute__((target("avx512f")))
+inline void simd_apply_dense_avx512(cplx* psi, const cplx* u, const idx* o,
+                                    idx numfixed, const idx* fixed_strides,
+                                    const idx* fixed_dims, idx begin, idx end)
+{
+    double* data = reinterpret_cast<double*>(psi);
+    const __m512d one = _mm512_set1_pd(1);
+    __m512d ure[DA * DA], uim[DA * DA];
+    for (idx k = 0; k < DA * DA; ++k)
+    {
+        ure[k] = _mm512_set1_pd(u[k].real());
+        uim[k] = _mm512_set1_pd(u[k].imag());
+    }
+    ZeroDigitsIndex index(4 * begin, numfixed, fixed_strides, fixed_dims,
+                          4);
+    for (idx i = begin; i < end; ++i, ++index)
+    {
+        idx base = index();
+        __m512d a[DA], as[DA];
+        for (idx n = 0; n < DA; ++n)
+        {
+            a[n] = _mm512_loadu_pd(data + 2 * (base + o[n]));
+            as[n] = _mm512_permute_pd(a[n], 0x55);
+        }
+        for (idx m = 0; m < DA; ++m)
+        {
+            __m512d x = _mm512_mul_pd(a[0], ure[m * DA]);
+            __m512d y = _mm512_mul_pd(as[0], uim[m * DA]);
+            for (idx n = 1; n < DA; ++n)
+            {
+                x = _mm512_fmadd_pd(a[n], ure[m * DA + n], x);
+                y = _mm512_fmadd_pd(as[n], uim[m * DA + n], y);
+            }
+            // addsub(x, y)
+            _mm512_storeu_pd(data + 2 * (base + o[m]),
+                             _mm512_fmaddsub_pd(x, one, y));
+        }
+    }
+}
+
+// diagonal gate (phases p at offsets o), vectorized over quadruples of
+// consecutive groups, requires the run of contiguous groups to be a multiple
+// of 4; processes the quadruples begin, ..., end - 1
+__attribute__((target("avx512f")))
+inline void simd_apply_diagonal_avx512(cplx* psi, const idx* o, const cplx* p,
+                                       idx np, idx numfixed,
+                                       const idx* fixed_strides,
+                                       const idx* fixed_dims, idx begin,
+                                       idx end)
+{
+    double* data = reinterpret_cast<double*>(psi);
+    ZeroDigitsIndex index(4 * begin, numfixed, fixed_strides, fixed_dims,
+                          4);
+    for (idx i = begin; i < end; ++i, ++index)
+    {
+        idx base = index();
+        for (idx k = 0; k < np; ++k)
+        {
+            double* q = data + 2 * (base + o[k]);
+            __m512d a = _mm512_loadu_pd(q);
+            __m512d y = _mm512_mul_pd(_mm512_permute_pd(a, 0x55),
+                                      _mm512_set1_pd(p[k].imag()));
+            _mm512_storeu_pd(q, _mm512_fmaddsub_pd(
+                    a, _mm512_set1_pd(p[k].real()), y));
+        }
+    }
+}
+
+#endif // QPP_X86_SIMD_
+
+//************ dispatch ************//
+
+// vectorized DA x DA gate (row-major u, DA = 2 or 4) on the amplitudes
+// psi[base + o[m]]; returns false if no vectorized kernel applies,
+// in which case nothing is done
+template<typename Scalar>
+bool simd_apply_dense(Scalar*, const Scalar*, const idx*, idx, idx, idx, idx,
+                      const idx*, const idx*)
+{
+    return false;
+}
+
+inline bool simd_apply_dense(cplx* psi, const cplx* u, const idx* o, idx DA,
+                             idx numruns, idx run, idx numfixed,
+                             const idx* fixed_strides, const idx* fixed_dims)
+{
+#ifdef QPP_X86_SIMD_
+    if (psi == nullptr || (DA != 2 && DA != 4))
+        return false;
+
+    SIMD isa = simd_isa();
+    if (isa == SIMD::AVX512 && run % 4 == 0)
+    {
+        parallel_chunks(numruns * (run / 4), [&](idx begin, idx end)
+        {
+            if (DA == 2)
+                simd_apply_dense_avx512<2>(psi, u, o, numfixed,
+                                           fixed_strides, fixed_dims, begin,
+                                           end);
+            else
+                simd_apply_dense_avx512<4>(psi, u, o, numfixed,
+                                           fixed_strides, fixed_dims, begin,
+                                           end);
+        });
+        return true;
+    }
+    if (isa != SIMD::NONE && run % 2 == 0)
+    {
+        parallel_chunks(numruns * (run / 2), [&](idx begin, idx end)
+        {
+            if (DA == 2)
+                simd_apply_dense_avx2<2>(psi, u, o, numfixed,
+                                         fixed_strides, fixed_dims, begin,
+                                         end);
+            else
+                simd_apply_dense_avx2<4>(psi, u, o, numfixed,
+                                         fixed_strides, fixed_dims, begin,
+                                         end);
+        });
+        return true;
+    }
+    if (isa != SIMD::NONE && DA == 2 && run == 1 && o[1] == o[0] + 1)
+    {
+        parallel_chunks(numruns, [&](idx begin, idx end)
+        {
+            simd_apply_pair_avx2(psi, u, o[0], numfixed, fixed_strides,
+                                 fixed_dims, begin, end);
+        });
+        return true;
+    }
+#else
+    (void) psi; (void) u; (void) o; (void) DA; (void) numruns; (void) run;
+    (void) numfixed; (void) fixed_strides; (void) fixed_dims;
+#endif // QPP_X86_SIMD_
+
+    return false;
+}
+
+// vectorized diagonal gate, multiplies psi[base + o[k]] by p[k];
+// returns false if no vectorized kernel applies, in which case nothing is done
+template<typename Scalar>
+bool simd_apply_diagonal(Scalar*, const idx*, const Scalar*, idx, idx, idx,
+                         idx, const idx*, const idx*)
+{
+    return false;
+}
+
+inline bool simd_apply_diagonal(cplx* psi, const idx* o, const cplx* p,
+                                idx np, idx numruns, idx run, idx numfixed,
+                                const idx* fixed_strides,
+                                const idx* fixed_dims)
+{
+#ifdef QPP_X86_SIMD_
+    if (psi == nullptr)
+        return false;
+
+    SIMD isa = simd_isa();
+    if (isa == SIMD::AVX512 && run % 4 == 0)
+    {
+        parallel_chunks(numruns * (run / 4), [&](idx begin, idx end)
+        {
+            simd_apply_diagonal_avx512(psi, o, p, np, numfixed,
+                                       fixed_strides, fixed_dims, begin, end);
+        });
+        return true;
+    }
+    if (isa != SIMD::NONE && run % 2 == 0)
+    {
+        parallel_chunks(numruns * (run / 2), [&](idx begin, idx end)
+        {
+            simd_apply_diagonal_avx2(psi, o, p, np, numfixed,
+                                     fixed_strides, fixed_dims, begin, end);
+        });
+        return true;
+    }
+#else
+    (void) psi; (void) o; (void) p; (void) np; (void) numruns; (void) run;
+    (void) numfixed; (void) fixed_strides; (void) fixed_dims;
+#endif // QPP_X86_SIMD_
+
+    return false;
+}
+
+} /* namespace internal */
+} /* namespace qpp */
+
+#endif /* INTERNAL_SIMD_H_ */
@@ -79,6 +79,92 @@ noexcept
     return result + midx[numdims - 1];
 }
 
+// strides of the subsystems, use C-style array for speed
+// standard lexicographical order, i.e. the last subsystem has unit stride
+inline void dims2strides(const idx* dims, idx numdims, idx* strides) noexcept
+{
+    // no error checks to improve speed
+    idx stride = 1;
+    for (idx i = 0; i < numdims; ++i)
+    {
+        strides[numdims - i - 1] = stride;
+        stride *= dims[numdims - i - 1];
+    }
+}
+
+// index of the first amplitude of the r-th group of amplitudes, obtained by
+// inserting zero digits at the fixed positions (e.g. the control and target
+// subsystems) in the rest index r; the fixed positions must be sorted
+// in increasing order of their strides
+inline idx insert_zero_digits(idx r, idx numfixed, const idx* fixed_strides,
+                              const idx* fixed_dims) noexcept
+{
+    // no error checks to improve speed
+    for (idx k = 0; k < numfixed; ++k)
+        r = (r / fixed_strides[k]) * fixed_strides[k] * fixed_dims[k]
+            + r % fixed_strides[k];
+
+    return r;
+}
+
+// qpp::internal::insert_zero_digits() of the consecutive rest indexes
+// r, r + step, r + 2 * step, ..., updated incrementally with no division:
+// the index moves by step, and a countdown per fixed position tells when the
+// carry reaches it, in which case the fixed digit is skipped; the run of the
+// smallest fixed stride must be a multiple of step
+class ZeroDigitsIndex
+{
+    idx numfixed_;       // number of fixed positions
+    idx skips_[maxn];    // (fixed_dims[k] - 1) * fixed_strides[k]
+    idx periods_[maxn];  // steps per run for k = 0, carries from the fixed
+                         // position k - 1 per carry into k otherwise
+    idx left_[maxn];     // countdowns, the carry reaches k when left_[k] = 0
+    idx step_;           // increment of the rest index
+    idx base_;           // current index
+
+public:
+    ZeroDigitsIndex(idx r, idx numfixed, const idx* fixed_strides,
+                    const idx* fixed_dims, idx step = 1) noexcept :
+            numfixed_{numfixed}, skips_{}, periods_{}, left_{}, step_{step},
+            base_{insert_zero_digits(r, numfixed, fixed_strides, fixed_dims)}
+    {
+        // no error checks to improve speed
+        for (idx k = 0; k < numfixed; ++k)
+        {
+            skips_[k] = (fixed_dims[k] - 1) * fixed_strides[k];
+            if (k == 0)
+            {
+                periods_[k] = fixed_strides[k] / step;
+                left_[k] = periods_[k] - (base_ % fixed_strides[k]) / step;
+            } else
+            {
+                idx low = fixed_strides[k - 1] * fixed_dims[k - 1];
+                periods_[k] = fixed_strides[k] / low;
+                left_[k] = periods_[k] - (base_ / low) % periods_[k];
+            }
+        }
+    }
+
+    // index of the current rest index
+    idx operator()() const noexcept
+    {
+        return base_;
+    }
+
+    // moves to the next rest index
+    ZeroDigitsIndex& operator++() noexcept
+    {
+        base_ += step_;
+        for (idx k = 0; k < numfixed_ && --left_[k] == 0; ++k)
+        {
+            left_[k] = periods_[k];
+            base_ += skips_[k];
+        }
+
+        return *this;
+    }
+};
+
 // check square matrix
 template<typename Derived>
 bool check_square_mat(const Eigen::MatrixBase<Derived>& A)
@@ -86,6 +172,45 @@ bool check_square_mat(const Eigen::MatrixBase<Derived>& A)
     return A.rows() == A.cols();
 }
 
+// check whether the square matrix A is diagonal,
+// i.e. all off-diagonal elements are exactly zero
+template<typename Derived>
+bool check_diagonal(const Eigen::MatrixBase<Derived>& A)
+{
+    for (idx j = 0; j < static_cast<idx>(A.cols()); ++j)
+        for (idx i = 0; i < static_cast<idx>(A.rows()); ++i)
+            if (i != j && A(i, j) != static_cast<typename Derived::Scalar>(0))
+                return false;
+
+    return true;
+}
+
+// check whether the square matrix A is monomial, i.e. has exactly one
+// non-zero element in each row and each column (e.g. a permutation matrix)
+template<typename Derived>
+bool check_monomial(const Eigen::MatrixBase<Derived>& A)
+{
+    idx D = static_cast<idx>(A.rows());
+    std::vector<idx> row_count(D, 0);
+    for (idx j = 0; j < D; ++j)
+    {
+        idx col_count = 0;
+        for (idx i = 0; i < D; ++i)
+            if (A(i, j) != static_cast<typename Derived::Scalar>(0))
+            {
+                ++col_count;
+                ++row_count[i];
+            }
+        if (col_count != 1)
+            return false;
+    }
+    for (idx i = 0; i < D; ++i)
+        if (row_count[i] != 1)
+            return false;
+
+    return true;
+}
+
 // check whether input is a vector or not
 template<typename Derived>
 bool check_vector(const Eigen::MatrixBase<Derived>& A)
@@ -284,12 +409,11 @@ dyn_mat<typename Derived1::Scalar> kron2(const Eigen::MatrixBase<Derived1>& A,
     dyn_mat<typename Derived1::Scalar> result;
     result.resize(Arows * Brows, Acols * Bcols);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-    for (idx j = 0; j < Acols; ++j) // column major order for speed
-        for (idx i = 0; i < Arows; ++i)
-            result.block(i * Brows, j * Bcols, Brows, Bcols) = rA(i, j) * rB;
+    // column major order for speed, one block of rB per iteration
+    parallel_for(Acols, Arows, [&](idx j, idx i)
+    {
+        result.block(i * Brows, j * Bcols, Brows, Bcols) = rA(i, j) * rB;
+    }, std::max<idx>(1, parallel_config().grain / (Brows * Bcols)));
 
     return result;
 }
@@ -350,6 +474,204 @@ void variadic_vector_emplace(std::vector<T>& v, First&& first, Args&& ... args)
     variadic_vector_emplace(v, std::forward<Args>(args)...);
 }
 
+// index of the basis state of the subsystems subsys, i.e. of the
+// computational-basis measurement outcome, for consecutive basis indexes of
+// the whole system, updated digit by digit with no division; the outcomes
+// are ordered as in qpp::measure(), i.e. the last subsystem of subsys varies
+// fastest
+class SubsysIndex
+{
+    idx N_;             // number of subsystems
+    idx dims_[maxn];    // subsystem dimensions
+    idx weights_[maxn]; // weight of each digit in the outcome, 0 outside subsys
+    idx midx_[maxn];    // digits of the current basis index
+    idx m_;             // current outcome
+
+public:
+    // starts at the basis index i; if numdigits is less than the number of
+    // subsystems, only the leading numdigits subsystems are walked, i.e. i
+    // and the increments count blocks of the trailing subsystems, whose
+    // contribution to the outcome is left out
+    SubsysIndex(const std::vector<idx>& subsys, const std::vector<idx>& dims,
+                idx i, idx numdigits = maxn) :
+            N_{std::min(numdigits, static_cast<idx>(dims.size()))}, dims_{},
+            weights_{}, midx_{}, m_{0}
+    {
+        // no error checks to improve speed
+        for (idx k = 0; k < dims.size(); ++k)
+            dims_[k] = dims[k];
+        idx weight = 1;
+        for (idx k = subsys.size(); k-- > 0;)
+        {
+            weights_[subsys[k]] = weight;
+            weight *= dims[subsys[k]];
+        }
+
+        n2multiidx(i, N_, dims_, midx_);
+        for (idx k = 0; k < N_; ++k)
+            m_ += midx_[k] * weights_[k];
+    }
+
+    // outcome of the current basis index
+    idx operator()() const noexcept
+    {
+        return m_;
+    }
+
+    // weight of the k-th subsystem in the outcome, 0 if not in subsys
+    idx weight(idx k) const noexcept
+    {
+        return weights_[k];
+    }
+
+    // moves to the next basis index
+    SubsysIndex& operator++() noexcept
+    {
+        for (idx k = N_; k-- > 0;)
+        {
+            if (++midx_[k] < dims_[k])
+            {
+                m_ += weights_[k];
+                break;
+            }
+            midx_[k] = 0;
+            m_ -= (dims_[k] - 1) * weights_[k];
+        }
+
+        return *this;
+    }
+};
+
+// computational-basis distribution of the subsystems subsys, in one pass
+// over the D basis states, where w(i) is the weight of the i-th basis state
+// (e.g. |psi_i|^2), using per-thread partial histograms; the outcomes are
+// ordered as in qpp::internal::SubsysIndex
+template<typename F>
+std::vector<double> marginal_probs(const F& w, const std::vector<idx>& subsys,
+                                   const std::vector<idx>& dims)
+{
+    // no error checks to improve speed
+    idx N = dims.size();
+    idx D = 1, Dsubsys = 1;
+    for (idx k = 0; k < N; ++k)
+        D *= dims[k];
+    for (idx k = 0; k < subsys.size(); ++k)
+        Dsubsys *= dims[subsys[k]];
+
+    // the trailing subsystems form blocks of at most a grain of contiguous
+    // basis states (enough blocks are left for the threads), whose outcomes
+    // differ from the one of the first state of the block by the same
+    // offsets from one block to the next; if the offsets are all 0, i.e. the
+    // trailing subsystems are not in subsys, the block is simply summed
+    SubsysIndex weights(subsys, dims, 0);
+    idx numdigits = N, block = 1;
+    while (numdigits > 0 &&
+           block * dims[numdigits - 1] <= parallel_config().grain)
+        block *= dims[--numdigits];
+    idx numtrailing = N - numdigits;
+    bool summed = true;
+    for (idx k = numdigits; k < N; ++k)
+        summed = summed && weights.weight(k) == 0;
+    std::vector<idx> offsets(block, 0);
+    idx midx[maxn];
+    for (idx j = 0; j < block; ++j)
+    {
+        n2multiidx(j, numtrailing, dims.data() + numdigits, midx);
+        for (idx k = 0; k < numtrailing; ++k)
+            offsets[j] += midx[k] * weights.weight(numdigits + k);
+    }
+
+    return parallel_reduce_chunks(D / block, std::vector<double>(Dsubsys, 0),
+                                  [&](idx begin, idx end,
+                                      std::vector<double>& partial)
+    {
+        SubsysIndex m(subsys, dims, begin, numdigits);
+        for (idx r = begin; r < end; ++r, ++m)
+        {
+            idx i = r * block;
+            if (summed)
+            {
+                double sum = 0;
+                for (idx j = 0; j < block; ++j)
+                    sum += w(i + j);
+                partial[m()] += sum;
+            } else
+            {
+                double* p = &partial[m()];
+                for (idx j = 0; j < block; ++j)
+                    p[offsets[j]] += w(i + j);
+            }
+        }
+    }, [](std::vector<double>& result, const std::vector<double>& partial)
+    {
+        for (idx m = 0; m < result.size(); ++m)
+            result[m] += partial[m];
+    }, std::max<idx>(1, parallel_config().grain / block));
+}
+
+// Walker/Vose alias table of a discrete distribution, O(1) per draw
+struct AliasTable
+{
+    std::vector<double> keep; // probability of keeping the drawn column
+    std::vector<idx> alias;   // outcome taken otherwise
+};
+
+// builds the alias table of the (not necessarily normalized) weights prob,
+// in O(prob.size()) time
+inline AliasTable alias_table(const std::vector<double>& prob)
+{
+    // no error checks to improve speed
+    idx n = prob.size();
+    double sum = std::accumulate(std::begin(prob), std::end(prob), 0.);
+
+    AliasTable result{std::vector<double>(n, 1), std::vector<idx>(n)};
+    std::vector<double> scaled(n);
+    std::vector<idx> small, large;
+    for (idx j = 0; j < n; ++j)
+    {
+        result.alias[j] = j;
+        scaled[j] = prob[j] * n / sum;
+        if (scaled[j] < 1)
+            small.push_back(j);
+        else
+            large.push_back(j);
+    }
+
+    // pairs each column below the average with one above it
+    while (!small.empty() && !large.empty())
+    {
+        idx s = small.back(), l = large.back();
+        small.pop_back();
+        result.keep[s] = scaled[s];
+        result.alias[s] = l;
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // the rest are kept with probability 1, up to rounding errors
+
+    return result;
+}
+
+// draws an outcome from the alias table with the random engine gen
+template<typename Engine>
+idx alias_draw(const AliasTable& table, Engine& gen)
+{
+    idx n = table.keep.size();
+    std::uniform_real_distribution<double> ud(0, static_cast<double>(n));
+    double x = ud(gen);
+    idx j = std::min(static_cast<idx>(x), n - 1);
+
+    return x - j < table.keep[j] ? j : table.alias[j];
+}
+
+// number of shots drawn from each independent random stream, fixed so that
+// the samples do not depend on the number of threads
+constexpr idx shots_per_stream = 16384;
+
 // returns the number of subsystems (each subsystem assumed of the same
 // dimension d) from an object (ket/bra/density matrix) of size sz
 inline idx get_num_subsys(idx sz, idx d)
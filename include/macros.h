@@ -48,4 +48,13 @@
 #define ERRORLN(x)
 #endif
 
+// AVX2/AVX-512 gate kernels for x86-64 with GCC/Clang, dispatched at runtime
+// from CPUID, so no special compiler flags are needed; define NO_SIMD_ to
+// always use the portable scalar kernels
+#if !defined(NO_SIMD_) && (defined(__GNUC__) || defined(__clang__)) && \
+    defined(__x86_64__)
+/*! Enables the vectorized x86 kernels */
+#define QPP_X86_SIMD_
+#endif
+
 #endif /* MACROS_H_ */
\ No newline at end of file
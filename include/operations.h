@@ -34,10 +34,154 @@
 
 namespace qpp
 {
+/**
+* \brief Applies in place the controlled-gate \a A to the part \a subsys
+* of the multi-partite state vector \a state
+* \see qpp::applyCTRL(), qpp::Gates::CTRL(), qpp::GatePlan
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys.
+* Also, all control subsystems in \a ctrl must have the same dimension.
+*
+* \note Builds a qpp::GatePlan on each call; construct the plan once and use
+* qpp::GatePlan::execute() when applying the same gate repeatedly.
+*
+* \note Only the amplitudes on which the gate acts non-trivially are
+* overwritten, i.e. the ones for which all controls are in the same state
+* \f$|i\rangle\f$ with \f$A^i\neq I\f$. No copy of \a state is made.
+* If \a A is diagonal, only the amplitudes picking up a non-unit phase are
+* rescaled. If \a A is monomial (e.g. a permutation), the amplitudes are
+* moved along the cycles of the permutation, with no multiplications in the
+* case of permutation matrices.
+*
+* \param state Column vector, overwritten with the result
+* \param A Eigen expression
+* \param ctrl Control subsystem indexes
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param dims Dimensions of the multi-partite system
+*/
+template<typename Derived1, typename Derived2>
+void applyCTRL_inplace(Eigen::MatrixBase<Derived1>& state,
+                       const Eigen::MatrixBase<Derived2>& A,
+                       const std::vector<idx>& ctrl,
+                       const std::vector<idx>& subsys,
+                       const std::vector<idx>& dims)
+{
+    // EXCEPTION CHECKS
+
+    // check types
+    if (!std::is_same<typename Derived1::Scalar,
+            typename Derived2::Scalar>::value)
+        throw Exception("qpp::applyCTRL_inplace()",
+                        Exception::Type::TYPE_MISMATCH);
+    // END EXCEPTION CHECKS
+
+    // the remaining checks are done by the plan
+    GatePlan<typename Derived1::Scalar>(A, ctrl, subsys, dims).execute(state);
+}
+
+/**
+* \brief Applies in place the controlled-gate \a A to the part \a subsys
+* of the multi-partite state vector \a state
+* \see qpp::applyCTRL(), qpp::Gates::CTRL()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param state Column vector, overwritten with the result
+* \param A Eigen expression
+* \param ctrl Control subsystem indexes
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param d Subsystem dimensions
+*/
+template<typename Derived1, typename Derived2>
+void applyCTRL_inplace(Eigen::MatrixBase<Derived1>& state,
+                       const Eigen::MatrixBase<Derived2>& A,
+                       const std::vector<idx>& ctrl,
+                       const std::vector<idx>& subsys,
+                       idx d = 2)
+{
+    // EXCEPTION CHECKS
+
+    // check zero size
+    if (!internal::check_nonzero_size(state))
+        throw Exception("qpp::applyCTRL_inplace()",
+                        Exception::Type::ZERO_SIZE);
+
+    // check valid dims
+    if (d == 0)
+        throw Exception("qpp::applyCTRL_inplace()",
+                        Exception::Type::DIMS_INVALID);
+    // END EXCEPTION CHECKS
+
+    idx N = internal::get_num_subsys(static_cast<idx>(state.rows()), d);
+    std::vector<idx> dims(N, d); // local dimensions vector
+
+    applyCTRL_inplace(state, A, ctrl, subsys, dims);
+}
+
+/**
+* \brief Applies in place the gate \a A to the part \a subsys
+* of the multi-partite state vector \a state
+* \see qpp::apply()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param state Column vector, overwritten with the result
+* \param A Eigen expression
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param dims Dimensions of the multi-partite system
+*/
+template<typename Derived1, typename Derived2>
+void apply_inplace(Eigen::MatrixBase<Derived1>& state,
+                   const Eigen::MatrixBase<Derived2>& A,
+                   const std::vector<idx>& subsys,
+                   const std::vector<idx>& dims)
+{
+    applyCTRL_inplace(state, A, {}, subsys, dims);
+}
+
+/**
+* \brief Applies in place the gate \a A to the part \a subsys
+* of the multi-partite state vector \a state
+* \see qpp::apply()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param state Column vector, overwritten with the result
+* \param A Eigen expression
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param d Subsystem dimensions
+*/
+template<typename Derived1, typename Derived2>
+void apply_inplace(Eigen::MatrixBase<Derived1>& state,
+                   const Eigen::MatrixBase<Derived2>& A,
+                   const std::vector<idx>& subsys,
+                   idx d = 2)
+{
+    // EXCEPTION CHECKS
+
+    // check zero size
+    if (!internal::check_nonzero_size(state))
+        throw Exception("qpp::apply_inplace()", Exception::Type::ZERO_SIZE);
+
+    // check valid dims
+    if (d == 0)
+        throw Exception("qpp::apply_inplace()", Exception::Type::DIMS_INVALID);
+    // END EXCEPTION CHECKS
+
+    idx N = internal::get_num_subsys(static_cast<idx>(state.rows()), d);
+    std::vector<idx> dims(N, d); // local dimensions vector
+
+    applyCTRL_inplace(state, A, {}, subsys, dims);
+}
+
 /**
 * \brief Applies the controlled-gate \a A to the part \a subsys
 * of the multi-partite state vector or density matrix \a state
-* \see qpp::Gates::CTRL()
+* \see qpp::Gates::CTRL(), qpp::applyCTRL_inplace()
 *
 * \note The dimension of the gate \a A must match
 * the dimension of \a subsys.
@@ -117,231 +261,10 @@ dyn_mat<typename Derived1::Scalar> applyCTRL(
                         Exception::Type::SUBSYS_MISMATCH_DIMS);
     // END EXCEPTION CHECKS
 
-    // construct the table of A^i and (A^dagger)^i
-    std::vector<dyn_mat<typename Derived1::Scalar>> Ai;
-    std::vector<dyn_mat<typename Derived1::Scalar>> Aidagger;
-    for (idx i = 0; i < std::max(d, static_cast<idx>(2)); ++i)
-    {
-        Ai.push_back(powm(rA, i));
-        Aidagger.push_back(powm(adjoint(rA), i));
-    }
-
     idx D = static_cast<idx>(rstate.rows()); // total dimension
     idx N = dims.size();                // total number of subsystems
     idx ctrlsize = ctrl.size();         // number of ctrl subsystem
-    idx ctrlgatesize = ctrlgate.size(); // number of ctrl+gate subsystems
     idx subsyssize = subsys.size();     // number of subsystems of the target
-    // dimension of ctrl subsystem
-    idx Dctrl = static_cast<idx>(std::llround(std::pow(d, ctrlsize)));
-    idx DA = static_cast<idx>(rA.rows()); // dimension of gate subsystem
-
-    idx Cdims[maxn];         // local dimensions
-    idx CdimsA[maxn];        // local dimensions
-    idx CdimsCTRL[maxn];     // local dimensions
-    idx CdimsCTRLA_bar[maxn]; // local dimensions
-
-    // compute the complementary subsystem of ctrlgate w.r.t. dims
-    std::vector<idx> ctrlgate_bar = complement(ctrlgate, N);
-    // number of subsystems that are complementary to the ctrl+gate
-    idx ctrlgate_barsize = ctrlgate_bar.size();
-
-    idx DCTRLA_bar = 1; // dimension of the rest
-    for (idx i = 0; i < ctrlgate_barsize; ++i)
-        DCTRLA_bar *= dims[ctrlgate_bar[i]];
-
-    for (idx k = 0; k < N; ++k)
-        Cdims[k] = dims[k];
-    for (idx k = 0; k < subsyssize; ++k)
-        CdimsA[k] = dims[subsys[k]];
-    for (idx k = 0; k < ctrlsize; ++k)
-        CdimsCTRL[k] = d;
-    for (idx k = 0; k < ctrlgate_barsize; ++k)
-        CdimsCTRLA_bar[k] = dims[ctrlgate_bar[k]];
-
-    // worker, computes the coefficient and the index for the ket case
-    // used in #pragma omp parallel for collapse
-    auto coeff_idx_ket = [&](idx i_, idx m_, idx r_) noexcept
-            -> std::pair<typename Derived1::Scalar, idx>
-    {
-        idx indx = 0;
-        typename Derived1::Scalar coeff = 0;
-
-        idx Cmidx[maxn];         // the total multi-index
-        idx CmidxA[maxn];        // the gate part multi-index
-        idx CmidxCTRLA_bar[maxn]; // the rest multi-index
-
-        // compute the index
-
-        // set the CTRL part
-        for (idx k = 0; k < ctrlsize; ++k)
-        {
-            Cmidx[ctrl[k]] = i_;
-        }
-
-        // set the rest
-        internal::n2multiidx(r_, N - ctrlgatesize,
-                              CdimsCTRLA_bar, CmidxCTRLA_bar);
-        for (idx k = 0; k < N - ctrlgatesize; ++k)
-        {
-            Cmidx[ctrlgate_bar[k]] = CmidxCTRLA_bar[k];
-        }
-
-        // set the A part
-        internal::n2multiidx(m_, subsyssize, CdimsA, CmidxA);
-        for (idx k = 0; k < subsyssize; ++k)
-        {
-            Cmidx[subsys[k]] = CmidxA[k];
-        }
-
-        // we now got the total index
-        indx = internal::multiidx2n(Cmidx, N, Cdims);
-
-        // compute the coefficient
-        for (idx n_ = 0; n_ < DA; ++n_)
-        {
-            internal::n2multiidx(n_, subsyssize, CdimsA, CmidxA);
-            for (idx k = 0; k < subsyssize; ++k)
-            {
-                Cmidx[subsys[k]] = CmidxA[k];
-            }
-            coeff += Ai[i_](m_, n_) *
-                     rstate(internal::multiidx2n(Cmidx, N, Cdims));
-        }
-
-        return std::make_pair(coeff, indx);
-    }; /* end coeff_idx_ket */
-
-    // worker, computes the coefficient and the index
-    // for the density matrix case
-    // used in #pragma omp parallel for collapse
-    auto coeff_idx_rho = [&](idx i1_, idx m1_,
-                             idx r1_, idx i2_, idx m2_, idx r2_) noexcept
-            -> std::tuple<typename Derived1::Scalar, idx, idx>
-    {
-        idx idxrow = 0;
-        idx idxcol = 0;
-        typename Derived1::Scalar coeff = 0, lhs = 1, rhs = 1;
-
-        idx Cmidxrow[maxn];         // the total row multi-index
-        idx Cmidxcol[maxn];         // the total col multi-index
-        idx CmidxArow[maxn];        // the gate part row multi-index
-        idx CmidxAcol[maxn];        // the gate part col multi-index
-        idx CmidxCTRLrow[maxn];     // the control row multi-index
-        idx CmidxCTRLcol[maxn];     // the control col multi-index
-        idx CmidxCTRLA_barrow[maxn]; // the rest row multi-index
-        idx CmidxCTRLA_barcol[maxn]; // the rest col multi-index
-
-        // compute the ket/bra indexes
-
-        // set the CTRL part
-        internal::n2multiidx(i1_, ctrlsize,
-                              CdimsCTRL, CmidxCTRLrow);
-        internal::n2multiidx(i2_, ctrlsize,
-                              CdimsCTRL, CmidxCTRLcol);
-
-        for (idx k = 0; k < ctrlsize; ++k)
-        {
-            Cmidxrow[ctrl[k]] = CmidxCTRLrow[k];
-            Cmidxcol[ctrl[k]] = CmidxCTRLcol[k];
-        }
-
-        // set the rest
-        internal::n2multiidx(r1_, N - ctrlgatesize,
-                              CdimsCTRLA_bar, CmidxCTRLA_barrow);
-        internal::n2multiidx(r2_, N - ctrlgatesize,
-                              CdimsCTRLA_bar, CmidxCTRLA_barcol);
-        for (idx k = 0; k < N - ctrlgatesize; ++k)
-        {
-            Cmidxrow[ctrlgate_bar[k]] = CmidxCTRLA_barrow[k];
-            Cmidxcol[ctrlgate_bar[k]] = CmidxCTRLA_barcol[k];
-        }
-
-        // set the A part
-        internal::n2multiidx(m1_, subsyssize, CdimsA, CmidxArow);
-        internal::n2multiidx(m2_, subsyssize, CdimsA, CmidxAcol);
-        for (idx k = 0; k < subsys.size(); ++k)
-        {
-            Cmidxrow[subsys[k]] = CmidxArow[k];
-            Cmidxcol[subsys[k]] = CmidxAcol[k];
-        }
-
-        // we now got the total row/col indexes
-        idxrow = internal::multiidx2n(Cmidxrow, N, Cdims);
-        idxcol = internal::multiidx2n(Cmidxcol, N, Cdims);
-
-        // check whether all CTRL row and col multi indexes are equal
-        bool all_ctrl_rows_equal = true;
-        bool all_ctrl_cols_equal = true;
-
-        idx first_ctrl_row, first_ctrl_col;
-        if (ctrlsize > 0)
-        {
-            first_ctrl_row = CmidxCTRLrow[0];
-            first_ctrl_col = CmidxCTRLcol[0];
-        } else
-        {
-            first_ctrl_row = first_ctrl_col = 1;
-        }
-
-        for (idx k = 1; k < ctrlsize; ++k)
-        {
-            if (CmidxCTRLrow[k] != first_ctrl_row)
-            {
-                all_ctrl_rows_equal = false;
-                break;
-            }
-        }
-        for (idx k = 1; k < ctrlsize; ++k)
-        {
-            if (CmidxCTRLcol[k] != first_ctrl_col)
-            {
-                all_ctrl_cols_equal = false;
-                break;
-            }
-        }
-
-        // at least one control activated, compute the coefficient
-        for (idx n1_ = 0; n1_ < DA; ++n1_)
-        {
-            internal::n2multiidx(n1_, subsyssize, CdimsA, CmidxArow);
-            for (idx k = 0; k < subsyssize; ++k)
-            {
-                Cmidxrow[subsys[k]] = CmidxArow[k];
-            }
-            idx idxrowtmp = internal::multiidx2n(Cmidxrow, N, Cdims);
-
-            if (all_ctrl_rows_equal)
-            {
-                lhs = Ai[first_ctrl_row](m1_, n1_);
-            } else
-            {
-                lhs = (m1_ == n1_) ? 1 : 0; // identity matrix
-            }
-
-            for (idx n2_ = 0; n2_ < DA; ++n2_)
-            {
-                internal::n2multiidx(n2_, subsyssize, CdimsA, CmidxAcol);
-                for (idx k = 0; k < subsyssize; ++k)
-                {
-                    Cmidxcol[subsys[k]] = CmidxAcol[k];
-                }
-
-                if (all_ctrl_cols_equal)
-                {
-                    rhs = Aidagger[first_ctrl_col](n2_, m2_);
-                } else
-                {
-                    rhs = (n2_ == m2_) ? 1 : 0; // identity matrix
-                }
-
-                idx idxcoltmp = internal::multiidx2n(Cmidxcol, N, Cdims);
-
-                coeff += lhs * rstate(idxrowtmp, idxcoltmp) * rhs;
-            }
-        }
-
-        return std::make_tuple(coeff, idxrow, idxcol);
-    }; /* end coeff_idx_rho */
 
     //************ ket ************//
     if (internal::check_cvector(rstate)) // we have a ket
@@ -353,25 +276,9 @@ dyn_mat<typename Derived1::Scalar> applyCTRL(
         if (D == 1)
             return rstate;
 
-        dyn_mat<typename Derived1::Scalar> result = rstate;
-
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-        for (idx m = 0; m < DA; ++m)
-            for (idx r = 0; r < DCTRLA_bar; ++r)
-            {
-                if (ctrlsize == 0) // no control
-                {
-                    result(coeff_idx_ket(1, m, r).second) =
-                            coeff_idx_ket(1, m, r).first;
-                } else
-                    for (idx i = 0; i < d; ++i)
-                    {
-                        result(coeff_idx_ket(i, m, r).second) =
-                                coeff_idx_ket(i, m, r).first;
-                    }
-            }
+        dyn_mat<typename Derived1::Scalar> result =
+                internal::numa_copy(rstate);
+        applyCTRL_inplace(result, rA, ctrl, subsys, dims);
 
         return result;
     }
@@ -386,35 +293,59 @@ dyn_mat<typename Derived1::Scalar> applyCTRL(
         if (D == 1)
             return rstate;
 
-        dyn_mat<typename Derived1::Scalar> result = rstate;
-
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(4)
-#endif // WITH_OPENMP_
-        for (idx m1 = 0; m1 < DA; ++m1)
-            for (idx r1 = 0; r1 < DCTRLA_bar; ++r1)
-                for (idx m2 = 0; m2 < DA; ++m2)
-                    for (idx r2 = 0; r2 < DCTRLA_bar; ++r2)
-                        if (ctrlsize == 0) // no control
-                        {
-                            auto coeff_idxes = coeff_idx_rho(1, m1, r1,
-                                                             1, m2, r2);
-                            result(std::get<1>(coeff_idxes),
-                                   std::get<2>(coeff_idxes)) =
-                                    std::get<0>(coeff_idxes);
-                        } else
-                        {
-                            for (idx i1 = 0; i1 < Dctrl; ++i1)
-                                for (idx i2 = 0; i2 < Dctrl; ++i2)
-                                {
-                                    auto coeff_idxes = coeff_idx_rho(
-                                            i1, m1, r1,
-                                            i2, m2, r2);
-                                    result(std::get<1>(coeff_idxes),
-                                           std::get<2>(coeff_idxes)) =
-                                            std::get<0>(coeff_idxes);
-                                }
-                        }
+        // diagonal gate, then CTRL-A is diagonal too; get its diagonal by
+        // applying it to the all-ones vector, then rescale rows and columns
+        if (internal::check_diagonal(rA))
+        {
+            dyn_col_vect<typename Derived1::Scalar> phases =
+                    dyn_col_vect<typename Derived1::Scalar>::Ones(D);
+            applyCTRL_inplace(phases, rA, ctrl, subsys, dims);
+
+            return phases.asDiagonal() * rstate *
+                   phases.conjugate().asDiagonal();
+        }
+
+        dyn_mat<typename Derived1::Scalar> result =
+                internal::numa_copy(rstate);
+
+        // rho -> CTRL-A rho CTRL-A^dagger in two sweeps over rho, seen as the
+        // column-major vectorization of a 2N-partite ket (column subsystems
+        // first): CTRL-A acts on the row subsystems, then
+        // conj(CTRL-A) = CTRL-conj(A) on the column subsystems
+        if (2 * N <= maxn)
+        {
+            std::vector<idx> dims2 = dims;
+            dims2.insert(std::end(dims2), std::begin(dims), std::end(dims));
+            std::vector<idx> ctrl2(ctrlsize);
+            std::vector<idx> subsys2(subsyssize);
+            for (idx k = 0; k < ctrlsize; ++k)
+                ctrl2[k] = ctrl[k] + N;
+            for (idx k = 0; k < subsyssize; ++k)
+                subsys2[k] = subsys[k] + N;
+
+            Eigen::Map<dyn_col_vect<typename Derived1::Scalar>> vrho(
+                    result.data(), D * D);
+            GatePlan<typename Derived1::Scalar>(
+                    rA, ctrl2, subsys2, dims2).execute(vrho);
+            GatePlan<typename Derived1::Scalar>(
+                    dyn_mat<typename Derived1::Scalar>(rA.conjugate()),
+                    ctrl, subsys, dims2).execute(vrho);
+
+            return result;
+        }
+
+        // too many subsystems for a 2N-partite ket, sweep the columns of
+        // rho, then the columns of (CTRL-A rho)^dagger
+        GatePlan<typename Derived1::Scalar> plan(rA, ctrl, subsys, dims);
+        for (idx pass = 0; pass < 2; ++pass)
+        {
+            parallel_for(D, [&](idx c)
+            {
+                auto col = result.col(c);
+                plan.execute(col);
+            }, 1);
+            result.adjointInPlace();
+        }
 
         return result;
     }
@@ -596,6 +527,141 @@ dyn_mat<typename Derived1::Scalar> apply(
     return apply(rstate, rA, subsys, dims);
 }
 
+/**
+* \brief Applies the controlled-gate \a A to the part \a subsys
+* of each multi-partite state vector in the batch \a states
+* \see qpp::applyCTRL(), qpp::GatePlan::execute_batch()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys.
+* Also, all control subsystems in \a ctrl must have the same dimension.
+*
+* \param states Eigen expression, matrix whose columns are state vectors
+* \param A Eigen expression
+* \param ctrl Control subsystem indexes
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param dims Dimensions of the multi-partite system
+* \return Matrix whose columns are the CTRL-A gate applied to the part
+* \a subsys of the columns of \a states
+*/
+template<typename Derived1, typename Derived2>
+dyn_mat<typename Derived1::Scalar> applyCTRL_batch(
+        const Eigen::MatrixBase<Derived1>& states,
+        const Eigen::MatrixBase<Derived2>& A,
+        const std::vector<idx>& ctrl,
+        const std::vector<idx>& subsys,
+        const std::vector<idx>& dims)
+{
+    // EXCEPTION CHECKS
+
+    // check types
+    if (!std::is_same<typename Derived1::Scalar,
+            typename Derived2::Scalar>::value)
+        throw Exception("qpp::applyCTRL_batch()",
+                        Exception::Type::TYPE_MISMATCH);
+    // END EXCEPTION CHECKS
+
+    // the remaining checks are done by the plan
+    dyn_mat<typename Derived1::Scalar> result =
+            internal::numa_copy(states.derived());
+    GatePlan<typename Derived1::Scalar>(A, ctrl, subsys, dims)
+            .execute_batch(result);
+
+    return result;
+}
+
+/**
+* \brief Applies the controlled-gate \a A to the part \a subsys
+* of each multi-partite state vector in the batch \a states
+* \see qpp::applyCTRL(), qpp::GatePlan::execute_batch()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param states Eigen expression, matrix whose columns are state vectors
+* \param A Eigen expression
+* \param ctrl Control subsystem indexes
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param d Subsystem dimensions
+* \return Matrix whose columns are the CTRL-A gate applied to the part
+* \a subsys of the columns of \a states
+*/
+template<typename Derived1, typename Derived2>
+dyn_mat<typename Derived1::Scalar> applyCTRL_batch(
+        const Eigen::MatrixBase<Derived1>& states,
+        const Eigen::MatrixBase<Derived2>& A,
+        const std::vector<idx>& ctrl,
+        const std::vector<idx>& subsys,
+        idx d = 2)
+{
+    // EXCEPTION CHECKS
+
+    // check zero size
+    if (!internal::check_nonzero_size(states))
+        throw Exception("qpp::applyCTRL_batch()", Exception::Type::ZERO_SIZE);
+
+    // check valid dims
+    if (d == 0)
+        throw Exception("qpp::applyCTRL_batch()",
+                        Exception::Type::DIMS_INVALID);
+    // END EXCEPTION CHECKS
+
+    idx N = internal::get_num_subsys(static_cast<idx>(states.rows()), d);
+    std::vector<idx> dims(N, d); // local dimensions vector
+
+    return applyCTRL_batch(states, A, ctrl, subsys, dims);
+}
+
+/**
+* \brief Applies the gate \a A to the part \a subsys
+* of each multi-partite state vector in the batch \a states
+* \see qpp::apply(), qpp::GatePlan::execute_batch()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param states Eigen expression, matrix whose columns are state vectors
+* \param A Eigen expression
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param dims Dimensions of the multi-partite system
+* \return Matrix whose columns are the gate \a A applied to the part
+* \a subsys of the columns of \a states
+*/
+template<typename Derived1, typename Derived2>
+dyn_mat<typename Derived1::Scalar> apply_batch(
+        const Eigen::MatrixBase<Derived1>& states,
+        const Eigen::MatrixBase<Derived2>& A,
+        const std::vector<idx>& subsys,
+        const std::vector<idx>& dims)
+{
+    return applyCTRL_batch(states, A, {}, subsys, dims);
+}
+
+/**
+* \brief Applies the gate \a A to the part \a subsys
+* of each multi-partite state vector in the batch \a states
+* \see qpp::apply(), qpp::GatePlan::execute_batch()
+*
+* \note The dimension of the gate \a A must match
+* the dimension of \a subsys
+*
+* \param states Eigen expression, matrix whose columns are state vectors
+* \param A Eigen expression
+* \param subsys Subsystem indexes where the gate \a A is applied
+* \param d Subsystem dimensions
+* \return Matrix whose columns are the gate \a A applied to the part
+* \a subsys of the columns of \a states
+*/
+template<typename Derived1, typename Derived2>
+dyn_mat<typename Derived1::Scalar> apply_batch(
+        const Eigen::MatrixBase<Derived1>& states,
+        const Eigen::MatrixBase<Derived2>& A,
+        const std::vector<idx>& subsys,
+        idx d = 2)
+{
+    return applyCTRL_batch(states, A, {}, subsys, d);
+}
+
 /**
 * \brief Applies the channel specified by the set of Kraus operators \a Ks
 * to the density matrix \a rho
@@ -605,10 +671,11 @@ dyn_mat<typename Derived1::Scalar> apply(
 * \return Output density matrix after the action of the channel
 */
 template<typename Derived>
-cmat apply(const Eigen::MatrixBase<Derived>& rho,
-           const std::vector<cmat>& Ks)
+dyn_mat<typename Derived::Scalar> apply(
+        const Eigen::MatrixBase<Derived>& rho,
+        const std::vector<dyn_mat<typename Derived::Scalar>>& Ks)
 {
-    const cmat& rrho = rho.derived();
+    const dyn_mat<typename Derived::Scalar>& rrho = rho.derived();
 
     // EXCEPTION CHECKS
 
@@ -628,22 +695,121 @@ cmat apply(const Eigen::MatrixBase<Derived>& rho,
             throw Exception("qpp::apply()", Exception::Type::DIMS_NOT_EQUAL);
     // END EXCEPTION CHECKS
 
-    cmat result = cmat::Zero(rrho.rows(), rrho.rows());
+    dyn_mat<typename Derived::Scalar> result =
+            dyn_mat<typename Derived::Scalar>::Zero(rrho.rows(), rrho.rows());
+
+    // per-thread partial sums, reduced once at the end
+    return parallel_reduce(Ks.size(), result,
+            [&](idx i, dyn_mat<typename Derived::Scalar>& partial)
+            {
+                partial.noalias() += Ks[i] * rrho * adjoint(Ks[i]);
+            },
+            [](dyn_mat<typename Derived::Scalar>& sum,
+               const dyn_mat<typename Derived::Scalar>& partial)
+            {
+                sum += partial;
+            }, 1);
+}
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-    for (idx i = 0; i < Ks.size(); ++i)
+/**
+* \brief Applies the channel specified by the set of sparse Kraus operators
+* \a Ks to the density matrix \a rho
+*
+* \param rho Eigen expression
+* \param Ks Set of sparse Kraus operators
+* \return Output density matrix after the action of the channel
+*/
+template<typename Derived>
+dyn_mat<typename Derived::Scalar> apply(
+        const Eigen::MatrixBase<Derived>& rho,
+        const std::vector<dyn_sp_mat<typename Derived::Scalar>>& Ks)
+{
+    const dyn_mat<typename Derived::Scalar>& rrho = rho.derived();
+
+    // EXCEPTION CHECKS
+
+    if (!internal::check_nonzero_size(rrho))
+        throw Exception("qpp::apply()", Exception::Type::ZERO_SIZE);
+    if (!internal::check_square_mat(rrho))
+        throw Exception("qpp::apply()", Exception::Type::MATRIX_NOT_SQUARE);
+    if (Ks.size() == 0)
+        throw Exception("qpp::apply()", Exception::Type::ZERO_SIZE);
+    if (Ks[0].rows() != Ks[0].cols())
+        throw Exception("qpp::apply()", Exception::Type::MATRIX_NOT_SQUARE);
+    if (Ks[0].rows() != rrho.rows())
+        throw Exception("qpp::apply()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+    for (auto&& it : Ks)
+        if (it.rows() != Ks[0].rows() || it.cols() != Ks[0].rows())
+            throw Exception("qpp::apply()", Exception::Type::DIMS_NOT_EQUAL);
+    // END EXCEPTION CHECKS
+
+    dyn_mat<typename Derived::Scalar> result =
+            dyn_mat<typename Derived::Scalar>::Zero(rrho.rows(), rrho.rows());
+
+    // per-thread partial sums, reduced once at the end
+    return parallel_reduce(Ks.size(), result,
+            [&](idx i, dyn_mat<typename Derived::Scalar>& partial)
+            {
+                // O(nnz * D) per product
+                dyn_mat<typename Derived::Scalar> Krho = Ks[i] * rrho;
+                partial.noalias() += Krho * Ks[i].adjoint();
+            },
+            [](dyn_mat<typename Derived::Scalar>& sum,
+               const dyn_mat<typename Derived::Scalar>& partial)
+            {
+                sum += partial;
+            }, 1);
+}
+
+/**
+* \brief Applies the sparse gate \a A to the whole multi-partite state vector
+* or density matrix \a state
+* \see qpp::Gates::CTRL_sparse(), qpp::Gates::expandout_sparse()
+*
+* \param state Eigen expression
+* \param A Sparse matrix
+* \return Gate \a A applied to \a state, i.e. \f$ A|\psi\rangle \f$
+* or \f$ A\rho A^\dagger \f$
+*/
+template<typename Derived>
+dyn_mat<typename Derived::Scalar> apply(
+        const Eigen::MatrixBase<Derived>& state,
+        const dyn_sp_mat<typename Derived::Scalar>& A)
+{
+    const dyn_mat<typename Derived::Scalar>& rstate = state.derived();
+
+    // EXCEPTION CHECKS
+
+    // check zero sizes
+    if (!internal::check_nonzero_size(rstate))
+        throw Exception("qpp::apply()", Exception::Type::ZERO_SIZE);
+    if (A.rows() == 0)
+        throw Exception("qpp::apply()", Exception::Type::ZERO_SIZE);
+
+    // check square matrix for the gate
+    if (A.rows() != A.cols())
+        throw Exception("qpp::apply()", Exception::Type::MATRIX_NOT_SQUARE);
+
+    // check that the gate matches the state
+    if (A.cols() != rstate.rows())
+        throw Exception("qpp::apply()",
+                        Exception::Type::DIMS_MISMATCH_MATRIX);
+    // END EXCEPTION CHECKS
+
+    //************ ket ************//
+    if (internal::check_cvector(rstate))
+        return A * rstate;
+        //************ density matrix ************//
+    else if (internal::check_square_mat(rstate))
     {
-#ifdef WITH_OPENMP_
-#pragma omp critical
-#endif // WITH_OPENMP_
-        {
-            result += Ks[i] * rrho * adjoint(Ks[i]);
-        }
+        dyn_mat<typename Derived::Scalar> Arho = A * rstate;
+        return Arho * A.adjoint();
     }
-
-    return result;
+        //************ Exception: not ket nor density matrix ************//
+    else
+        throw Exception("qpp::apply()",
+                        Exception::Type::MATRIX_NOT_SQUARE_OR_CVECTOR);
 }
 
 /**
@@ -657,12 +823,13 @@ cmat apply(const Eigen::MatrixBase<Derived>& rho,
 * \return Output density matrix after the action of the channel
 */
 template<typename Derived>
-cmat apply(const Eigen::MatrixBase<Derived>& rho,
-           const std::vector<cmat>& Ks,
-           const std::vector<idx>& subsys,
-           const std::vector<idx>& dims)
+dyn_mat<typename Derived::Scalar> apply(
+        const Eigen::MatrixBase<Derived>& rho,
+        const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
+        const std::vector<idx>& subsys,
+        const std::vector<idx>& dims)
 {
-    const cmat& rrho = rho.derived();
+    const dyn_mat<typename Derived::Scalar>& rrho = rho.derived();
 
     // EXCEPTION CHECKS
 
@@ -705,10 +872,43 @@ cmat apply(const Eigen::MatrixBase<Derived>& rho,
             throw Exception("qpp::apply()", Exception::Type::DIMS_NOT_EQUAL);
     // END EXCEPTION CHECKS
 
-    cmat result = cmat::Zero(rrho.rows(), rrho.rows());
+    idx N = dims.size();
+    idx D = static_cast<idx>(rrho.rows());
+    idx DA = static_cast<idx>(Ks[0].rows());
+
+    // too many subsystems for a 2N-partite ket, sum the Kraus terms
+    if (2 * N > maxn)
+    {
+        dyn_mat<typename Derived::Scalar> result =
+                dyn_mat<typename Derived::Scalar>::Zero(D, D);
+        for (idx i = 0; i < Ks.size(); ++i)
+            result += apply(rrho, Ks[i], subsys, dims);
+
+        return result;
+    }
 
-    for (idx i = 0; i < Ks.size(); ++i)
-        result += apply(rrho, Ks[i], subsys, dims);
+    // rho seen as the column-major vectorization of a 2N-partite ket, column
+    // subsystems first, see qpp::applyCTRL(); the channel is then the single
+    // DA^2 x DA^2 gate sum_i K_i (x) conj(K_i) acting on the row and column
+    // copies of subsys, applied in place with one sweep and no per-Kraus copy
+    dyn_mat<typename Derived::Scalar> S =
+            dyn_mat<typename Derived::Scalar>::Zero(DA * DA, DA * DA);
+    for (auto&& K : Ks)
+        S += kron(K, dyn_mat<typename Derived::Scalar>(K.conjugate()));
+
+    std::vector<idx> dims2 = dims;
+    dims2.insert(std::end(dims2), std::begin(dims), std::end(dims));
+    std::vector<idx> subsys2(2 * subsys.size());
+    for (idx k = 0; k < subsys.size(); ++k)
+    {
+        subsys2[k] = subsys[k] + N;
+        subsys2[subsys.size() + k] = subsys[k];
+    }
+
+    dyn_mat<typename Derived::Scalar> result = rrho;
+    Eigen::Map<dyn_col_vect<typename Derived::Scalar>> vrho(result.data(),
+                                                             D * D);
+    GatePlan<typename Derived::Scalar>(S, {}, subsys2, dims2).execute(vrho);
 
     return result;
 }
@@ -724,12 +924,13 @@ cmat apply(const Eigen::MatrixBase<Derived>& rho,
 * \return Output density matrix after the action of the channel
 */
 template<typename Derived>
-cmat apply(const Eigen::MatrixBase<Derived>& rho,
-           const std::vector<cmat>& Ks,
-           const std::vector<idx>& subsys,
-           idx d = 2)
+dyn_mat<typename Derived::Scalar> apply(
+        const Eigen::MatrixBase<Derived>& rho,
+        const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
+        const std::vector<idx>& subsys,
+        idx d = 2)
 {
-    const cmat& rrho = rho.derived();
+    const dyn_mat<typename Derived::Scalar>& rrho = rho.derived();
 
     // EXCEPTION CHECKS
 
@@ -779,45 +980,19 @@ inline cmat kraus2super(const std::vector<cmat>& Ks)
     idx D = static_cast<idx>(Ks[0].rows());
 
     cmat result(D * D, D * D);
-    cmat MN = cmat::Zero(D, D);
-    bra A = bra::Zero(D);
-    ket B = ket::Zero(D);
-    cmat EMN = cmat::Zero(D, D);
-
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-    for (idx m = 0; m < D; ++m)
+
+    parallel_for(D, D, [&](idx m, idx n)
     {
-        for (idx n = 0; n < D; ++n)
-        {
-#ifdef WITH_OPENMP_
-#pragma omp critical
-#endif // WITH_OPENMP_
-            {
-                // compute E(|m><n|)
-                MN(m, n) = 1;
-                for (idx i = 0; i < Ks.size(); ++i)
-                    EMN += Ks[i] * MN * adjoint(Ks[i]);
-                MN(m, n) = 0;
-
-                for (idx a = 0; a < D; ++a)
-                {
-                    A(a) = 1;
-                    for (idx b = 0; b < D; ++b)
-                    {
-                        // compute result(ab,mn)=<a|E(|m><n)|b>
-                        B(b) = 1;
-                        result(a * D + b, m * D + n) =
-                                static_cast<cmat>(A * EMN * B).value();
-                        B(b) = 0;
-                    }
-                    A(a) = 0;
-                }
-                EMN = cmat::Zero(D, D);
-            }
-        }
-    }
+        // compute E(|m><n|) = sum_i K_i|m><n|K_i^dagger
+        cmat EMN = cmat::Zero(D, D);
+        for (idx i = 0; i < Ks.size(); ++i)
+            EMN.noalias() += Ks[i].col(m) * adjoint(Ks[i].col(n));
+
+        // result(ab,mn)=<a|E(|m><n)|b>
+        for (idx a = 0; a < D; ++a)
+            for (idx b = 0; b < D; ++b)
+                result(a * D + b, m * D + n) = EMN(a, b);
+    }, 1);
 
     return result;
 }
@@ -864,23 +1039,16 @@ inline cmat kraus2choi(const std::vector<cmat>& Ks)
 
     cmat Omega = MES * adjoint(MES);
 
-    cmat result = cmat::Zero(D * D, D * D);
-
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-    for (idx i = 0; i < Ks.size(); ++i)
-    {
-#ifdef WITH_OPENMP_
-#pragma omp critical
-#endif // WITH_OPENMP_
-        {
-            result += kron(cmat::Identity(D, D), Ks[i]) * Omega
-                      * adjoint(kron(cmat::Identity(D, D), Ks[i]));
-        }
-    }
-
-    return result;
+    return parallel_reduce(Ks.size(), cmat(cmat::Zero(D * D, D * D)),
+            [&](idx i, cmat& partial)
+            {
+                partial += kron(cmat::Identity(D, D), Ks[i]) * Omega
+                           * adjoint(kron(cmat::Identity(D, D), Ks[i]));
+            },
+            [](cmat& sum, const cmat& partial)
+            {
+                sum += partial;
+            }, 1);
 }
 
 /**
@@ -949,14 +1117,11 @@ inline cmat choi2super(const cmat& A)
 
     cmat result(D * D, D * D);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(4)
-#endif // WITH_OPENMP_
-    for (idx a = 0; a < D; ++a)
-        for (idx b = 0; b < D; ++b)
-            for (idx m = 0; m < D; ++m)
-                for (idx n = 0; n < D; ++n)
-                    result(a * D + b, m * D + n) = A(m * D + a, n * D + b);
+    parallel_for(D * D, D * D, [&](idx ab, idx mn)
+    {
+        idx a = ab / D, b = ab % D, m = mn / D, n = mn % D;
+        result(a * D + b, m * D + n) = A(m * D + a, n * D + b);
+    });
 
     return result;
 }
@@ -985,14 +1150,11 @@ inline cmat super2choi(const cmat& A)
 
     cmat result(D * D, D * D);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(4)
-#endif // WITH_OPENMP_
-    for (idx a = 0; a < D; ++a)
-        for (idx b = 0; b < D; ++b)
-            for (idx m = 0; m < D; ++m)
-                for (idx n = 0; n < D; ++n)
-                    result(m * D + a, n * D + b) = A(a * D + b, m * D + n);
+    parallel_for(D * D, D * D, [&](idx ab, idx mn)
+    {
+        idx a = ab / D, b = ab % D, m = mn / D, n = mn % D;
+        result(m * D + a, n * D + b) = A(a * D + b, m * D + n);
+    });
 
     return result;
 }
@@ -1057,12 +1219,11 @@ dyn_mat<typename Derived::Scalar> ptrace1(const Eigen::MatrixBase<Derived>& A,
             return sum;
         }; /* end worker */
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-        for (idx j = 0; j < DB; ++j) // column major order for speed
-            for (idx i = 0; i < DB; ++i)
-                result(i, j) = worker(i, j);
+        // column major order for speed
+        parallel_for(DB, DB, [&](idx j, idx i)
+        {
+            result(i, j) = worker(i, j);
+        });
 
         return result;
     }
@@ -1084,12 +1245,11 @@ dyn_mat<typename Derived::Scalar> ptrace1(const Eigen::MatrixBase<Derived>& A,
             return sum;
         }; /* end worker */
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-        for (idx j = 0; j < DB; ++j) // column major order for speed
-            for (idx i = 0; i < DB; ++i)
-                result(i, j) = worker(i, j);
+        // column major order for speed
+        parallel_for(DB, DB, [&](idx j, idx i)
+        {
+            result(i, j) = worker(i, j);
+        });
 
         return result;
     }
@@ -1159,12 +1319,11 @@ dyn_mat<typename Derived::Scalar> ptrace2(const Eigen::MatrixBase<Derived>& A,
             return sum;
         }; /* end worker */
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-        for (idx j = 0; j < DA; ++j) // column major order for speed
-            for (idx i = 0; i < DA; ++i)
-                result(i, j) = worker(i, j);
+        // column major order for speed
+        parallel_for(DA, DA, [&](idx j, idx i)
+        {
+            result(i, j) = worker(i, j);
+        });
 
         return result;
     }
@@ -1176,12 +1335,11 @@ dyn_mat<typename Derived::Scalar> ptrace2(const Eigen::MatrixBase<Derived>& A,
             throw Exception("qpp::ptrace2()",
                             Exception::Type::DIMS_MISMATCH_MATRIX);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(2)
-#endif // WITH_OPENMP_
-        for (idx j = 0; j < DA; ++j) // column major order for speed
-            for (idx i = 0; i < DA; ++i)
-                result(i, j) = trace(rA.block(i * DB, j * DB, DB, DB));
+        // column major order for speed
+        parallel_for(DA, DA, [&](idx j, idx i)
+        {
+            result(i, j) = trace(rA.block(i * DB, j * DB, DB, DB));
+        });
 
         return result;
     }
@@ -1327,13 +1485,10 @@ dyn_mat<typename Derived::Scalar> ptrace(const Eigen::MatrixBase<Derived>& A,
             // compute the column multi-indexes of the complement
             internal::n2multiidx(j, Nsubsys_bar,
                                   Cdimssubsys_bar, Cmidxcolsubsys_bar);
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-            for (idx i = 0; i < Dsubsys_bar; ++i)
+            parallel_for(Dsubsys_bar, [&](idx i)
             {
                 result(i, j) = worker(i);
-            }
+            });
         }
 
         return result;
@@ -1397,13 +1552,10 @@ dyn_mat<typename Derived::Scalar> ptrace(const Eigen::MatrixBase<Derived>& A,
             // compute the column multi-indexes of the complement
             internal::n2multiidx(j, Nsubsys_bar,
                                   Cdimssubsys_bar, Cmidxcolsubsys_bar);
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-            for (idx i = 0; i < Dsubsys_bar; ++i)
+            parallel_for(Dsubsys_bar, [&](idx i)
             {
                 result(i, j) = worker(i);
-            }
+            });
         }
 
         return result;
@@ -1545,11 +1697,10 @@ dyn_mat<typename Derived::Scalar> ptranspose(
             // compute the column multi-index
             internal::n2multiidx(j, N, Cdims, Cmidxcol);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-            for (idx i = 0; i < D; ++i)
+            parallel_for(D, [&](idx i)
+            {
                 result(i, j) = worker(i);
+            });
         }
 
         return result;
@@ -1594,11 +1745,10 @@ dyn_mat<typename Derived::Scalar> ptranspose(
             // compute the column multi-index
             internal::n2multiidx(j, N, Cdims, Cmidxcol);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-            for (idx i = 0; i < D; ++i)
+            parallel_for(D, [&](idx i)
+            {
                 result(i, j) = worker(i);
+            });
         }
 
         return result;
@@ -1732,11 +1882,10 @@ dyn_mat<typename Derived::Scalar> syspermute(
             return internal::multiidx2n(midxtmp, N, permdims);
         }; /* end worker */
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-        for (idx i = 0; i < D; ++i)
+        parallel_for(D, [&](idx i)
+        {
             result(worker(i)) = rA(i);
+        });
 
         return result;
     }
@@ -1788,11 +1937,10 @@ dyn_mat<typename Derived::Scalar> syspermute(
             return internal::multiidx2n(midxtmp, 2 * N, permdims);
         }; /* end worker */
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for
-#endif // WITH_OPENMP_
-        for (idx i = 0; i < D * D; ++i)
+        parallel_for(D * D, [&](idx i)
+        {
             result(worker(i)) = rA(i);
+        });
 
         return reshape(result, D, D);
     }
@@ -0,0 +1,341 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+* \file parallel.h
+* \brief Parallel loops, the thread runtime used by the whole library
+*/
+
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+// Parallel loops over index ranges, split into chunks that run as tasks of
+// a pool of threads; the idle threads take over the pending chunks, so the
+// nested loops (e.g. a gate applied inside a parallel loop over shots or
+// trajectories) run on the threads of the outer loop, without spawning
+// new ones
+
+namespace qpp
+{
+
+/**
+* \brief Configuration of the parallel loops
+* \see qpp::parallel_config()
+*/
+struct ParallelConfig
+{
+    idx num_threads = 0; ///< global thread budget, 0 for all the cores
+    idx grain = 4096;    ///< default minimum number of iterations per chunk
+    idx oversplit = 4;   ///< number of chunks per thread, for load balancing
+    bool work_stealing = false; ///< top-level chunks as tasks, not static
+};
+
+/**
+* \brief Global configuration of the parallel loops
+*
+* \note Returned by reference, so it can be changed, e.g.
+* qpp::parallel_config().num_threads = 4
+*
+* \return Reference to the global configuration
+*/
+inline ParallelConfig& parallel_config()
+{
+    static ParallelConfig config;
+
+    return config;
+}
+
+namespace internal
+{
+
+// per-call thread budget, see qpp::ThreadBudget, 0 if none
+inline idx& thread_budget()
+{
+#ifdef NO_THREAD_LOCAL_
+    static idx budget = 0;
+#else
+    thread_local static idx budget = 0;
+#endif // NO_THREAD_LOCAL_
+
+    return budget;
+}
+
+// number of threads of a top-level parallel loop
+inline idx num_threads()
+{
+    idx result = thread_budget();
+    if (result == 0)
+        result = parallel_config().num_threads;
+#ifdef WITH_OPENMP_
+    if (result == 0)
+        result = static_cast<idx>(omp_get_max_threads());
+#else
+    result = 1;
+#endif // WITH_OPENMP_
+
+    return result;
+}
+
+// runs body(c) for each chunk c = 0, ..., numchunks - 1 on a team of
+// numthreads threads, with a static schedule (each thread gets the same
+// contiguous range of chunks from one loop to the next, see
+// qpp::internal::numa_zero()), or as tasks taken by the idle threads if
+// qpp::ParallelConfig::work_stealing is set; inside a parallel region the
+// chunks always become tasks of the enclosing team, so nested loops do not
+// oversubscribe
+template<typename F>
+void run_chunks(idx numchunks, idx numthreads, const F& body)
+{
+#ifdef WITH_OPENMP_
+    const F* pbody = &body; // shared by all the tasks
+    if (numchunks > 1 && omp_in_parallel())
+    {
+#pragma omp taskloop grainsize(1)
+        for (idx c = 0; c < numchunks; ++c)
+            (*pbody)(c);
+        return;
+    }
+    if (numchunks > 1 && numthreads > 1)
+    {
+        if (parallel_config().work_stealing)
+        {
+#pragma omp parallel num_threads(static_cast<int>(numthreads))
+#pragma omp single
+#pragma omp taskloop grainsize(1)
+            for (idx c = 0; c < numchunks; ++c)
+                (*pbody)(c);
+        } else
+        {
+#pragma omp parallel for schedule(static) \
+        num_threads(static_cast<int>(numthreads))
+            for (idx c = 0; c < numchunks; ++c)
+                (*pbody)(c);
+        }
+        return;
+    }
+#else
+    (void) numthreads;
+#endif // WITH_OPENMP_
+    for (idx c = 0; c < numchunks; ++c)
+        body(c);
+}
+
+// number of chunks of n iterations, at least grain iterations each, and at
+// most maxchunks
+inline idx num_chunks(idx n, idx grain, idx maxchunks)
+{
+    if (grain == 0)
+        grain = parallel_config().grain;
+    idx result = (n + grain - 1) / grain;
+
+    return std::max<idx>(1, std::min(result, maxchunks));
+}
+
+} /* namespace internal */
+
+/**
+* \class qpp::ThreadBudget
+* \brief Limits the number of threads of the parallel loops started by the
+* current thread, during the lifetime of the object
+*
+* Overrides qpp::ParallelConfig::num_threads for the calls made in its
+* scope, e.g.
+* \code
+* {
+*     ThreadBudget budget(2);
+*     psi = apply(psi, gt.H, {0}, dims); // runs on 2 threads
+* }
+* \endcode
+*/
+class ThreadBudget
+{
+    idx previous_; ///< budget restored by the destructor
+
+public:
+    /**
+    * \brief Sets the thread budget of the current thread
+    *
+    * \param num_threads Number of threads, 0 for the global budget
+    */
+    explicit ThreadBudget(idx num_threads) :
+            previous_{internal::thread_budget()}
+    {
+        internal::thread_budget() = num_threads;
+    }
+
+    /**
+    * \brief Restores the previous thread budget
+    */
+    ~ThreadBudget()
+    {
+        internal::thread_budget() = previous_;
+    }
+
+    ThreadBudget(const ThreadBudget&) = delete;
+    ThreadBudget& operator=(const ThreadBudget&) = delete;
+}; /* class ThreadBudget */
+
+/**
+* \brief Parallel loop over chunks, calls \a f(begin, end) for consecutive
+* chunks [begin, end) of the iterations 0, ..., \a n - 1
+*
+* \note Useful when each chunk needs its own scratch space; loops with a
+* single chunk run on the current thread
+*
+* \param n Number of iterations
+* \param f Loop body, must not throw
+* \param grain Minimum number of iterations per chunk, 0 for
+* qpp::ParallelConfig::grain
+*/
+template<typename F>
+void parallel_chunks(idx n, const F& f, idx grain = 0)
+{
+    idx numthreads = internal::num_threads();
+    idx numchunks = internal::num_chunks(
+            n, grain, numthreads * parallel_config().oversplit);
+
+    internal::run_chunks(numchunks, numthreads, [&](idx c)
+    {
+        f(n * c / numchunks, n * (c + 1) / numchunks);
+    });
+}
+
+/**
+* \brief Parallel loop, calls \a f(i) for i = 0, ..., \a n - 1
+*
+* \note The iterations are split into chunks of at least \a grain
+* iterations; loops with a single chunk run on the current thread
+*
+* \param n Number of iterations
+* \param f Loop body, must not throw
+* \param grain Minimum number of iterations per chunk, 0 for
+* qpp::ParallelConfig::grain
+*/
+template<typename F>
+void parallel_for(idx n, const F& f, idx grain = 0)
+{
+    parallel_chunks(n, [&](idx begin, idx end)
+    {
+        for (idx i = begin; i < end; ++i)
+            f(i);
+    }, grain);
+}
+
+/**
+* \brief Parallel loop over a 2-dimensional index range, calls \a f(i, j)
+* for i = 0, ..., \a n1 - 1 and j = 0, ..., \a n2 - 1, with j running
+* fastest
+*
+* \note The \a n1 x \a n2 iterations are split into chunks of at least
+* \a grain iterations; loops with a single chunk run on the current thread
+*
+* \param n1 Number of iterations of the outer index
+* \param n2 Number of iterations of the inner index
+* \param f Loop body, must not throw
+* \param grain Minimum number of iterations per chunk, 0 for
+* qpp::ParallelConfig::grain
+*/
+template<typename F>
+void parallel_for(idx n1, idx n2, const F& f, idx grain = 0)
+{
+    if (n2 == 0)
+        return;
+    parallel_chunks(n1 * n2, [&](idx begin, idx end)
+    {
+        idx i = begin / n2, j = begin % n2;
+        for (idx k = begin; k < end; ++k)
+        {
+            f(i, j);
+            if (++j == n2)
+            {
+                j = 0;
+                ++i;
+            }
+        }
+    }, grain);
+}
+
+/**
+* \brief Parallel reduction over chunks, calls \a f(begin, end, partial) for
+* consecutive chunks [begin, end) of the iterations 0, ..., \a n - 1, where
+* each chunk accumulates into its own \a partial, a copy of \a zero; the
+* partials are then combined in order by \a combine(result, partial)
+*
+* \note There is at most one chunk per thread, so that at most as many
+* partials as threads are kept in memory
+*
+* \param n Number of iterations
+* \param zero Initial value of the partials
+* \param f Loop body, must not throw
+* \param combine Combines a partial into the result
+* \param grain Minimum number of iterations per chunk, 0 for
+* qpp::ParallelConfig::grain
+* \return Combination of all the partials
+*/
+template<typename T, typename F, typename C>
+T parallel_reduce_chunks(idx n, const T& zero, const F& f, const C& combine,
+                         idx grain = 0)
+{
+    idx numthreads = internal::num_threads();
+    idx numchunks = internal::num_chunks(n, grain, numthreads);
+
+    std::vector<T> partials(numchunks, zero);
+    internal::run_chunks(numchunks, numthreads, [&](idx c)
+    {
+        f(n * c / numchunks, n * (c + 1) / numchunks, partials[c]);
+    });
+
+    T result = std::move(partials[0]);
+    for (idx c = 1; c < numchunks; ++c)
+        combine(result, partials[c]);
+
+    return result;
+}
+
+/**
+* \brief Parallel reduction, calls \a f(i, partial) for i = 0, ..., \a n - 1,
+* where each chunk of iterations accumulates into its own \a partial, a copy
+* of \a zero; the partials are then combined in order by
+* \a combine(result, partial)
+* \see qpp::parallel_reduce_chunks()
+*
+* \param n Number of iterations
+* \param zero Initial value of the partials
+* \param f Loop body, must not throw
+* \param combine Combines a partial into the result
+* \param grain Minimum number of iterations per chunk, 0 for
+* qpp::ParallelConfig::grain
+* \return Combination of all the partials
+*/
+template<typename T, typename F, typename C>
+T parallel_reduce(idx n, const T& zero, const F& f, const C& combine,
+                  idx grain = 0)
+{
+    return parallel_reduce_chunks(n, zero, [&](idx begin, idx end, T& partial)
+    {
+        for (idx i = begin; i < end; ++i)
+            f(i, partial);
+    }, combine, grain);
+}
+
+} /* namespace qpp */
+
+#endif /* PARALLEL_H_ */
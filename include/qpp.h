@@ -46,6 +46,7 @@
 #include <chrono>
 #include <cmath>
 #include <complex>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
@@ -56,6 +57,7 @@
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <ostream>
@@ -65,22 +67,44 @@
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // defined(__unix__) || defined(__APPLE__)
+#ifdef WITH_NUMA_
+#include <numa.h>
+#endif // WITH_NUMA_
+#ifdef WITH_OPENMP_
+#include <omp.h>
+#endif // WITH_OPENMP_
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 #include <Eigen/SVD>
 
 // pre-processor macros, make them visible to the whole library
 #include "macros.h"
 
+// vectorized kernels, selected at runtime, see "internal/simd.h"
+#ifdef QPP_X86_SIMD_
+#include <immintrin.h>
+#endif // QPP_X86_SIMD_
+
 // do not change the order in this group, inter-dependencies
 #include "types.h"
 #include "classes/exception.h"
 #include "constants.h"
 #include "traits.h"
 #include "classes/idisplay.h"
+#include "parallel.h"
 #include "internal/util.h"
+#include "internal/simd.h"
+#include "internal/memory.h"
+#include "internal/kernels.h"
 #include "internal/classes/iomanip.h"
 #include "input_output.h"
 
@@ -92,6 +116,7 @@
 #include "classes/gates.h"
 #include "classes/states.h"
 #include "classes/random_devices.h"
+#include "classes/gate_plan.h"
 
 // do not change the order in this group, inter-dependencies
 #include "statistics.h"
@@ -104,6 +129,16 @@
 #include "classes/timer.h"
 #include "instruments.h"
 #include "number_theory.h"
+#include "classes/sparse_ket.h"
+#include "classes/stabilizer_state.h"
+#include "classes/mps.h"
+#include "classes/mapped_ket.h"
+
+// do not change the order in this group, inter-dependencies
+#include "classes/gate_fusion.h"
+#include "classes/qcircuit.h"
+#include "classes/qengine.h"
+#include "classes/qtrajectory_engine.h"
 
 /**
 * \namespace qpp
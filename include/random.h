@@ -405,13 +405,11 @@ inline std::vector<cmat> randkraus(idx N, idx D)
     cmat Fk(D, D);
     cmat U = randU(N * D);
 
-#ifdef WITH_OPENMP_
-#pragma omp parallel for collapse(3)
-#endif // WITH_OPENMP_
-    for (idx k = 0; k < N; ++k)
-        for (idx a = 0; a < D; ++a)
-            for (idx b = 0; b < D; ++b)
-                result[k](a, b) = U(a * N + k, b * N);
+    parallel_for(N * D, D, [&](idx ka, idx b)
+    {
+        idx k = ka / D, a = ka % D;
+        result[k](a, b) = U(a * N + k, b * N);
+    });
 
     return result;
 }
@@ -96,6 +96,52 @@ inline std::vector<double> marginalY(const dmat& probXY)
     return marginalX(probXY.transpose());
 }
 
+/**
+* \brief Marginal distribution of the part \a subsys of a multi-partite
+* joint probability distribution
+* \see qpp::marginalX(), qpp::marginalY(), qpp::probs()
+*
+* \note Generalizes qpp::marginalX() and qpp::marginalY() to any number of
+* random variables and any subset of them, e.g. marginalX(probXY) is the
+* marginal onto {0} of the row-major flattening of \a probXY, with
+* \a dims = {probXY.rows(), probXY.cols()}
+*
+* \param prob Real vector representing the joint probability distribution of
+* the random variables, in lexicographical order (the last variable varies
+* fastest), e.g. as returned by qpp::probs()
+* \param subsys Indexes of the random variables that are kept
+* \param dims Numbers of values of the random variables
+* \return Real vector consisting of the marginal distribution of \a subsys,
+* in lexicographical order of the variables taken in the order of \a subsys
+*/
+inline std::vector<double> marginal(const std::vector<double>& prob,
+                                    const std::vector<idx>& subsys,
+                                    const std::vector<idx>& dims)
+{
+    // EXCEPTION CHECKS
+
+    if (!internal::check_nonzero_size(prob))
+        throw Exception("qpp::marginal()", Exception::Type::ZERO_SIZE);
+
+    // check that dimension is valid
+    if (!internal::check_dims(dims))
+        throw Exception("qpp::marginal()", Exception::Type::DIMS_INVALID);
+
+    // check that dims match the distribution
+    if (prod(std::begin(dims), std::end(dims)) != prob.size())
+        throw Exception("qpp::marginal()",
+                        Exception::Type::DIMS_MISMATCH_VECTOR);
+
+    // check subsys is valid w.r.t. dims
+    if (!internal::check_subsys_match_dims(subsys, dims))
+        throw Exception("qpp::marginal()",
+                        Exception::Type::SUBSYS_MISMATCH_DIMS);
+    // END EXCEPTION CHECKS
+
+    return internal::marginal_probs([&](idx i) -> double { return prob[i]; },
+                                    subsys, dims);
+}
+
 /**
 * \brief Average
 *
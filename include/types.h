@@ -65,6 +65,34 @@ using cmat = Eigen::MatrixXcd;
 */
 using dmat = Eigen::MatrixXd;
 
+/**
+* \brief Complex number in single precision
+*/
+using cplx_f = std::complex<float>;
+
+/**
+* \brief Complex (single precision) dynamic Eigen column vector
+*
+* \note Halves the memory footprint of qpp::ket, at the cost of a round-off
+* error of order 1e-7 per operation
+*/
+using ket_f = Eigen::VectorXcf;
+
+/**
+* \brief Complex (single precision) dynamic Eigen row vector
+*/
+using bra_f = Eigen::RowVectorXcf;
+
+/**
+* \brief Complex (single precision) dynamic Eigen matrix
+*/
+using cmat_f = Eigen::MatrixXcf;
+
+/**
+* \brief Complex (double precision) sparse Eigen matrix
+*/
+using sp_cmat = Eigen::SparseMatrix<cplx>;
+
 /**
 * \brief Dynamic Eigen matrix over the field specified by \a Scalar
 *
@@ -101,6 +129,19 @@ using dyn_col_vect = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
 template<typename Scalar> // Eigen::RowVectorX_type (where type = Scalar)
 using dyn_row_vect = Eigen::Matrix<Scalar, 1, Eigen::Dynamic>;
 
+/**
+* \brief Sparse Eigen matrix over the field specified by \a Scalar, in
+* column-major compressed storage
+*
+* Example:
+* \code
+* // type of spmat is Eigen::SparseMatrix<std::complex<double>>
+* auto spmat = dyn_sp_mat<std::complex<double>>(4, 4);
+* \endcode
+*/
+template<typename Scalar> // Eigen::SparseMatrix<type> (where type = Scalar)
+using dyn_sp_mat = Eigen::SparseMatrix<Scalar>;
+
 } /* namespace qpp */
 
 #endif	/* TYPES_H_ */
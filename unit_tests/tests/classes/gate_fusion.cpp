@@ -0,0 +1,172 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/gate_fusion.h"
+
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       GateFusion& qpp::GateFusion::add(
+///       const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& subsys)
+TEST(qpp_GateFusion_add, Blocks)
+{
+    std::vector<idx> dims(5, 2);
+    GateFusion<> fusion(dims, 2);
+
+    fusion.add(gt.H, {0});       // block 0: {0}
+    fusion.add(gt.CNOT, {0, 1}); // block 0: {0, 1}
+    fusion.add(gt.T, {3});       // block 1: {3}, does not fit in block 0
+    fusion.add(gt.X, {1});       // commutes with block 1, into block 0
+    fusion.add(gt.CZ, {1, 2});   // overlaps block 0, which is full
+    fusion.add(gt.Z, {4});       // into block 2: {3, 4}
+
+    EXPECT_EQ(6, fusion.get_num_gates());
+    ASSERT_EQ(3, fusion.get_blocks().size());
+    EXPECT_EQ(std::vector<idx>({0, 1}), fusion.get_blocks()[0].subsys);
+    EXPECT_EQ(std::vector<idx>({3, 4}), fusion.get_blocks()[1].subsys);
+    EXPECT_EQ(std::vector<idx>({1, 2}), fusion.get_blocks()[2].subsys);
+    EXPECT_EQ(3, fusion.get_blocks()[0].numgates);
+
+    // a gate larger than the blocks is kept on its own
+    fusion.add(gt.TOF, {0, 1, 2});
+    EXPECT_EQ(4, fusion.get_blocks().size());
+
+    // exceptions
+    EXPECT_THROW(fusion.add(gt.CNOT, {0}), Exception);
+    EXPECT_THROW(fusion.add(gt.X, {5}), Exception);
+    EXPECT_THROW(GateFusion<>(dims, 0), Exception);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       GateFusion& qpp::GateFusion::add(
+///       const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys)
+TEST(qpp_GateFusion_add, Controlled)
+{
+    std::vector<idx> dims(5, 2);
+    idx N = dims.size();
+    ket psi = randket(prod(dims));
+    cmat rho = randrho(prod(dims));
+    cmat R = gt.Rn(0.3, {0, 0, 1});
+
+    GateFusion<> fusion(dims, 3);
+    fusion.add(gt.H, {0});
+    fusion.add(gt.X, {0}, {1});          // fused as CNOT on {0, 1}
+    fusion.add(gt.Z, {1, 0}, {2});       // fused as CCZ on {1, 0, 2}
+    fusion.add(R, {0, 2, 3}, {4});       // too large, own block
+    fusion.add(gt.H, {2});               // cannot be moved past it
+    fusion.add(gt.T, {3}, {1});          // into the last block
+
+    EXPECT_EQ(6, fusion.get_num_gates());
+    ASSERT_EQ(3, fusion.get_blocks().size());
+    EXPECT_EQ(std::vector<idx>({0, 1, 2}), fusion.get_blocks()[0].subsys);
+    EXPECT_EQ(std::vector<idx>({0, 2, 3}), fusion.get_blocks()[1].ctrl);
+    EXPECT_EQ(std::vector<idx>({2, 3, 1}), fusion.get_blocks()[2].subsys);
+
+    ket expected_psi = psi;
+    cmat expected_rho = rho;
+    expected_psi = apply(expected_psi, gt.H, {0}, dims);
+    expected_psi = applyCTRL(expected_psi, gt.X, {0}, {1}, dims);
+    expected_psi = applyCTRL(expected_psi, gt.Z, {1, 0}, {2}, dims);
+    expected_psi = applyCTRL(expected_psi, R, {0, 2, 3}, {4}, dims);
+    expected_psi = apply(expected_psi, gt.H, {2}, dims);
+    expected_psi = applyCTRL(expected_psi, gt.T, {3}, {1}, dims);
+    expected_rho = apply(expected_rho, gt.H, {0}, dims);
+    expected_rho = applyCTRL(expected_rho, gt.X, {0}, {1}, dims);
+    expected_rho = applyCTRL(expected_rho, gt.Z, {1, 0}, {2}, dims);
+    expected_rho = applyCTRL(expected_rho, R, {0, 2, 3}, {4}, dims);
+    expected_rho = apply(expected_rho, gt.H, {2}, dims);
+    expected_rho = applyCTRL(expected_rho, gt.T, {3}, {1}, dims);
+
+    ket result_psi = psi;
+    fusion.execute(result_psi);
+    EXPECT_NEAR(0, norm(result_psi - expected_psi), 1e-10);
+    cmat result_rho = rho;
+    fusion.execute(result_rho);
+    EXPECT_NEAR(0, norm(result_rho - expected_rho), 1e-10);
+
+    // exceptions
+    EXPECT_THROW(fusion.add(gt.X, {1}, {1}), Exception);
+    EXPECT_THROW(fusion.add(gt.X, {N}, {1}), Exception);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       void qpp::GateFusion::execute(Eigen::MatrixBase<Derived>& state) const
+TEST(qpp_GateFusion_execute, RandomCircuits)
+{
+    // random 1 and 2 qudit gates, fused vs one by one
+    std::vector<idx> dims{2, 3, 2, 2, 3};
+    idx N = dims.size();
+    ket psi = randket(prod(dims));
+    cmat rho = randrho(prod(dims));
+
+    for (idx k = 1; k <= 4; ++k)
+    {
+        GateFusion<> fusion(dims, k);
+        ket expected_psi = psi;
+        cmat expected_rho = rho;
+        for (idx i = 0; i < 20; ++i)
+        {
+            std::vector<idx> subsys{randidx(0, N - 1)};
+            if (i % 2)
+            {
+                idx j = randidx(0, N - 2);
+                subsys.push_back(j >= subsys[0] ? j + 1 : j);
+            }
+            idx DA = 1;
+            for (idx s : subsys)
+                DA *= dims[s];
+            cmat U = randU(DA);
+
+            fusion.add(U, subsys);
+            expected_psi = apply(expected_psi, U, subsys, dims);
+            expected_rho = apply(expected_rho, U, subsys, dims);
+        }
+        EXPECT_EQ(20, fusion.get_num_gates());
+        EXPECT_LE(fusion.get_blocks().size(), 20);
+
+        ket result_psi = psi;
+        fusion.execute(result_psi);
+        EXPECT_NEAR(0, norm(result_psi - expected_psi), 1e-10);
+
+        cmat result_rho = rho;
+        fusion.execute(result_rho);
+        EXPECT_NEAR(0, norm(result_rho - expected_rho), 1e-10);
+    }
+}
+
+TEST(qpp_GateFusion_execute, Exceptions)
+{
+    GateFusion<> fusion({2, 2});
+    fusion.add(gt.CNOT, {0, 1});
+
+    ket psi = randket(8);
+    EXPECT_THROW(fusion.execute(psi), Exception);
+    cmat A = cmat::Random(4, 2);
+    EXPECT_THROW(fusion.execute(A), Exception);
+}
+/******************************************************************************/
@@ -0,0 +1,159 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/gate_plan.h"
+
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       void qpp::GatePlan::execute(Eigen::MatrixBase<Derived>& state) const
+TEST(qpp_GatePlan_execute, Reuse)
+{
+    idx N = 4;
+    std::vector<idx> dims(N, 2);
+    std::vector<idx> ctrl{3};
+    std::vector<idx> target{0, 2};
+    cmat U = randU(4);
+    cmat CTRLU = gt.CTRL(U, ctrl, target, N);
+
+    GatePlan<> plan(U, ctrl, target, dims);
+    ket psi = randket(prod(dims));
+    ket result = psi;
+    ket expected = psi;
+    for (idx i = 0; i < 10; ++i)
+    {
+        plan.execute(result);
+        expected = CTRLU * expected;
+    }
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+    // the same plan applied to other states
+    psi = randket(prod(dims));
+    result = psi;
+    plan.execute(result);
+    EXPECT_NEAR(0, norm(result - CTRLU * psi), 1e-10);
+}
+
+TEST(qpp_GatePlan_execute, GateKinds)
+{
+    // dense, diagonal and monomial gates on qutrits
+    idx N = 3, d = 3;
+    ket psi = randket(prod(std::vector<idx>(N, d)));
+
+    std::vector<cmat> gates{randU(d), gt.Zd(d), gt.Xd(d)};
+    for (auto&& U : gates)
+    {
+        GatePlan<> plan(U, {0}, {2}, N, d);
+        ket result = psi;
+        plan.execute(result);
+        ket expected = gt.CTRL(U, {0}, {2}, N, d) * psi;
+        EXPECT_NEAR(0, norm(result - expected), 1e-10);
+    }
+}
+
+TEST(qpp_GatePlan_execute, DimensionOneControl)
+{
+    // the control of dimension 1 is always in the state 0, so no gate kind
+    // is ever applied
+    std::vector<idx> dims{1, 2};
+    ket psi = randket(2);
+    for (auto&& U : {randU(2), cmat(gt.Z), cmat(gt.X)})
+    {
+        GatePlan<> plan(U, {0}, {1}, dims);
+        ket result = psi;
+        plan.execute(result);
+        EXPECT_NEAR(0, norm(result - psi), 1e-10);
+
+        cmat states = randU(2);
+        cmat results = states;
+        plan.execute_batch(results);
+        EXPECT_NEAR(0, norm(results - states), 1e-10);
+    }
+}
+
+TEST(qpp_GatePlan_execute, Exceptions)
+{
+    GatePlan<> plan(gt.CNOT, {}, {0, 1}, 3);
+
+    ket psi = randket(4); // wrong dimension
+    EXPECT_THROW(plan.execute(psi), Exception);
+
+    cmat rho = randrho(8); // not a column vector
+    EXPECT_THROW(plan.execute(rho), Exception);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       void qpp::GatePlan::execute_batch(
+///       Eigen::MatrixBase<Derived>& states) const
+TEST(qpp_GatePlan_execute_batch, GateKinds)
+{
+    // batch vs column by column, dense, diagonal and monomial gates
+    std::vector<idx> dims{2, 3, 2, 2, 3};
+    idx D = prod(dims), B = 7;
+    cmat states(D, B);
+    for (idx b = 0; b < B; ++b)
+        states.col(b) = randket(D);
+
+    std::vector<cmat> gates{randU(6), randU(4), gt.Zd(3), gt.Xd(3), gt.CNOT};
+    std::vector<std::vector<idx>> targets{{1, 0}, {2, 3}, {4}, {1}, {3, 0}};
+    std::vector<std::vector<idx>> ctrls{{}, {0}, {1}, {4}, {2}};
+    for (idx i = 0; i < gates.size(); ++i)
+    {
+        GatePlan<> plan(gates[i], ctrls[i], targets[i], dims);
+        cmat result = states;
+        plan.execute_batch(result);
+        for (idx b = 0; b < B; ++b)
+        {
+            ket expected = states.col(b);
+            plan.execute(expected);
+            EXPECT_NEAR(0, norm(result.col(b) - expected), 1e-10);
+        }
+    }
+
+    // exceptions
+    GatePlan<> plan(gt.CNOT, {}, {0, 1}, 3);
+    cmat wrong = cmat::Zero(4, B);
+    EXPECT_THROW(plan.execute_batch(wrong), Exception);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       qpp::GatePlan::GatePlan(const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_GatePlan_GatePlan, Exceptions)
+{
+    std::vector<idx> dims{2, 3, 2};
+
+    // control subsystems of different dimensions
+    EXPECT_THROW(GatePlan<>(gt.X, {0, 1}, {2}, dims), Exception);
+    // gate does not match the target
+    EXPECT_THROW(GatePlan<>(gt.X, {0}, {1}, dims), Exception);
+    // control overlaps the target
+    EXPECT_THROW(GatePlan<>(gt.X, {0}, {0}, dims), Exception);
+    // invalid subsystem
+    EXPECT_THROW(GatePlan<>(gt.X, {}, {3}, dims), Exception);
+}
+/******************************************************************************/
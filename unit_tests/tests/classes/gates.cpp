@@ -125,6 +125,33 @@ TEST(qpp_Gates_CTRL, Qudits)
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
+///       dyn_sp_mat<typename Derived::Scalar> qpp::Gates::CTRL_sparse(
+///       const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys,
+///       idx N, idx d = 2) const
+TEST(qpp_Gates_CTRL_sparse, AllTests)
+{
+    // qubits, two controls and a two-qubit gate on reversed subsystems
+    cmat U = randU(4);
+    sp_cmat CU = gt.CTRL_sparse(U, {0, 3}, {2, 1}, 5);
+    EXPECT_NEAR(0, norm(cmat(CU) - gt.CTRL(U, {0, 3}, {2, 1}, 5)), 1e-10);
+    EXPECT_EQ(56, CU.nonZeros()); // 24 inactive columns + 8 dense blocks
+
+    // qutrits, the powers of the gate are applied
+    U = randU(3);
+    CU = gt.CTRL_sparse(U, {2, 0}, {1}, 4, 3);
+    EXPECT_NEAR(0, norm(cmat(CU) - gt.CTRL(U, {2, 0}, {1}, 4, 3)), 1e-10);
+
+    // CNOT on 14 qubits, one non-zero entry per column
+    CU = gt.CTRL_sparse(gt.X, {0}, {13}, 14);
+    EXPECT_EQ(static_cast<idx>(1) << 14, CU.nonZeros());
+    ket psi = mket({1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    ket res = mket({1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+    EXPECT_NEAR(0, norm(apply(psi, CU) - res), 1e-10);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
 ///       dyn_mat<typename Derived::Scalar> qpp::Gates::expandout(
 ///       const Eigen::MatrixBase<Derived>& A,
 ///       idx pos,
@@ -142,6 +169,29 @@ TEST(qpp_Gates_expandout, AllTests)
     EXPECT_EQ(gt.expandout(gt.X, 1, {2, 2, 2}), kron(gt.Id2, gt.X, gt.Id2));
 }
 /******************************************************************************/
+/// BEGIN template<typename Derived>
+///       dyn_sp_mat<typename Derived::Scalar> qpp::Gates::expandout_sparse(
+///       const Eigen::MatrixBase<Derived>& A,
+///       idx pos,
+///       const std::vector<idx>& dims) const
+TEST(qpp_Gates_expandout_sparse, AllTests)
+{
+    // single qubit (degenerate case) random gate expansion
+    cmat U = randU(2);
+    EXPECT_NEAR(0, norm(cmat(gt.expandout_sparse(U, 0, {2})) - U), 1e-10);
+
+    // random qutrit gate in the middle of mixed dimensions
+    U = randU(3);
+    sp_cmat EU = gt.expandout_sparse(U, 1, {2, 3, 4});
+    EXPECT_NEAR(0, norm(cmat(EU) - gt.expandout(U, 1, {2, 3, 4})), 1e-10);
+    EXPECT_EQ(72, EU.nonZeros());
+
+    // 3 qubits, X on qudit 2 expansion, one entry per column
+    EU = gt.expandout_sparse(gt.X, 1, {2, 2, 2});
+    EXPECT_NEAR(0, norm(cmat(EU) - kron(gt.Id2, gt.X, gt.Id2)), 1e-10);
+    EXPECT_EQ(8, EU.nonZeros());
+}
+/******************************************************************************/
 /// BEGIN cmat qpp::Gates::Fd(idx D) const
 TEST(qpp_Gates_Fd, AllTests)
 {
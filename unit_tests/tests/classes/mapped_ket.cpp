@@ -0,0 +1,146 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// creates an empty temporary file and returns its path
+static std::string temp_path()
+{
+    const char* tmpdir = std::getenv("TMPDIR");
+    std::string path = std::string(tmpdir ? tmpdir : "/tmp") +
+                       "/qpp_mapped_ket.XXXXXX";
+    int fd = ::mkstemp(&path[0]);
+    if (fd != -1)
+        ::close(fd);
+    return path;
+}
+
+// Unit testing "classes/mapped_ket.h"
+/******************************************************************************/
+/// BEGIN qpp::MappedKet& qpp::MappedKet::applyCTRL(const cmat& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys)
+TEST(qpp_MappedKet_applyCTRL, DenseComparison)
+{
+    // small chunks, so that most subsystems are high
+    std::vector<idx> dims{2, 3, 2, 2, 2, 3};
+    idx N = dims.size();
+    ket psi = mket(std::vector<idx>(N, 0), dims);
+    std::string path = temp_path();
+    {
+        MappedKet mapped(path, dims, 6, 2);
+        EXPECT_EQ(6u, mapped.get_chunk());
+        for (idx i = 0; i < 40; ++i)
+        {
+            idx a = randidx(0, N - 1);
+            idx b = (a + randidx(1, N - 1)) % N;
+            if (i % 3 == 0)
+            {
+                cmat U = randU(dims[a] * dims[b]);
+                mapped.apply(U, {a, b});
+                psi = apply(psi, U, {a, b}, dims);
+            } else if (i % 3 == 1)
+            {
+                // controlled on a qubit
+                idx c = a == 0 ? 2 : 0;
+                if (b == c)
+                    continue;
+                cmat U = randU(dims[b]);
+                mapped.applyCTRL(U, {c}, {b});
+                psi = applyCTRL(psi, U, {c}, {b}, dims);
+            } else
+            {
+                cmat U = randU(dims[a]);
+                mapped.apply(U, {a});
+                psi = apply(psi, U, {a}, dims);
+            }
+        }
+        EXPECT_NEAR(0, norm(mapped.to_ket() - psi), 1e-10);
+        EXPECT_NEAR(std::abs(psi(7)), std::abs(mapped(7)), 1e-10);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(qpp_MappedKet_applyCTRL, Exceptions)
+{
+    // 6 qubits, chunks of 2^3 amplitudes, i.e. qubits 0 to 2 are high
+    std::vector<idx> dims(6, 2);
+    std::string path = temp_path();
+    {
+        MappedKet mapped(path, dims, 8, 2);
+
+        // more high subsystems than a pass can hold
+        cmat U = randU(8);
+        EXPECT_THROW(mapped.apply(U, {0, 1, 2}), Exception);
+        EXPECT_THROW(mapped.applyCTRL(gt.CNOT, {0}, {1, 2}), Exception);
+
+        // at most 2 high subsystems
+        mapped.apply(U, {0, 1, 3});
+        mapped.applyCTRL(gt.CNOT, {0}, {4, 5});
+        EXPECT_EQ(0u, mapped.get_num_passes());
+        mapped.flush();
+        EXPECT_EQ(1u, mapped.get_num_passes());
+    }
+    std::remove(path.c_str());
+}
+/******************************************************************************/
+/// BEGIN qpp::MappedKet& qpp::MappedKet::flush()
+TEST(qpp_MappedKet_flush, Passes)
+{
+    // 10 qubits, chunks of 2^6 amplitudes, i.e. qubits 0 to 3 are high
+    idx n = 10;
+    std::vector<idx> dims(n, 2);
+    ket psi = mket(std::vector<idx>(n, 0));
+    std::string path = temp_path();
+    {
+        MappedKet mapped(path, dims, 64, 2);
+
+        // gates on the low qubits, or on at most 2 high ones, in one pass
+        for (idx i = 0; i < n; ++i)
+        {
+            mapped.apply(gt.H, {n - 1 - i});
+            psi = apply(psi, gt.H, {n - 1 - i}, dims);
+        }
+        EXPECT_EQ(1u, mapped.get_num_passes()); // the third high qubit
+        mapped.flush();
+        EXPECT_EQ(2u, mapped.get_num_passes()); // {9, ..., 2}, {1, 0}
+
+        // a CNOT chain 3 -> 0 needs a new pass per gate
+        mapped.applyCTRL(gt.X, {3}, {2});
+        mapped.applyCTRL(gt.X, {2}, {1});
+        mapped.applyCTRL(gt.X, {1}, {0});
+        psi = applyCTRL(psi, gt.X, {3}, {2}, dims);
+        psi = applyCTRL(psi, gt.X, {2}, {1}, dims);
+        psi = applyCTRL(psi, gt.X, {1}, {0}, dims);
+        mapped.flush();
+        EXPECT_EQ(5u, mapped.get_num_passes());
+
+        EXPECT_NEAR(0, norm(mapped.to_ket() - psi), 1e-10);
+    }
+    std::remove(path.c_str());
+}
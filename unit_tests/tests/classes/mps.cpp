@@ -0,0 +1,155 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/mps.h"
+/******************************************************************************/
+/// BEGIN qpp::MPS& qpp::MPS::apply(const cmat& U,
+///       const std::vector<idx>& subsys)
+TEST(qpp_MPS_apply, DenseComparison)
+{
+    // random gates on adjacent and non-adjacent sites of mixed dimensions,
+    // no truncation
+    std::vector<idx> dims{2, 3, 2, 2, 3};
+    idx N = dims.size();
+    MPS mps(std::vector<idx>(N, 0), dims);
+    ket psi = mket(std::vector<idx>(N, 0), dims);
+    for (idx i = 0; i < 30; ++i)
+    {
+        idx a = randidx(0, N - 1);
+        idx b = (a + randidx(1, N - 1)) % N;
+        if (i % 2)
+        {
+            cmat U = randU(dims[a] * dims[b]);
+            mps.apply(U, {a, b});
+            psi = apply(psi, U, {a, b}, dims);
+        } else
+        {
+            cmat U = randU(dims[a]);
+            mps.apply(U, {a});
+            psi = apply(psi, U, {a}, dims);
+        }
+        EXPECT_NEAR(0, norm(mps.to_ket() - psi), 1e-10);
+    }
+    EXPECT_NEAR(1, mps.norm(), 1e-10);
+    EXPECT_EQ(dims, mps.get_dims());
+    EXPECT_NEAR(0, mps.get_discarded(), 1e-10);
+
+    // more than two sites
+    EXPECT_THROW(mps.apply(randU(12), {0, 1, 2}), Exception);
+}
+
+TEST(qpp_MPS_apply, Truncation)
+{
+    // product gates keep a product state at bond dimension 1
+    idx n = 12;
+    MPS prod_mps(std::vector<idx>(n, 0), std::vector<idx>(n, 2));
+    for (idx i = 0; i + 1 < n; i += 2)
+        prod_mps.apply(kron(gt.H, gt.T), {i, i + 1});
+    EXPECT_EQ(std::vector<idx>(n - 1, 1), prod_mps.get_bond_dims());
+    EXPECT_NEAR(1, prod_mps.norm(), 1e-10);
+
+    // CNOT on |+...+> acts trivially, also through the SWAP network
+    MPS plus(std::vector<idx>(n, 0), std::vector<idx>(n, 2));
+    for (idx i = 0; i < n; ++i)
+        plus.apply(gt.H, {i});
+    plus.apply(gt.CNOT, {0, n - 1});
+    EXPECT_EQ(std::vector<idx>(n - 1, 1), plus.get_bond_dims());
+    EXPECT_NEAR(0, norm(plus.to_ket() - kronpow(st.x0, n)), 1e-10);
+
+    // GHZ state on 100 qubits has bond dimension 2, without any cap
+    idx N = 100;
+    MPS ghz(std::vector<idx>(N, 0), std::vector<idx>(N, 2));
+    ghz.apply(gt.H, {0});
+    for (idx i = 1; i < N; ++i)
+        ghz.apply(gt.CNOT, {i - 1, i});
+    EXPECT_EQ(std::vector<idx>(N - 1, 2), ghz.get_bond_dims());
+    EXPECT_NEAR(0, ghz.get_discarded(), 1e-10);
+    EXPECT_NEAR(1, ghz.norm(), 1e-10);
+
+    // truncated random state, the norm is kept and the infidelity is
+    // bounded by the discarded weight
+    std::vector<idx> dims{2, 2, 2, 2, 2, 2};
+    ket psi = randket(prod(dims));
+    MPS mps(psi, dims, 3);
+    for (idx chi : mps.get_bond_dims())
+        EXPECT_LE(chi, 3u);
+    EXPECT_GT(mps.get_discarded(), 0);
+    EXPECT_NEAR(1, mps.norm(), 1e-10);
+    EXPECT_GE(std::abs(mps.to_ket().dot(psi)), 1 - mps.get_discarded());
+
+    // relative discarded weight
+    MPS mps2(psi, dims, std::numeric_limits<idx>::max(), 0.1);
+    EXPECT_LE(mps2.get_discarded(), 0.1 * (dims.size() - 1));
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       qpp::MPS::MPS(const Eigen::MatrixBase<Derived>& psi,
+///       const std::vector<idx>& dims, idx max_chi, double max_discarded)
+TEST(qpp_MPS_MPS, Exceptions)
+{
+    EXPECT_THROW(MPS(cmat::Ones(4, 2), {2, 2}), Exception);
+    EXPECT_THROW(MPS(ket(randket(6)), {2, 2}), Exception);
+    EXPECT_THROW(MPS(ket(randket(4)), {2, 2}, 0), Exception);
+}
+/******************************************************************************/
+/// BEGIN cplx qpp::MPS::expval(const cmat& A,
+///       const std::vector<idx>& subsys) const
+TEST(qpp_MPS_expval, AllTests)
+{
+    std::vector<idx> dims{3, 2, 2, 3};
+    ket psi = randket(prod(dims));
+    MPS mps(psi, dims);
+    EXPECT_NEAR(0, norm(mps.to_ket() - psi), 1e-10);
+
+    cmat A = randH(3);
+    EXPECT_NEAR(0, std::abs(mps.expval(A, {3}) -
+                            psi.dot(ket(apply(psi, A, {3}, dims)))), 1e-10);
+    A = randH(6);
+    EXPECT_NEAR(0, std::abs(mps.expval(A, {2, 0}) -
+                            psi.dot(ket(apply(psi, A, {2, 0}, dims)))), 1e-10);
+}
+/******************************************************************************/
+/// BEGIN std::tuple<std::vector<idx>, double> qpp::MPS::measure_seq(
+///       std::vector<idx> subsys)
+TEST(qpp_MPS_measure_seq, AllTests)
+{
+    std::vector<idx> dims{2, 3, 2, 2};
+    ket psi = randket(prod(dims));
+    MPS mps(psi, dims);
+
+    auto meas = mps.measure_seq({3, 1});
+    std::vector<idx> result = std::get<0>(meas);
+    EXPECT_EQ(2u, result.size());
+
+    // projected dense state
+    cmat P1 = cmat::Zero(3, 3), P3 = cmat::Zero(2, 2);
+    P1(result[0], result[0]) = 1;
+    P3(result[1], result[1]) = 1;
+    ket expected = apply(apply(psi, P1, {1}, dims), P3, {3}, dims);
+    double prob = std::pow(norm(expected), 2);
+    EXPECT_NEAR(prob, std::get<1>(meas), 1e-10);
+    EXPECT_NEAR(0, norm(mps.to_ket() - expected / std::sqrt(prob)), 1e-10);
+}
@@ -0,0 +1,87 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/qcircuit.h"
+
+/******************************************************************************/
+/// BEGIN QCircuit& qpp::QCircuit::gate(const cmat& U,
+///       const std::vector<idx>& subsys, const std::string& name = {})
+///
+///       QCircuit& qpp::QCircuit::CTRL(const cmat& U,
+///       const std::vector<idx>& ctrl, const std::vector<idx>& subsys,
+///       const std::string& name = {})
+///
+///       QCircuit& qpp::QCircuit::channel(const std::vector<cmat>& Ks,
+///       const std::vector<idx>& subsys, const std::string& name = {})
+///
+///       QCircuit& qpp::QCircuit::measure(const std::vector<cmat>& Ks,
+///       const std::vector<idx>& subsys, const std::string& name = {})
+///
+///       QCircuit& qpp::QCircuit::measure(const std::vector<idx>& subsys,
+///       const std::string& name = {})
+TEST(qpp_QCircuit, Steps)
+{
+    QCircuit qc{3};
+    qc.gate(gt.H, {0}, "H")
+            .CTRL(gt.X, {0}, {1}, "CNOT")
+            .channel({gt.Id2 / std::sqrt(2), gt.Z / std::sqrt(2)}, {2})
+            .measure({0, 1});
+
+    ASSERT_EQ(4, qc.get_steps().size());
+    EXPECT_EQ(1, qc.get_num_measurements());
+    EXPECT_EQ(std::vector<idx>({2, 2, 2}), qc.get_dims());
+
+    EXPECT_TRUE(QCircuit::Type::GATE == qc.get_steps()[0].type);
+    EXPECT_TRUE(QCircuit::Type::CTRL_GATE == qc.get_steps()[1].type);
+    EXPECT_EQ(std::vector<idx>({0}), qc.get_steps()[1].ctrl);
+    EXPECT_TRUE(QCircuit::Type::CHANNEL == qc.get_steps()[2].type);
+    EXPECT_EQ(2, qc.get_steps()[2].ops.size());
+
+    // computational basis, stored with no projectors
+    const QCircuit::Step& m = qc.get_steps()[3];
+    EXPECT_TRUE(QCircuit::Type::MEASUREMENT == m.type);
+    EXPECT_TRUE(m.computational);
+    EXPECT_EQ(0, m.ops.size());
+    EXPECT_FALSE(qc.get_steps()[2].computational);
+
+    std::stringstream ss;
+    ss << qc;
+    EXPECT_EQ("dims: [2, 2, 2]\n"
+                      "GATE \"H\", subsys: [0]\n"
+                      "CTRL_GATE \"CNOT\", ctrl: [0], subsys: [1]\n"
+                      "CHANNEL, subsys: [2]\n"
+                      "MEASUREMENT, subsys: [0, 1]", ss.str());
+
+    // exceptions
+    EXPECT_THROW(qc.gate(gt.CNOT, {0}), Exception);
+    EXPECT_THROW(qc.gate(gt.X, {3}), Exception);
+    EXPECT_THROW(qc.CTRL(gt.X, {1}, {1}), Exception);
+    EXPECT_THROW(qc.channel({}, {0}), Exception);
+    EXPECT_THROW(qc.measure({gt.X, gt.CNOT}, {0}), Exception);
+    EXPECT_THROW(QCircuit(std::vector<idx>{2, 0}), Exception);
+}
+/******************************************************************************/
@@ -0,0 +1,154 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/qengine.h"
+
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       const cmat& qpp::QEngine::execute(
+///       const Eigen::MatrixBase<Derived>& state)
+TEST(qpp_QEngine_execute, Gates)
+{
+    // random circuit, executed vs applied gate by gate
+    std::vector<idx> dims{2, 3, 2, 2};
+    idx N = dims.size();
+    QCircuit qc{dims};
+    std::vector<ket> inputs{randket(prod(dims)), randket(prod(dims))};
+    std::vector<ket> expected = inputs;
+    for (idx i = 0; i < 15; ++i)
+    {
+        idx s = randidx(0, N - 1);
+        cmat U = randU(dims[s]);
+        if (i % 3 == 2)
+        {
+            // controlled on a qubit
+            idx c = s == 0 ? 2 : 0;
+            qc.CTRL(U, {c}, {s});
+            for (auto&& psi : expected)
+                psi = applyCTRL(psi, U, {c}, {s}, dims);
+        } else
+        {
+            qc.gate(U, {s});
+            for (auto&& psi : expected)
+                psi = apply(psi, U, {s}, dims);
+        }
+    }
+
+    QEngine engine{qc};
+    EXPECT_LE(engine.get_num_sweeps(), 15);
+    for (idx i = 0; i < inputs.size(); ++i)
+    {
+        cmat result = engine.execute(inputs[i]);
+        EXPECT_NEAR(0, norm(result - expected[i]), 1e-10);
+        EXPECT_EQ(0, engine.get_results().size());
+
+        // density matrix input
+        cmat rho = prj(inputs[i]);
+        result = engine.execute(rho);
+        EXPECT_NEAR(0, norm(result - prj(expected[i])), 1e-10);
+    }
+}
+
+TEST(qpp_QEngine_execute, ChannelsMeasurements)
+{
+    // Bell state, then measure both qubits
+    QCircuit qc{2};
+    qc.gate(gt.H, {0}).CTRL(gt.X, {0}, {1}).measure({0}).measure({1});
+    QEngine engine{qc};
+    EXPECT_EQ(3, engine.get_num_sweeps()); // H and CNOT are fused
+
+    ket psi = mket({0, 0});
+    for (idx i = 0; i < 10; ++i)
+    {
+        cmat result = engine.execute(psi);
+        ASSERT_EQ(2, engine.get_results().size());
+        idx m = engine.get_results()[0];
+        EXPECT_EQ(m, engine.get_results()[1]);
+        EXPECT_NEAR(0.5, engine.get_probs()[0], 1e-10);
+        EXPECT_NEAR(1, engine.get_probs()[1], 1e-10);
+        EXPECT_EQ(1, result.cols());
+        EXPECT_NEAR(1, std::abs(result(3 * m)), 1e-10);
+    }
+
+    // density matrix input, same results
+    for (idx i = 0; i < 10; ++i)
+    {
+        cmat result = engine.execute(prj(psi));
+        ASSERT_EQ(2, engine.get_results().size());
+        idx m = engine.get_results()[0];
+        EXPECT_EQ(m, engine.get_results()[1]);
+        EXPECT_NEAR(0.5, engine.get_probs()[0], 1e-10);
+        EXPECT_NEAR(1, engine.get_probs()[1], 1e-10);
+        EXPECT_NEAR(0, norm(result - prj(mket({m, m}))), 1e-10);
+    }
+
+    // Kraus measurement, only the sampled operator is applied
+    std::vector<cmat> Ms{prj(st.x0), prj(st.x1)};
+    QCircuit qc_kraus{2};
+    qc_kraus.gate(gt.H, {1}).measure(Ms, {1});
+    QEngine engine_kraus{qc_kraus};
+    for (auto&& in : {cmat(psi), prj(psi)})
+    {
+        cmat result = engine_kraus.execute(in);
+        ASSERT_EQ(1, engine_kraus.get_results().size());
+        EXPECT_EQ(0, engine_kraus.get_results()[0]);
+        EXPECT_NEAR(1, engine_kraus.get_probs()[0], 1e-10);
+        ket expected = kron(st.z0, st.x0);
+        EXPECT_NEAR(0, norm(result - (in.cols() == 1 ? cmat(expected)
+                                                     : prj(expected))),
+                    1e-10);
+    }
+
+    // many measured qubits, no projectors are built
+    QCircuit qc_wide{12};
+    std::vector<idx> all(12);
+    std::iota(std::begin(all), std::end(all), 0);
+    qc_wide.measure(all);
+    ket phi = randket(4096);
+    QEngine engine_wide{qc_wide};
+    cmat collapsed = engine_wide.execute(phi);
+    ASSERT_EQ(1, engine_wide.get_results().size());
+    EXPECT_NEAR(std::norm(phi(engine_wide.get_results()[0])),
+                engine_wide.get_probs()[0], 1e-10);
+    EXPECT_NEAR(1, norm(collapsed), 1e-10);
+    EXPECT_EQ(1, (collapsed.array().abs() > 1e-10).count());
+
+    // a channel turns the ket into a density matrix
+    QCircuit qc_noise{2};
+    std::vector<cmat> Ks{gt.Id2 / std::sqrt(2), gt.Z / std::sqrt(2)};
+    qc_noise.gate(gt.H, {0}).channel(Ks, {0}).CTRL(gt.X, {0}, {1});
+    cmat expected = applyCTRL(
+            apply(prj(apply(psi, gt.H, {0}, 2)), Ks, {0}, {2, 2}),
+            gt.X, {0}, {1}, 2);
+    cmat result = QEngine{qc_noise}.execute(psi);
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+    // exceptions
+    EXPECT_THROW(engine.execute(ket(mket({0, 0, 0}))), Exception);
+    EXPECT_THROW(engine.execute(cmat(cmat::Zero(4, 2))), Exception);
+    EXPECT_THROW(QEngine(qc, 0), Exception);
+}
+/******************************************************************************/
@@ -0,0 +1,111 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/qtrajectory_engine.h"
+
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       void qpp::QTrajectoryEngine::run(
+///       const Eigen::MatrixBase<Derived>& psi, idx num_traj,
+///       bool with_rho = false)
+TEST(qpp_QTrajectoryEngine_run, NoiselessCircuit)
+{
+    // without channels every trajectory is the exact evolution
+    std::vector<idx> dims{2, 3, 2};
+    QCircuit qc{dims};
+    cmat U = randU(6);
+    qc.gate(gt.H, {0}).gate(U, {1, 2}).CTRL(gt.X, {0}, {2});
+    ket psi = randket(prod(dims));
+    ket expected = applyCTRL(apply(apply(psi, gt.H, {0}, dims), U, {1, 2},
+                                   dims), gt.X, {0}, {2}, dims);
+
+    QTrajectoryEngine engine{qc};
+    engine.observable(gt.Z, {2});
+    engine.run(psi, 3, true);
+
+    EXPECT_NEAR(0, norm(engine.get_rho() - prj(expected)), 1e-10);
+    ket Zexpected = apply(expected, gt.Z, {2}, dims);
+    cplx expected_Z = expected.dot(Zexpected);
+    EXPECT_NEAR(0, std::abs(engine.get_expvals()[0] - expected_Z), 1e-10);
+    EXPECT_EQ(3, engine.get_traj_results().size());
+
+    engine.run(psi, 2);
+    EXPECT_EQ(0, engine.get_rho().size());
+}
+
+TEST(qpp_QTrajectoryEngine_run, NoisyCircuit)
+{
+    // amplitude damping after a Hadamard, vs the density matrix engine
+    double gamma = 0.3;
+    cmat K0 = cmat::Zero(2, 2), K1 = cmat::Zero(2, 2);
+    K0 << 1, 0, 0, std::sqrt(1 - gamma);
+    K1 << 0, std::sqrt(gamma), 0, 0;
+
+    QCircuit qc{2};
+    qc.gate(gt.H, {0}).channel({K0, K1}, {0}).CTRL(gt.X, {0}, {1})
+            .channel({K0, K1}, {1});
+    ket psi = mket({0, 0});
+    cmat expected = QEngine{qc}.execute(psi);
+
+    idx num_traj = 4000;
+    QTrajectoryEngine engine{qc};
+    engine.observable(gt.Z, {0}).observable(gt.Z, {1});
+    engine.run(psi, num_traj, true);
+
+    // statistical error ~ 1 / sqrt(num_traj)
+    EXPECT_NEAR(0, norm(engine.get_rho() - expected), 0.05);
+    EXPECT_NEAR(std::real(trace(expected * kron(gt.Z, gt.Id2))),
+                std::real(engine.get_expvals()[0]), 0.05);
+    EXPECT_NEAR(std::real(trace(expected * kron(gt.Id2, gt.Z))),
+                std::real(engine.get_expvals()[1]), 0.05);
+    EXPECT_NEAR(1, std::abs(trace(engine.get_rho())), 1e-10);
+}
+
+TEST(qpp_QTrajectoryEngine_run, Measurements)
+{
+    // Bell pair, both measurement results agree on every trajectory
+    QCircuit qc{2};
+    qc.gate(gt.H, {0}).CTRL(gt.X, {0}, {1}).measure({0}).measure({1});
+    QTrajectoryEngine engine{qc};
+    engine.run(mket({0, 0}), 100);
+
+    idx ones = 0;
+    for (auto&& results : engine.get_traj_results())
+    {
+        ASSERT_EQ(2, results.size());
+        EXPECT_EQ(results[0], results[1]);
+        ones += results[0];
+    }
+    EXPECT_GT(ones, 0);
+    EXPECT_LT(ones, 100);
+
+    // exceptions
+    EXPECT_THROW(engine.run(mket({0, 0}), 0), Exception);
+    EXPECT_THROW(engine.run(mket({0, 0, 0}), 1), Exception);
+    EXPECT_THROW(engine.run(cmat::Ones(4, 2), 1), Exception);
+    EXPECT_THROW(engine.observable(gt.CNOT, {0}), Exception);
+}
+/******************************************************************************/
@@ -0,0 +1,191 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/sparse_ket.h"
+
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       qpp::SparseKet& qpp::SparseKet::applyCTRL(
+///       const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys)
+TEST(qpp_SparseKet_applyCTRL, DenseComparison)
+{
+    // sparse vs dense, random gates on a basis state of mixed dimensions
+    std::vector<idx> dims{2, 3, 2, 3};
+    idx N = dims.size();
+    SparseKet psi({1, 2, 0, 1}, dims);
+    ket expected = mket({1, 2, 0, 1}, dims);
+    for (idx i = 0; i < 12; ++i)
+    {
+        idx s = randidx(0, N - 1);
+        cmat U = i % 2 ? randU(dims[s]) : cmat(gt.Xd(dims[s]));
+        if (i % 3 == 2)
+        {
+            // controlled on the other subsystem of the same dimension
+            idx c = (s + 2) % N;
+            psi.applyCTRL(U, {c}, {s});
+            expected = applyCTRL(expected, U, {c}, {s}, dims);
+        } else
+        {
+            psi = apply(psi, U, {s});
+            expected = apply(expected, U, {s}, dims);
+        }
+    }
+    EXPECT_NEAR(0, norm(psi.dense() - expected), 1e-10);
+
+    // two-subsystem gate, in reversed order
+    cmat U = randU(6);
+    psi.apply(U, {3, 0});
+    expected = apply(expected, U, {3, 0}, dims);
+    EXPECT_NEAR(0, norm(psi.dense() - expected), 1e-10);
+}
+
+TEST(qpp_SparseKet_applyCTRL, KeepsSparsity)
+{
+    // 60 qubits, GHZ state and a permutation/diagonal circuit
+    idx N = 60;
+    std::vector<idx> dims(N, 2);
+    SparseKet psi(std::vector<idx>(N, 0), dims);
+    psi.apply(gt.H, {0});
+    for (idx i = 1; i < N; ++i)
+        psi.applyCTRL(gt.X, {i - 1}, {i});
+    EXPECT_EQ(2, psi.get_nnz());
+    EXPECT_NEAR(1 / std::sqrt(2), std::abs(psi(std::vector<idx>(N, 1))),
+                1e-10);
+
+    for (idx i = 0; i < N; i += 7)
+        psi.apply(gt.Z, {i}).applyCTRL(gt.S, {i}, {N - 1 - i});
+    psi.apply(gt.SWAP, {5, 42}).applyCTRL(gt.X, {0, 1}, {59});
+    EXPECT_EQ(2, psi.get_nnz());
+    EXPECT_NEAR(1, psi.norm(), 1e-10);
+
+    // interference, exact zeros are dropped
+    SparseKet phi(std::vector<idx>(N, 0), dims);
+    phi.apply(gt.H, {10}).apply(gt.H, {10});
+    EXPECT_EQ(1, phi.get_nnz());
+
+    // qutrit controls, A^i applied when all controls are in the state i
+    std::vector<idx> dims3{3, 3, 3};
+    SparseKet chi({2, 2, 0}, dims3);
+    chi.applyCTRL(gt.Xd(3), {0, 1}, {2});
+    EXPECT_NEAR(1, std::abs(chi({2, 2, 2})), 1e-10);
+    chi.applyCTRL(gt.Xd(3), {0, 2}, {1});
+    EXPECT_NEAR(1, std::abs(chi({2, 1, 2})), 1e-10);
+}
+
+TEST(qpp_SparseKet_applyCTRL, Exceptions)
+{
+    std::vector<idx> dims{2, 3, 2};
+    SparseKet psi({0, 0, 0}, dims);
+    EXPECT_THROW(psi.apply(gt.H, {1}), Exception);
+    EXPECT_THROW(psi.apply(gt.H, {3}), Exception);
+    EXPECT_THROW(psi.applyCTRL(gt.X, {0, 1}, {2}), Exception);
+    EXPECT_THROW(psi.applyCTRL(gt.X, {0}, {0}), Exception);
+    EXPECT_THROW(SparseKet({0, 3, 0}, dims), Exception);
+    EXPECT_THROW(SparseKet(cmat::Ones(4, 2), {2, 2}), Exception);
+    EXPECT_THROW(SparseKet(std::vector<idx>(70, 0),
+                           std::vector<idx>(70, 2)), Exception);
+}
+/******************************************************************************/
+/// BEGIN inline std::tuple<std::vector<idx>, double, SparseKet>
+///       qpp::measure_seq(const SparseKet& psi, std::vector<idx> subsys)
+TEST(qpp_measure_seq_SparseKet, AllTests)
+{
+    // GHZ state, the outcomes are perfectly correlated
+    idx N = 40;
+    std::vector<idx> dims(N, 2);
+    SparseKet psi(std::vector<idx>(N, 0), dims);
+    psi.apply(gt.H, {0});
+    for (idx i = 1; i < N; ++i)
+        psi.applyCTRL(gt.X, {0}, {i});
+
+    auto m = measure_seq(psi, {17, 3});
+    std::vector<idx> results = std::get<0>(m);
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_NEAR(0.5, std::get<1>(m), 1e-10);
+    const SparseKet& rest = std::get<2>(m);
+    EXPECT_EQ(N - 2, rest.get_dims().size());
+    EXPECT_EQ(1, rest.get_nnz());
+    EXPECT_NEAR(1, std::abs(rest(std::vector<idx>(N - 2, results[0]))),
+                1e-10);
+
+    // mixed dimensions, vs the dense post-measurement states
+    std::vector<idx> dims1{2, 3, 2};
+    ket phi = randket(12);
+    SparseKet sphi(phi, dims1);
+    auto m1 = measure_seq(sphi, {1});
+    idx r = std::get<0>(m1)[0];
+    ket expected = ip(ket(mket({r}, {3})), phi, {1}, dims1);
+    EXPECT_NEAR(std::pow(norm(expected), 2), std::get<1>(m1), 1e-10);
+    EXPECT_NEAR(0, norm(std::get<2>(m1).dense() - expected / norm(expected)),
+                1e-10);
+
+    // everything measured
+    auto m2 = measure_seq(sphi, {0, 1, 2});
+    EXPECT_NEAR(1, std::abs(std::get<2>(m2)(0)), 1e-10);
+
+    // exceptions
+    EXPECT_THROW(measure_seq(sphi, {3}), Exception);
+}
+/******************************************************************************/
+/// BEGIN inline SparseKet qpp::ip(const SparseKet& phi, const SparseKet& psi,
+///       const std::vector<idx>& subsys)
+TEST(qpp_ip_SparseKet, AllTests)
+{
+    std::vector<idx> dims{2, 3, 2};
+    ket psi = randket(12);
+    ket phi = randket(6);
+    SparseKet result = ip(SparseKet(phi, {3, 2}), SparseKet(psi, dims), {1, 0});
+    ket expected = ip(phi, psi, {1, 0}, dims);
+    EXPECT_NEAR(0, norm(result.dense() - expected), 1e-10);
+
+    // full inner product
+    ket chi = randket(12);
+    EXPECT_NEAR(0, std::abs(SparseKet(chi, dims).dot(SparseKet(psi, dims))
+                            - chi.dot(psi)), 1e-10);
+    EXPECT_NEAR(0, std::abs(SparseKet({1, 0, 1}, dims).dot(
+            SparseKet(psi, dims)) - psi(7)), 1e-10);
+
+    // exceptions
+    EXPECT_THROW(ip(SparseKet(phi, {3, 2}), SparseKet(psi, dims), {0, 1}),
+                 Exception);
+}
+/******************************************************************************/
+/// BEGIN qpp::SparseKet& qpp::SparseKet::prune(double chop = qpp::chop)
+TEST(qpp_SparseKet_prune, AllTests)
+{
+    std::vector<idx> dims{2, 2};
+    ket psi = ket::Zero(4);
+    psi << 1, 1e-12, 0, 1;
+    SparseKet spsi(psi, dims);
+    EXPECT_EQ(3, spsi.get_nnz());
+    spsi.prune();
+    EXPECT_EQ(2, spsi.get_nnz());
+    EXPECT_EQ(qpp::chop, spsi.get_chop());
+    EXPECT_EQ(2, SparseKet(psi, dims, qpp::chop).get_nnz());
+}
@@ -0,0 +1,181 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "classes/stabilizer_state.h"
+/******************************************************************************/
+/// BEGIN qpp::StabilizerState& qpp::StabilizerState::apply(
+///       const cmat& U, const std::vector<idx>& subsys)
+TEST(qpp_StabilizerState_apply, DenseComparison)
+{
+    // random Clifford circuit vs the dense state vector, up to a phase
+    idx n = 5;
+    std::vector<idx> dims(n, 2);
+    std::vector<cmat> gates1{gt.Id2, gt.X, gt.Y, gt.Z, gt.H, gt.S,
+                             adjoint(gt.S)};
+    std::vector<cmat> gates2{gt.CNOT, gt.CZ, gt.SWAP};
+
+    StabilizerState stab(n);
+    ket psi = mket(std::vector<idx>(n, 0));
+    for (idx i = 0; i < 60; ++i)
+    {
+        idx a = randidx(0, n - 1);
+        idx b = (a + randidx(1, n - 1)) % n;
+        if (i % 3 == 0)
+        {
+            cmat U = gates2[randidx(0, gates2.size() - 1)];
+            stab.apply(U, {a, b});
+            psi = apply(psi, U, {a, b}, dims);
+        } else
+        {
+            cmat U = gates1[randidx(0, gates1.size() - 1)];
+            stab.apply(U, {a});
+            psi = apply(psi, U, {a}, dims);
+        }
+        EXPECT_NEAR(1, std::abs(stab.to_ket().dot(psi)), 1e-10);
+    }
+
+    // same gates up to a global phase
+    stab.apply(1_i * gt.H, {0});
+    psi = apply(psi, gt.H, {0}, dims);
+    EXPECT_NEAR(1, std::abs(stab.to_ket().dot(psi)), 1e-10);
+    stab.apply(std::exp(0.3_i) * gt.CZ, {2, 4});
+    psi = apply(psi, gt.CZ, {2, 4}, dims);
+    EXPECT_NEAR(1, std::abs(stab.to_ket().dot(psi)), 1e-10);
+
+    // same trace overlap with a supported gate, but not equal to it
+    EXPECT_THROW(stab.apply(gt.X + gt.Z, {0}), Exception);
+    EXPECT_THROW(stab.apply(2. * gt.X, {0}), Exception);
+    EXPECT_THROW(stab.apply(cmat(gt.CNOT + kron(gt.Z, gt.Z)), {0, 1}),
+                 Exception);
+
+    // not Clifford, or not matching the subsystems
+    EXPECT_THROW(stab.apply(gt.T, {0}), Exception);
+    EXPECT_THROW(stab.apply(gt.H, {0, 1}), Exception);
+    EXPECT_THROW(stab.apply(gt.CNOT, {1, 1}), Exception);
+    EXPECT_THROW(stab.apply(gt.H, {n}), Exception);
+}
+/******************************************************************************/
+/// BEGIN idx qpp::StabilizerState::measure(idx j)
+TEST(qpp_StabilizerState_measure, DenseComparison)
+{
+    // measurements interleaved with gates, the sampled outcomes must have
+    // non-zero probability in the dense state vector
+    idx n = 4;
+    std::vector<idx> dims(n, 2);
+    StabilizerState stab(n);
+    ket psi = mket(std::vector<idx>(n, 0));
+    for (idx i = 0; i < 60; ++i)
+    {
+        idx a = randidx(0, n - 1);
+        idx b = (a + randidx(1, n - 1)) % n;
+        switch (i % 4)
+        {
+            case 0:
+                stab.H(a);
+                psi = apply(psi, gt.H, {a}, dims);
+                break;
+            case 1:
+                stab.CNOT(a, b);
+                psi = apply(psi, gt.CNOT, {a, b}, dims);
+                break;
+            case 2:
+                stab.S(a);
+                psi = apply(psi, gt.S, {a}, dims);
+                break;
+            case 3:
+                idx m = stab.measure(a);
+                cmat P = cmat::Zero(2, 2);
+                P(m, m) = 1;
+                psi = apply(psi, P, {a}, dims);
+                ASSERT_GT(norm(psi), 0.5); // probability 1/2 or 1
+                psi /= norm(psi);
+                break;
+        }
+        EXPECT_NEAR(1, std::abs(stab.to_ket().dot(psi)), 1e-10);
+    }
+}
+
+TEST(qpp_StabilizerState_measure, ManyQubits)
+{
+    // GHZ state on 2000 qubits, all the results are equal
+    idx n = 2000;
+    StabilizerState stab(n);
+    stab.H(0);
+    for (idx i = 1; i < n; ++i)
+        stab.CNOT(0, i);
+
+    std::vector<idx> result = stab.measure_seq({1234, 0, n - 1, 17});
+    for (idx m : result)
+        EXPECT_EQ(result[0], m);
+
+    // measuring again gives the same result
+    EXPECT_EQ(result[0], stab.measure(999));
+
+    // repetition code syndrome extraction, no error
+    idx d = 101; // data qubits, followed by d - 1 ancillas
+    StabilizerState code(2 * d - 1);
+    for (idx i = 0; i < d - 1; ++i)
+    {
+        code.CNOT(i, d + i);
+        code.CNOT(i + 1, d + i);
+    }
+    code.X(50); // error on a data qubit
+    for (idx i = 0; i < d - 1; ++i)
+    {
+        code.CNOT(i, d + i);
+        code.CNOT(i + 1, d + i);
+    }
+    for (idx i = 0; i < d - 1; ++i)
+        EXPECT_EQ(i == 49 || i == 50 ? 1 : 0, code.measure(d + i));
+}
+/******************************************************************************/
+/// BEGIN ket qpp::StabilizerState::to_ket() const
+TEST(qpp_StabilizerState_to_ket, AllTests)
+{
+    // |0...0>
+    EXPECT_NEAR(0, norm(StabilizerState(3).to_ket() - mket({0, 0, 0})),
+                1e-10);
+
+    // Bell state
+    StabilizerState stab(2);
+    stab.H(0).CNOT(0, 1);
+    EXPECT_NEAR(0, norm(stab.to_ket() - st.b00), 1e-10);
+
+    // graph state of the triangle graph
+    StabilizerState graph(3);
+    graph.H(0).H(1).H(2).CZ(0, 1).CZ(1, 2).CZ(0, 2);
+    ket expected = kron(st.x0, st.x0, st.x0);
+    expected = apply(expected, gt.CZ, {0, 1}, {2, 2, 2});
+    expected = apply(expected, gt.CZ, {1, 2}, {2, 2, 2});
+    expected = apply(expected, gt.CZ, {0, 2}, {2, 2, 2});
+    EXPECT_NEAR(0, norm(graph.to_ket() - expected), 1e-10);
+
+    // Y eigenstate, the phase is fixed by the first basis state
+    StabilizerState y(1);
+    y.H(0).S(0).Z(0);
+    EXPECT_NEAR(0, norm(y.to_ket() - (st.z0 - 1_i * st.z1) / std::sqrt(2)),
+                1e-10);
+}
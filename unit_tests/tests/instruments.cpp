@@ -26,6 +26,37 @@ using namespace qpp;
 
 // Unit testing "instruments.h"
 
+/******************************************************************************/
+/// BEGIN template<typename Derived1, typename Derived2>
+///       dyn_mat<typename Derived1::Scalar> qpp::overlaps(
+///       const Eigen::MatrixBase<Derived1>& Phis,
+///       const Eigen::MatrixBase<Derived2>& Psis)
+TEST(qpp_overlaps, AllTests)
+{
+    idx D = 8;
+    cmat Phis(D, 3), Psis(D, 4);
+    for (idx i = 0; i < 3; ++i)
+        Phis.col(i) = randket(D);
+    for (idx j = 0; j < 4; ++j)
+        Psis.col(j) = randket(D);
+
+    cmat result = overlaps(Phis, Psis);
+    ASSERT_EQ(3, result.rows());
+    ASSERT_EQ(4, result.cols());
+    for (idx i = 0; i < 3; ++i)
+        for (idx j = 0; j < 4; ++j)
+            EXPECT_NEAR(0, std::abs(result(i, j) -
+                                    Phis.col(i).dot(Psis.col(j))), 1e-10);
+
+    // Gram matrix of normalized states
+    cmat G = overlaps(Psis, Psis);
+    for (idx j = 0; j < 4; ++j)
+        EXPECT_NEAR(1, std::abs(G(j, j)), 1e-10);
+    EXPECT_NEAR(0, norm(G - adjoint(G)), 1e-10);
+
+    // exceptions
+    EXPECT_THROW(overlaps(Phis, cmat(Psis.topRows(D - 1))), Exception);
+}
 /******************************************************************************/
 /// BEGIN template<typename Derived> dyn_col_vect<typename Derived::Scalar>
 ///       qpp::ip(const Eigen::MatrixBase<Derived>& phi,
@@ -48,18 +79,20 @@ TEST(qpp_ip_qubits, AllTests)
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>> qpp::measure(
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>> qpp::measure(
 ///       const Eigen::MatrixBase<Derived>& A,
-///       const cmat& U)
+///       const dyn_mat<typename Derived::Scalar>& U)
 TEST(qpp_measure_full_orthonormal, AllTests)
 {
 
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>> qpp::measure(
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>> qpp::measure(
 ///       const Eigen::MatrixBase<Derived>& A,
-///       const cmat& V,
+///       const dyn_mat<typename Derived::Scalar>& V,
 ///       const std::vector<idx>& subsys,
 ///       const std::vector<idx>& dims)
 TEST(qpp_measure_rankone, AllTests)
@@ -68,9 +101,10 @@ TEST(qpp_measure_rankone, AllTests)
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>> qpp::measure(
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>> qpp::measure(
 ///       const Eigen::MatrixBase<Derived>& A,
-///       const cmat& V,
+///       const dyn_mat<typename Derived::Scalar>& V,
 ///       const std::vector<idx>& subsys,
 ///       idx d = 2)
 TEST(qpp_measure_rankone_qubits, AllTests)
@@ -79,18 +113,20 @@ TEST(qpp_measure_rankone_qubits, AllTests)
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
 ///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
-///       const std::initializer_list<cmat>& Ks)
+///       const std::initializer_list<dyn_mat<typename Derived::Scalar>>& Ks)
 TEST(qpp_measure_full_kraus_initlist, AllTests)
 {
 
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
 ///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
-///       const std::initializer_list<cmat>& Ks,
+///       const std::initializer_list<dyn_mat<typename Derived::Scalar>>& Ks,
 ///       const std::vector<idx>& subsys,
 ///       const std::vector<idx>& dims)
 TEST(qpp_measure_kraus_initlist, AllTests)
@@ -99,9 +135,10 @@ TEST(qpp_measure_kraus_initlist, AllTests)
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
 ///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
-///       const std::initializer_list<cmat>& Ks,
+///       const std::initializer_list<dyn_mat<typename Derived::Scalar>>& Ks,
 ///       const std::vector<idx>& subsys,
 ///       idx d = 2)
 TEST(qpp_measure_kraus_initlist_qubits, AllTests)
@@ -110,29 +147,95 @@ TEST(qpp_measure_kraus_initlist_qubits, AllTests)
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
 ///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
-///       const std::vector<cmat>& Ks)
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks)
 TEST(qpp_measure_full_kraus_vector, AllTests)
 {
 
 }
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
+///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<dyn_sp_mat<typename Derived::Scalar>>& Ks)
+TEST(qpp_measure_full_sparse_kraus, AllTests)
+{
+    // parity measurement of 3 qubits, sparse vs dense projectors
+    cmat ZZZ = kron(gt.Z, gt.Z, gt.Z);
+    std::vector<cmat> Ks{(gt.Id(8) + ZZZ) / 2., (gt.Id(8) - ZZZ) / 2.};
+    std::vector<sp_cmat> sKs{Ks[0].sparseView(), Ks[1].sparseView()};
+
+    // state vector
+    ket psi = randket(8);
+    auto m = measure(psi, sKs);
+    auto md = measure(psi, Ks);
+    for (idx i = 0; i < 2; ++i)
+    {
+        EXPECT_NEAR(std::get<1>(md)[i], std::get<1>(m)[i], 1e-10);
+        EXPECT_NEAR(0, norm(std::get<2>(m)[i] - std::get<2>(md)[i]), 1e-10);
+    }
+
+    // density matrix
+    cmat rho = randrho(8);
+    m = measure(rho, sKs);
+    md = measure(rho, Ks);
+    for (idx i = 0; i < 2; ++i)
+    {
+        EXPECT_NEAR(std::get<1>(md)[i], std::get<1>(m)[i], 1e-10);
+        EXPECT_NEAR(0, norm(std::get<2>(m)[i] - std::get<2>(md)[i]), 1e-10);
+    }
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
 ///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
-///       const std::vector<cmat>& Ks,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
 ///       const std::vector<idx>& subsys,
 ///       const std::vector<idx>& dims)
 TEST(qpp_measure_kraus_vector, AllTests)
 {
 
 }
+
+TEST(qpp_measure_kraus_vector, SinglePrecision)
+{
+    // complex<float> vs complex<double>, projective measurement of a qutrit
+    std::vector<idx> dims{2, 3, 2};
+    ket psi = randket(prod(dims));
+    std::vector<cmat> Ks(3, cmat::Zero(3, 3));
+    std::vector<cmat_f> Ks_f;
+    for (idx i = 0; i < 3; ++i)
+    {
+        Ks[i](i, i) = 1;
+        Ks_f.push_back(Ks[i].cast<cplx_f>());
+    }
+
+    auto result = measure(psi, Ks, {1}, dims);
+    auto result_f = measure(ket_f(psi.cast<cplx_f>()), Ks_f, {1}, dims);
+    for (idx i = 0; i < 3; ++i)
+    {
+        EXPECT_NEAR(std::get<1>(result)[i], std::get<1>(result_f)[i], 1e-5);
+        cmat state = std::get<2>(result_f)[i].cast<cplx>();
+        EXPECT_NEAR(0, norm(state - std::get<2>(result)[i]), 1e-5);
+    }
+
+    // sequential measurement, the post-measurement state stays in single
+    // precision
+    cmat_f rho_f = prj(psi).cast<cplx_f>();
+    auto seq_f = measure_seq(rho_f, {0, 2}, dims);
+    EXPECT_EQ(3, std::get<2>(seq_f).rows());
+    EXPECT_NEAR(1, std::abs(trace(std::get<2>(seq_f))), 1e-5);
+}
 /******************************************************************************/
 /// BEGIN template<typename Derived>
-///       std::tuple<idx, std::vector<double>, std::vector<cmat>>
+///       std::tuple<idx, std::vector<double>,
+///       std::vector<dyn_mat<typename Derived::Scalar>>>
 ///       qpp::measure(const Eigen::MatrixBase<Derived>& A,
-///       const std::vector<cmat>& Ks,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
 ///       const std::vector<idx>& subsys,
 ///       idx d = 2)
 TEST(qpp_measure_kraus_vector_qubits, AllTests)
@@ -140,7 +243,129 @@ TEST(qpp_measure_kraus_vector_qubits, AllTests)
 
 }
 /******************************************************************************/
-/// BEGIN template<typename Derived> std::tuple<std::vector<idx>, double, cmat>
+/// BEGIN template<typename Derived>
+///       std::tuple<idx, std::vector<double>,
+///       dyn_mat<typename Derived::Scalar>>
+///       qpp::measure_collapse(const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_measure_collapse_kraus, AllTests)
+{
+    // same result as qpp::measure() for the same random state
+    std::vector<idx> dims{2, 3, 2};
+    std::vector<idx> subsys{2, 0};
+    std::vector<cmat> Ks = randkraus(3, 4);
+    ket psi = randket(12);
+    cmat rho = randrho(12);
+
+    for (auto&& A : {cmat(psi), rho})
+    {
+        std::mt19937 rng = RandomDevices::get_instance().rng_;
+        auto expected = measure(A, Ks, subsys, dims);
+        RandomDevices::get_instance().rng_ = rng;
+        auto result = measure_collapse(A, Ks, subsys, dims);
+
+        idx m = std::get<0>(result);
+        EXPECT_EQ(std::get<0>(expected), m);
+        for (idx i = 0; i < Ks.size(); ++i)
+            EXPECT_NEAR(std::get<1>(expected)[i], std::get<1>(result)[i],
+                        1e-7);
+        EXPECT_NEAR(0, norm(std::get<2>(expected)[m] - std::get<2>(result)),
+                    1e-7);
+    }
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::tuple<idx, std::vector<double>,
+///       dyn_mat<typename Derived::Scalar>>
+///       qpp::measure_collapse(const Eigen::MatrixBase<Derived>& A,
+///       const dyn_mat<typename Derived::Scalar>& V,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_measure_collapse_rankone, AllTests)
+{
+    std::vector<idx> dims{2, 3, 2};
+    std::vector<idx> subsys{1, 0};
+    ket psi = randket(12);
+    cmat rho = randrho(12);
+
+    // random basis, computational basis, and a rank-1 POVM with 3 elements
+    cmat POVM = cmat::Zero(6, 3);
+    POVM.col(0) = randket(6) / std::sqrt(3);
+    POVM.col(1) = randket(6) / std::sqrt(3);
+    POVM.col(2) = randket(6) / std::sqrt(3);
+    for (auto&& V : {randU(6), cmat(gt.Id(6)), POVM})
+        for (auto&& A : {cmat(psi), rho})
+        {
+            std::mt19937 rng = RandomDevices::get_instance().rng_;
+            auto expected = measure(A, V, subsys, dims);
+            RandomDevices::get_instance().rng_ = rng;
+            auto result = measure_collapse(A, V, subsys, dims);
+
+            idx m = std::get<0>(result);
+            EXPECT_EQ(std::get<0>(expected), m);
+            ASSERT_EQ(static_cast<idx>(V.cols()),
+                      std::get<1>(result).size());
+            for (idx i = 0; i < static_cast<idx>(V.cols()); ++i)
+                EXPECT_NEAR(std::get<1>(expected)[i],
+                            std::get<1>(result)[i], 1e-7);
+            EXPECT_NEAR(0, norm(std::get<2>(expected)[m] -
+                                std::get<2>(result)), 1e-7);
+        }
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::tuple<idx, std::vector<double>>
+///       qpp::measure_inplace(Eigen::MatrixBase<Derived>& state,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_measure_inplace_kraus, AllTests)
+{
+    std::vector<idx> dims{2, 3, 2};
+    std::vector<idx> subsys{1};
+    std::vector<cmat> Ks = randkraus(2, 3);
+    ket psi = randket(12);
+
+    ket phi = psi;
+    auto result = measure_inplace(phi, Ks, subsys, dims);
+    idx m = std::get<0>(result);
+    double p = std::pow(norm(apply(psi, Ks[m], subsys, dims)), 2);
+    EXPECT_NEAR(p, std::get<1>(result)[m], 1e-7);
+    ket expected = apply(psi, Ks[m], subsys, dims) / std::sqrt(p);
+    EXPECT_NEAR(0, norm(expected - phi), 1e-7);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::tuple<idx, std::vector<double>>
+///       qpp::measure_inplace(Eigen::MatrixBase<Derived>& state,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_measure_inplace_computational, AllTests)
+{
+    std::vector<idx> dims{2, 3, 2, 2};
+    std::vector<idx> subsys{3, 1};
+    ket psi = randket(24);
+    std::vector<double> prob = std::get<1>(measure(psi, gt.Id(6), subsys,
+                                                   dims));
+
+    ket phi = psi;
+    auto result = measure_inplace(phi, subsys, dims);
+    idx m = std::get<0>(result);
+    for (idx i = 0; i < 6; ++i)
+        EXPECT_NEAR(prob[i], std::get<1>(result)[i], 1e-7);
+
+    // projection onto |m / 3> on subsystem 3 and |m % 3> on subsystem 1
+    cmat P = cmat::Zero(6, 6);
+    P(m, m) = 1;
+    ket expected = apply(psi, P, subsys, dims) / std::sqrt(prob[m]);
+    EXPECT_NEAR(0, norm(expected - phi), 1e-7);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::tuple<std::vector<idx>, double,
+///       dyn_mat<typename Derived::Scalar>>
 ///       qpp::measure_seq(const Eigen::MatrixBase<Derived>& A,
 ///       std::vector<idx> subsys,
 ///       idx d = 2)
@@ -149,7 +374,9 @@ TEST(qpp_measure_seq_qubits, AllTests)
 
 }
 /******************************************************************************/
-/// BEGIN template<typename Derived> std::tuple<std::vector<idx>, double, cmat>
+/// BEGIN template<typename Derived>
+///       std::tuple<std::vector<idx>, double,
+///       dyn_mat<typename Derived::Scalar>>
 ///       qpp::measure_seq(const Eigen::MatrixBase<Derived>& A,
 ///       std::vector<idx> subsys,
 ///       std::vector<idx> dims)
@@ -158,3 +385,99 @@ TEST(qpp_measure_seq, AllTests)
 
 }
 /******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::vector<double> qpp::probs(const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_probs, AllTests)
+{
+    // same probabilities as qpp::measure()
+    std::vector<idx> dims{2, 3, 2, 2};
+    ket psi = randket(24);
+    cmat rho = randrho(24);
+    for (auto&& subsys : std::vector<std::vector<idx>>{{0}, {3}, {3, 1},
+                                                       {1, 2, 3},
+                                                       {3, 2, 1, 0}})
+    {
+        idx Dsubsys = 1;
+        for (auto&& it : subsys)
+            Dsubsys *= dims[it];
+        std::vector<double> expected_psi =
+                std::get<1>(measure(psi, gt.Id(Dsubsys), subsys, dims));
+        std::vector<double> expected_rho =
+                std::get<1>(measure(rho, gt.Id(Dsubsys), subsys, dims));
+        std::vector<double> result_psi = probs(psi, subsys, dims);
+        std::vector<double> result_rho = probs(rho, subsys, dims);
+        for (idx m = 0; m < Dsubsys; ++m)
+        {
+            EXPECT_NEAR(expected_psi[m], result_psi[m], 1e-7);
+            EXPECT_NEAR(expected_rho[m], result_rho[m], 1e-7);
+        }
+    }
+
+    // states larger than a chunk
+    std::vector<idx> qubits(16, 2);
+    psi = randket(65536);
+    std::vector<double> result = probs(psi, {15, 2}, qubits);
+    std::vector<double> expected(4, 0);
+    for (idx i = 0; i < 65536; ++i)
+        expected[(i & 1) * 2 + ((i >> 13) & 1)] += std::norm(psi(i));
+    for (idx m = 0; m < 4; ++m)
+        EXPECT_NEAR(expected[m], result[m], 1e-7);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::vector<idx> qpp::sample(const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims,
+///       idx shots)
+TEST(qpp_sample, AllTests)
+{
+    // deterministic outcomes
+    std::vector<idx> dims{2, 3, 2};
+    ket psi = mket({1, 2, 0}, dims);
+    std::vector<idx> result = sample(psi, {2, 1}, dims, 100000);
+    EXPECT_EQ(100000u, result.size());
+    for (auto&& it : result)
+        EXPECT_EQ(2u, it); // 0 * 3 + 2
+
+    // frequencies match the measurement probabilities
+    psi = randket(12);
+    cmat rho = prj(psi);
+    std::vector<double> prob = std::get<1>(measure(psi, gt.Id(6), {2, 1},
+                                                   dims));
+    idx shots = 100000;
+    result = sample(rho, {2, 1}, dims, shots);
+    std::vector<double> freq(6, 0);
+    for (auto&& it : result)
+        freq[it] += 1. / shots;
+    for (idx m = 0; m < 6; ++m)
+        EXPECT_NEAR(prob[m], freq[m], 0.01);
+
+    // no shots
+    EXPECT_EQ(0u, sample(psi, {0}, dims, 0).size());
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       std::vector<idx> qpp::sample_hist(
+///       const Eigen::MatrixBase<Derived>& A,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims,
+///       idx shots)
+TEST(qpp_sample_hist, AllTests)
+{
+    // same outcomes as qpp::sample() for the same random state
+    std::vector<idx> dims{2, 2, 3, 2};
+    ket psi = randket(24);
+    idx shots = 50000;
+    std::mt19937 rng = RandomDevices::get_instance().rng_;
+    std::vector<idx> result = sample(psi, {0, 2}, dims, shots);
+    RandomDevices::get_instance().rng_ = rng;
+    std::vector<idx> hist = sample_hist(psi, {0, 2}, dims, shots);
+
+    std::vector<idx> expected(6, 0);
+    for (auto&& it : result)
+        ++expected[it];
+    EXPECT_EQ(expected, hist);
+}
+/******************************************************************************/
@@ -50,26 +50,138 @@ TEST(qpp_apply_qubits, AllTests)
 
 }
 /******************************************************************************/
-/// BEGIN template<typename Derived> cmat qpp::apply(
-///       const Eigen::MatrixBase<Derived>& rho, const std::vector<cmat>& Ks)
+/// BEGIN template<typename Derived>
+///       dyn_mat<typename Derived::Scalar> qpp::apply(
+///       const Eigen::MatrixBase<Derived>& rho,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks)
 TEST(qpp_apply_full_kraus, AllTests)
 {
+    idx D = 6;
+    cmat rho = randrho(D);
+    std::vector<cmat> Ks = randkraus(7, D);
+
+    cmat expected = cmat::Zero(D, D);
+    for (auto&& K : Ks)
+        expected += K * rho * adjoint(K);
+    EXPECT_NEAR(0, norm(apply(rho, Ks) - expected), 1e-10);
+    EXPECT_NEAR(1, std::abs(trace(apply(rho, Ks))), 1e-10);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       dyn_mat<typename Derived::Scalar> qpp::apply(
+///       const Eigen::MatrixBase<Derived>& rho,
+///       const std::vector<dyn_sp_mat<typename Derived::Scalar>>& Ks)
+TEST(qpp_apply_full_sparse_kraus, AllTests)
+{
+    // dephasing of all qubits, sparse vs dense Kraus operators
+    std::vector<idx> dims{2, 2, 2};
+    cmat rho = randrho(prod(dims));
+    std::vector<cmat> Ks{std::sqrt(0.7) * gt.Id(8),
+                         std::sqrt(0.3) * kron(gt.Z, gt.Z, gt.Z)};
+    std::vector<sp_cmat> sKs;
+    for (auto&& K : Ks)
+        sKs.push_back(K.sparseView());
+
+    EXPECT_NEAR(0, norm(apply(rho, sKs) - apply(rho, Ks)), 1e-10);
+    EXPECT_NEAR(1, std::abs(trace(apply(rho, sKs))), 1e-10);
+
+    // random dense Kraus operators stored as sparse matrices
+    idx D = 6;
+    rho = randrho(D);
+    Ks = randkraus(3, D);
+    sKs.clear();
+    for (auto&& K : Ks)
+        sKs.push_back(K.sparseView());
+    EXPECT_NEAR(0, norm(apply(rho, sKs) - apply(rho, Ks)), 1e-10);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived>
+///       dyn_mat<typename Derived::Scalar> qpp::apply(
+///       const Eigen::MatrixBase<Derived>& state,
+///       const dyn_sp_mat<typename Derived::Scalar>& A)
+TEST(qpp_apply_sparse, AllTests)
+{
+    // CNOT between qubits 2 and 0 of 3 qubits, as a full-system operator
+    std::vector<idx> dims{2, 2, 2};
+    sp_cmat CNOT20 = gt.CTRL_sparse(gt.X, {2}, {0}, 3);
+
+    ket psi = randket(prod(dims));
+    EXPECT_NEAR(0, norm(apply(psi, CNOT20) -
+                        applyCTRL(psi, gt.X, {2}, {0}, dims)), 1e-10);
 
+    cmat rho = randrho(prod(dims));
+    EXPECT_NEAR(0, norm(apply(rho, CNOT20) -
+                        applyCTRL(rho, gt.X, {2}, {0}, dims)), 1e-10);
 }
 /******************************************************************************/
-/// BEGIN template<typename Derived> cmat qpp::apply(
+/// BEGIN template<typename Derived>
+///       dyn_mat<typename Derived::Scalar> qpp::apply(
 ///       const Eigen::MatrixBase<Derived>& rho,
-///       const std::vector<cmat>& Ks,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
 ///       const std::vector<idx>& subsys,
 ///       const std::vector<idx>& dims)
 TEST(qpp_apply_kraus, AllTests)
 {
+    // single sweep with the superoperator vs one Kraus operator at a time
+    std::vector<idx> dims{2, 3, 2, 2};
+    cmat rho = randrho(prod(dims));
+    std::vector<std::vector<idx>> targets{{0}, {1}, {3, 1}, {2, 0}};
+    for (auto&& target : targets)
+    {
+        idx DA = 1;
+        for (idx i : target)
+            DA *= dims[i];
+        std::vector<cmat> Ks = randkraus(3, DA);
+
+        cmat expected = cmat::Zero(rho.rows(), rho.cols());
+        for (auto&& K : Ks)
+            expected += apply(rho, K, target, dims);
+        cmat result = apply(rho, Ks, target, dims);
+        EXPECT_NEAR(0, norm(result - expected), 1e-10);
+    }
+
+    // dephasing, diagonal superoperator
+    std::vector<cmat> Ks{gt.Id2 / std::sqrt(2), gt.Z / std::sqrt(2)};
+    cmat expected = (rho + apply(rho, gt.Z, {2}, dims)) / 2;
+    EXPECT_NEAR(0, norm(apply(rho, Ks, {2}, dims) - expected), 1e-10);
+
+    // more than maxn / 2 subsystems
+    std::vector<idx> dims1(maxn / 2, 1);
+    dims1.insert(std::end(dims1), {2, 2});
+    cmat rho1 = randrho(4);
+    cmat expected1 = (rho1 + kron(gt.Id2, gt.Z) * rho1 * kron(gt.Id2, gt.Z))
+                     / 2;
+    EXPECT_NEAR(0, norm(apply(rho1, Ks, {maxn / 2 + 1}, dims1) - expected1),
+                1e-10);
+
+    // exceptions
+    EXPECT_THROW(apply(rho, Ks, {1}, dims), Exception);
+    EXPECT_THROW(apply(rho, std::vector<cmat>{}, {1}, dims), Exception);
+}
 
+TEST(qpp_apply_kraus, SinglePrecision)
+{
+    // complex<float> vs complex<double>
+    std::vector<idx> dims{2, 3, 2};
+    cmat rho = randrho(prod(dims));
+    std::vector<cmat> Ks = randkraus(3, 6);
+    std::vector<cmat_f> Ks_f;
+    for (auto&& K : Ks)
+        Ks_f.push_back(K.cast<cplx_f>());
+
+    cmat_f rho_f = rho.cast<cplx_f>();
+    cmat_f result_f = apply(rho_f, Ks_f, {2, 1}, dims);
+    cmat expected = apply(rho, Ks, {2, 1}, dims);
+    EXPECT_NEAR(0, norm(cmat(result_f.cast<cplx>()) - expected), 1e-5);
+    result_f = apply(rho_f, Ks_f, {1, 2}, dims);
+    expected = apply(rho, Ks, {1, 2}, dims);
+    EXPECT_NEAR(0, norm(cmat(result_f.cast<cplx>()) - expected), 1e-5);
 }
 /******************************************************************************/
-/// BEGIN template<typename Derived> cmat qpp::apply(
+/// BEGIN template<typename Derived>
+///       dyn_mat<typename Derived::Scalar> qpp::apply(
 ///       const Eigen::MatrixBase<Derived>& rho,
-///       const std::vector<cmat>& Ks,
+///       const std::vector<dyn_mat<typename Derived::Scalar>>& Ks,
 ///       const std::vector<idx>& subsys,
 ///       idx d = 2)
 TEST(qpp_apply_kraus_qubits, AllTests)
@@ -149,6 +261,188 @@ TEST(qpp_applyCTRL, EmptyControl)
     double res = norm(result_psi - result_rho);
     EXPECT_NEAR (0, res, 1e-10);
 }
+
+TEST(qpp_applyCTRL, DimensionOneControl)
+{
+    // a control of dimension 1 is always in the state 0, the gate is never
+    // applied
+    std::vector<idx> dims{1, 2};
+    ket psi = randket(2);
+    cmat rho = randrho(2);
+    for (auto&& U : {cmat(gt.X), cmat(gt.Z), randU(2)})
+    {
+        EXPECT_NEAR(0, norm(applyCTRL(psi, U, {0}, {1}, dims) - psi), 1e-10);
+        EXPECT_NEAR(0, norm(applyCTRL(rho, U, {0}, {1}, dims) - rho), 1e-10);
+    }
+
+    // several controls of dimension 1, among other subsystems
+    dims = {2, 1, 2, 1};
+    psi = randket(4);
+    ket result = applyCTRL(psi, gt.X, {1, 3}, {2}, dims);
+    EXPECT_NEAR(0, norm(result - psi), 1e-10);
+}
+
+TEST(qpp_applyCTRL, DiagonalGates)
+{
+    // diagonal gates take the phase-only fast path
+    idx N = 4, d = 3;
+    std::vector<idx> dims(N, d);
+    std::vector<idx> ctrl{3, 1};
+    std::vector<idx> target{2};
+    cmat U = gt.Zd(d);
+
+    ket psi = randket(prod(dims));
+    cmat rho = randrho(prod(dims));
+    cmat CTRLU = gt.CTRL(U, ctrl, target, N, d);
+
+    ket A = applyCTRL(psi, U, ctrl, target, dims);
+    EXPECT_NEAR(0, norm(A - CTRLU * psi), 1e-10);
+
+    cmat B = applyCTRL(rho, U, ctrl, target, dims);
+    EXPECT_NEAR(0, norm(B - CTRLU * rho * adjoint(CTRLU)), 1e-10);
+
+    // no control, two-qudit diagonal gate on non-adjacent subsystems
+    cmat V = cmat::Zero(d * d, d * d);
+    for (idx i = 0; i < d * d; ++i)
+        V(i, i) = std::exp(1_i * static_cast<double>(i));
+    cmat IV = kron(gt.Id(d), V, gt.Id(d)); // acts on {1, 2}
+    std::vector<idx> perm{1, 0, 2, 3};
+    std::vector<idx> target2{0, 2};        // {1, 2} after permuting 0 <-> 1
+
+    B = syspermute(apply(syspermute(rho, perm, dims), V, target2, dims),
+                   perm, dims);
+    EXPECT_NEAR(0, norm(B - IV * rho * adjoint(IV)), 1e-10);
+}
+
+TEST(qpp_applyCTRL, MonomialGates)
+{
+    // permutation and monomial gates take the index remapping fast path
+    idx N = 4;
+    std::vector<idx> dims(N, 2);
+    ket psi = randket(prod(dims));
+    cmat rho = randrho(prod(dims));
+
+    std::vector<cmat> gates{gt.X, gt.Y, gt.SWAP, gt.TOF, gt.FRED};
+    std::vector<std::vector<idx>> targets{{2}, {0}, {3, 0}, {1, 3, 0},
+                                          {2, 0, 3}};
+    std::vector<std::vector<idx>> ctrls{{0, 3}, {1}, {1}, {2}, {1}};
+    for (idx i = 0; i < gates.size(); ++i)
+    {
+        cmat CTRLU = gt.CTRL(gates[i], ctrls[i], targets[i], N);
+
+        ket A = applyCTRL(psi, gates[i], ctrls[i], targets[i], dims);
+        EXPECT_NEAR(0, norm(A - CTRLU * psi), 1e-10);
+
+        cmat B = applyCTRL(rho, gates[i], ctrls[i], targets[i], dims);
+        EXPECT_NEAR(0, norm(B - CTRLU * rho * adjoint(CTRLU)), 1e-10);
+    }
+
+    // qudits, Xd is an exact permutation matrix
+    idx d = 3;
+    std::vector<idx> dims3(3, d);
+    cmat Xd = gt.Xd(d);
+    EXPECT_NEAR(0, norm(Xd - gt.Fd(d).inverse() * gt.Zd(d) * gt.Fd(d)), 1e-10);
+    ket psi3 = randket(prod(dims3));
+    cmat rho3 = randrho(prod(dims3));
+    cmat CTRLXd = gt.CTRL(Xd, {2}, {0}, 3, d);
+
+    ket A = applyCTRL(psi3, Xd, {2}, {0}, dims3);
+    EXPECT_NEAR(0, norm(A - CTRLXd * psi3), 1e-10);
+    cmat B = applyCTRL(rho3, Xd, {2}, {0}, dims3);
+    EXPECT_NEAR(0, norm(B - CTRLXd * rho3 * adjoint(CTRLXd)), 1e-10);
+}
+
+TEST(qpp_applyCTRL, DenseGatesOnMatrices)
+{
+    // general square matrices, two-sided sweeps
+    idx N = 4, d = 3;
+    std::vector<idx> dims(N, d);
+    cmat A = cmat::Random(prod(dims), prod(dims));
+    cmat U = randU(d * d);
+
+    std::vector<std::vector<idx>> targets{{2, 0}, {1, 3}, {3, 2}};
+    std::vector<std::vector<idx>> ctrls{{}, {0}, {1, 0}};
+    for (idx i = 0; i < targets.size(); ++i)
+    {
+        // full matrix, column by column, via the ket version
+        idx D = prod(dims);
+        cmat CTRLU(D, D);
+        for (idx j = 0; j < D; ++j)
+            CTRLU.col(j) = applyCTRL(ket(gt.Id(D).col(j)), U, ctrls[i],
+                                     targets[i], dims);
+        cmat B = applyCTRL(A, U, ctrls[i], targets[i], dims);
+        EXPECT_NEAR(0, norm(B - CTRLU * A * adjoint(CTRLU)), 1e-10);
+    }
+
+    // more than maxn / 2 subsystems, sweeps over the columns
+    std::vector<idx> dims1(maxn / 2, 1);
+    dims1.insert(std::end(dims1), {2, 2, 2});
+    idx N1 = dims1.size();
+    cmat rho = randrho(8);
+    cmat CNOT02 = gt.CTRL(gt.X, {0}, {2}, 3);
+    cmat B = applyCTRL(rho, gt.H * gt.T, {N1 - 3}, {N1 - 1}, dims1);
+    cmat CTRLHT = gt.CTRL(gt.H * gt.T, {0}, {2}, 3);
+    EXPECT_NEAR(0, norm(B - CTRLHT * rho * adjoint(CTRLHT)), 1e-10);
+    B = applyCTRL(rho, gt.X, {N1 - 3}, {N1 - 1}, dims1);
+    EXPECT_NEAR(0, norm(B - CNOT02 * rho * adjoint(CNOT02)), 1e-10);
+}
+
+TEST(qpp_applyCTRL, SinglePrecision)
+{
+    // complex<float> vs complex<double>, state vectors and density matrices
+    std::vector<idx> dims{2, 3, 2, 2};
+    ket psi = randket(prod(dims));
+    cmat rho = randrho(prod(dims));
+    std::vector<cmat> gates{randU(6), gt.Zd(3), gt.Xd(3)};
+    std::vector<std::vector<idx>> targets{{3, 1}, {1}, {1}};
+    std::vector<std::vector<idx>> ctrls{{0}, {2}, {}};
+    for (idx i = 0; i < gates.size(); ++i)
+    {
+        cmat_f U_f = gates[i].cast<cplx_f>();
+        ket_f psi_f = applyCTRL(ket_f(psi.cast<cplx_f>()), U_f, ctrls[i],
+                                targets[i], dims);
+        ket expected = applyCTRL(psi, gates[i], ctrls[i], targets[i], dims);
+        EXPECT_NEAR(0, norm(ket(psi_f.cast<cplx>()) - expected), 1e-5);
+
+        cmat_f rho_f = applyCTRL(cmat_f(rho.cast<cplx_f>()), U_f, ctrls[i],
+                                 targets[i], dims);
+        cmat expected_rho = applyCTRL(rho, gates[i], ctrls[i], targets[i],
+                                      dims);
+        EXPECT_NEAR(0, norm(cmat(rho_f.cast<cplx>()) - expected_rho), 1e-5);
+    }
+
+    // partial trace and permutation
+    cmat_f rho_f = rho.cast<cplx_f>();
+    EXPECT_NEAR(0, norm(cmat(ptrace(rho_f, {1, 2}, dims).cast<cplx>()) -
+                       ptrace(rho, {1, 2}, dims)), 1e-5);
+    EXPECT_NEAR(0, norm(cmat(syspermute(rho_f, {3, 1, 0, 2}, dims)
+                                     .cast<cplx>()) -
+                       syspermute(rho, {3, 1, 0, 2}, dims)), 1e-5);
+}
+
+TEST(qpp_applyCTRL, FirstTouchAllocation)
+{
+    // the parallel first-touch copies (and the page hints) must not change
+    // the results
+    idx N = 5;
+    std::vector<idx> dims(N, 2);
+    ket psi = randket(prod(dims));
+    cmat rho = randrho(prod(dims));
+    cmat U = randU(4);
+    ket expected = applyCTRL(psi, U, {0}, {3, 1}, dims);
+    cmat expected_rho = applyCTRL(rho, U, {0}, {3, 1}, dims);
+    ket expected_mket = mket({1, 0, 1, 1, 0});
+
+    internal::MemoryPolicy policy = internal::memory_policy();
+    internal::memory_policy().min_size = 0;
+    internal::memory_policy().huge_pages = true;
+    EXPECT_NEAR(0, norm(applyCTRL(psi, U, {0}, {3, 1}, dims) - expected),
+                1e-10);
+    EXPECT_NEAR(0, norm(applyCTRL(rho, U, {0}, {3, 1}, dims) - expected_rho),
+                1e-10);
+    EXPECT_EQ(expected_mket, mket({1, 0, 1, 1, 0}));
+    internal::memory_policy() = policy;
+}
 /******************************************************************************/
 /// BEGIN template<typename Derived1, typename Derived2>
 ///       dyn_mat<typename Derived1::Scalar> qpp::applyCTRL(
@@ -160,6 +454,291 @@ TEST(qpp_applyCTRL, EmptyControl)
 TEST(qpp_applyCTRL_qubits, AllTests)
 {
 
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived1, typename Derived2>
+///       void qpp::applyCTRL_inplace(
+///       Eigen::MatrixBase<Derived1>& state,
+///       const Eigen::MatrixBase<Derived2>& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_applyCTRL_inplace, Qubits)
+{
+    idx N = 4;
+    std::vector<idx> dims(N, 2);
+    std::vector<idx> ctrl{2, 0};
+    std::vector<idx> target{3};
+
+    ket psi = randket(prod(dims));
+    cmat U = randU(2);
+
+    ket result = psi;
+    applyCTRL_inplace(result, U, ctrl, target, dims);
+    ket expected = gt.CTRL(U, ctrl, target, N) * psi;
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+    // agrees with the out-of-place version
+    EXPECT_NEAR(0, norm(result - applyCTRL(psi, U, ctrl, target, dims)),
+                1e-10);
+}
+
+TEST(qpp_applyCTRL_inplace, Qudits)
+{
+    idx N = 4, d = 3;
+    std::vector<idx> dims(N, d);
+    std::vector<idx> ctrl{1};
+    std::vector<idx> target{3, 0};
+
+    ket psi = randket(prod(dims));
+    cmat U = randU(d * d);
+
+    ket result = psi;
+    applyCTRL_inplace(result, U, ctrl, target, dims);
+    ket expected = gt.CTRL(U, ctrl, target, N, d) * psi;
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+}
+
+TEST(qpp_applyCTRL_inplace, TrivialPowers)
+{
+    // A^2 = I, so only the control value 1 changes the state
+    idx N = 4, d = 3;
+    std::vector<idx> dims(N, d);
+    std::vector<idx> ctrl{0, 2};
+    std::vector<idx> target{1};
+    cmat A = cmat::Zero(d, d);
+    A(0, 1) = A(1, 0) = A(2, 2) = 1;
+
+    ket psi = randket(prod(dims));
+    ket result = psi;
+    applyCTRL_inplace(result, A, ctrl, target, dims);
+    ket expected = gt.CTRL(A, ctrl, target, N, d) * psi;
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+    // identity gate leaves the state untouched
+    result = psi;
+    applyCTRL_inplace(result, gt.Id(d), ctrl, target, dims);
+    EXPECT_EQ(psi, result);
+}
+
+TEST(qpp_applyCTRL_inplace, GateSizes)
+{
+    // exercises the 1 qubit, 2 qubit and general kernels
+    idx N = 5;
+    std::vector<idx> dims(N, 2);
+    ket psi = randket(prod(dims));
+
+    std::vector<std::vector<idx>> targets{{4}, {0}, {3, 1}, {0, 4, 2}};
+    std::vector<std::vector<idx>> ctrls{{2}, {3}, {0, 4}, {1}};
+    for (idx i = 0; i < targets.size(); ++i)
+    {
+        cmat U = randU(static_cast<idx>(std::llround(
+                std::pow(2, targets[i].size()))));
+
+        ket result = psi;
+        applyCTRL_inplace(result, U, ctrls[i], targets[i], dims);
+        ket expected = gt.CTRL(U, ctrls[i], targets[i], N) * psi;
+        EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+        // no control, same as a control on an extra qubit set to |1>
+        result = psi;
+        apply_inplace(result, U, targets[i], dims);
+        expected = gt.CTRL(U, {N}, targets[i], N + 1) * kron(psi, st.z1);
+        EXPECT_NEAR(0, norm(kron(result, st.z1) - expected), 1e-10);
+    }
+}
+
+TEST(qpp_applyCTRL_inplace, DiagonalGates)
+{
+    idx N = 5;
+    std::vector<idx> dims(N, 2);
+    ket psi = randket(prod(dims));
+
+    std::vector<cmat> gates{gt.T, gt.S, gt.CZ, gt.Rn(0.3, {0, 0, 1})};
+    std::vector<std::vector<idx>> targets{{3}, {0}, {4, 1}, {2}};
+    std::vector<std::vector<idx>> ctrls{{1}, {2, 4}, {0}, {1, 3}};
+    for (idx i = 0; i < gates.size(); ++i)
+    {
+        ket result = psi;
+        applyCTRL_inplace(result, gates[i], ctrls[i], targets[i], dims);
+        ket expected = gt.CTRL(gates[i], ctrls[i], targets[i], N) * psi;
+        EXPECT_NEAR(0, norm(result - expected), 1e-10);
+    }
+}
+
+TEST(qpp_applyCTRL_inplace, MonomialGates)
+{
+    idx N = 5;
+    std::vector<idx> dims(N, 2);
+    ket psi = randket(prod(dims));
+
+    // phases on a 3-cycle, monomial but not a permutation
+    cmat M = cmat::Zero(4, 4);
+    M(1, 0) = 1_i;
+    M(2, 1) = -1;
+    M(0, 2) = 1;
+    M(3, 3) = std::exp(0.5_i);
+
+    std::vector<cmat> gates{gt.X, gt.CNOT, gt.CNOTba, gt.SWAP, gt.TOF, M};
+    std::vector<std::vector<idx>> targets{{4}, {0, 3}, {2, 1}, {3, 0},
+                                          {4, 0, 2}, {1, 4}};
+    std::vector<std::vector<idx>> ctrls{{1}, {2}, {4}, {1, 2}, {3}, {0}};
+    for (idx i = 0; i < gates.size(); ++i)
+    {
+        ket result = psi;
+        applyCTRL_inplace(result, gates[i], ctrls[i], targets[i], dims);
+        ket expected = gt.CTRL(gates[i], ctrls[i], targets[i], N) * psi;
+        EXPECT_NEAR(0, norm(result - expected), 1e-10);
+    }
+
+    // qudit control, the powers of Xd are permutations too
+    idx d = 3;
+    std::vector<idx> dims3(4, d);
+    ket psi3 = randket(prod(dims3));
+    ket result = psi3;
+    applyCTRL_inplace(result, gt.Xd(d), {0, 3}, {1}, dims3);
+    ket expected = gt.CTRL(gt.Xd(d), {0, 3}, {1}, 4, d) * psi3;
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+}
+
+TEST(qpp_applyCTRL_inplace, VectorizedKernels)
+{
+    // every instruction set up to the one detected at runtime, down to the
+    // scalar fallback, must give the same results
+    internal::SIMD detected = internal::simd_isa();
+    std::vector<internal::SIMD> isas{internal::SIMD::NONE};
+    if (detected != internal::SIMD::NONE)
+        isas.push_back(internal::SIMD::AVX2);
+    if (detected == internal::SIMD::AVX512)
+        isas.push_back(internal::SIMD::AVX512);
+
+    idx N = 6;
+    std::vector<idx> dims(N, 2);
+    ket psi = randket(prod(dims));
+
+    std::vector<cmat> gates{randU(2), randU(2), randU(2), randU(4), randU(4),
+                            gt.T, gt.CZ};
+    std::vector<std::vector<idx>> targets{{5}, {0}, {3}, {4, 5}, {0, 2},
+                                          {5}, {1, 4}};
+    std::vector<std::vector<idx>> ctrls{{0}, {5}, {4}, {1}, {5, 3}, {2}, {3}};
+    for (auto&& isa : isas)
+    {
+        internal::simd_isa() = isa;
+        for (idx i = 0; i < gates.size(); ++i)
+        {
+            ket result = psi;
+            applyCTRL_inplace(result, gates[i], ctrls[i], targets[i], dims);
+            ket expected = gt.CTRL(gates[i], ctrls[i], targets[i], N) * psi;
+            EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+            result = psi;
+            apply_inplace(result, gates[i], targets[i], dims);
+            expected = gt.CTRL(gates[i], {N}, targets[i], N + 1)
+                       * kron(psi, st.z1);
+            EXPECT_NEAR(0, norm(kron(result, st.z1) - expected), 1e-10);
+        }
+    }
+    internal::simd_isa() = detected;
+}
+
+TEST(qpp_applyCTRL_inplace, Exceptions)
+{
+    std::vector<idx> dims{2, 2};
+    cmat rho = randrho(4);
+    EXPECT_THROW(applyCTRL_inplace(rho, gt.X, {0}, {1}, dims), Exception);
+
+    ket psi = randket(4);
+    EXPECT_THROW(applyCTRL_inplace(psi, gt.X, {0}, {0}, dims), Exception);
+    EXPECT_THROW(applyCTRL_inplace(psi, gt.CNOT, {0}, {1}, dims), Exception);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived1, typename Derived2>
+///       void qpp::apply_inplace(
+///       Eigen::MatrixBase<Derived1>& state,
+///       const Eigen::MatrixBase<Derived2>& A,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_apply_inplace, MixedDimensions)
+{
+    std::vector<idx> dims{2, 3, 2};
+    ket psi = randket(prod(dims));
+    cmat U = randU(3);
+    cmat V = randU(4);
+
+    ket result = psi;
+    apply_inplace(result, U, {1}, dims);
+    ket expected = kron(gt.Id2, U, gt.Id2) * psi;
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+
+    // two-subsystem gate on non-adjacent subsystems, in reversed order
+    result = psi;
+    apply_inplace(result, V, {2, 0}, dims);
+    std::vector<idx> perm{2, 0, 1};
+    expected = syspermute(psi, perm, dims); // now ordered as 2, 0, 1
+    expected = kron(V, gt.Id(3)) * expected;
+    expected = syspermute(expected, invperm(perm), {2, 2, 3});
+    EXPECT_NEAR(0, norm(result - expected), 1e-10);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived1, typename Derived2>
+///       dyn_mat<typename Derived1::Scalar> qpp::applyCTRL_batch(
+///       const Eigen::MatrixBase<Derived1>& states,
+///       const Eigen::MatrixBase<Derived2>& A,
+///       const std::vector<idx>& ctrl,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_applyCTRL_batch, AllTests)
+{
+    std::vector<idx> dims{3, 2, 3, 2};
+    idx D = prod(dims), B = 5;
+    cmat states(D, B);
+    for (idx b = 0; b < B; ++b)
+        states.col(b) = randket(D);
+
+    cmat U = randU(6);
+    cmat result = applyCTRL_batch(states, U, {3}, {2, 1}, dims);
+    ASSERT_EQ(D, static_cast<idx>(result.rows()));
+    ASSERT_EQ(B, static_cast<idx>(result.cols()));
+    for (idx b = 0; b < B; ++b)
+    {
+        ket expected = applyCTRL(ket(states.col(b)), U, {3}, {2, 1}, dims);
+        EXPECT_NEAR(0, norm(result.col(b) - expected), 1e-10);
+    }
+
+    // exceptions
+    EXPECT_THROW(applyCTRL_batch(states, U, {3}, {2}, dims), Exception);
+    EXPECT_THROW(applyCTRL_batch(cmat(states.topRows(D - 1)), U, {3}, {2, 1},
+                                 dims), Exception);
+}
+/******************************************************************************/
+/// BEGIN template<typename Derived1, typename Derived2>
+///       dyn_mat<typename Derived1::Scalar> qpp::apply_batch(
+///       const Eigen::MatrixBase<Derived1>& states,
+///       const Eigen::MatrixBase<Derived2>& A,
+///       const std::vector<idx>& subsys,
+///       idx d = 2)
+TEST(qpp_apply_batch, Qubits)
+{
+    idx N = 5, D = prod(std::vector<idx>(N, 2)), B = 9;
+    cmat states(D, B);
+    for (idx b = 0; b < B; ++b)
+        states.col(b) = randket(D);
+
+    // square batch, must not be mistaken for a density matrix
+    cmat square = states.leftCols(4).topRows(4);
+    cmat U = randU(4);
+    cmat result = apply_batch(square, U, {1, 0});
+    EXPECT_NEAR(0, norm(result - gt.SWAP * U * gt.SWAP * square), 1e-10);
+
+    for (auto&& gate : {gt.H, gt.T, gt.X})
+    {
+        result = apply_batch(states, gate, {3});
+        for (idx b = 0; b < B; ++b)
+        {
+            ket expected = apply(ket(states.col(b)), gate, {3});
+            EXPECT_NEAR(0, norm(result.col(b) - expected), 1e-10);
+        }
+    }
 }
 /******************************************************************************/
 /// BEGIN inline std::vector<cmat> qpp::choi2kraus(const cmat& A)
@@ -0,0 +1,124 @@
+/*
+ * Quantum++
+ *
+ * Copyright (c) 2013 - 2016 Vlad Gheorghiu (vgheorgh@gmail.com)
+ *
+ * This file is part of Quantum++.
+ *
+ * Quantum++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Quantum++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Quantum++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include "qpp.h"
+
+using namespace qpp;
+
+// Unit testing "parallel.h"
+
+/******************************************************************************/
+/// BEGIN template<typename F> void qpp::parallel_for(idx n, const F& f,
+///       idx grain = 0)
+TEST(qpp_parallel_for, AllTests)
+{
+    // every iteration runs exactly once, for all chunk sizes
+    for (idx grain : {1, 7, 4096})
+    {
+        std::vector<idx> v(10000, 0);
+        parallel_for(v.size(), [&](idx i) { v[i] += i; }, grain);
+        for (idx i = 0; i < v.size(); ++i)
+            EXPECT_EQ(i, v[i]);
+    }
+
+    // empty range
+    parallel_for(0, [](idx) { FAIL(); });
+
+    // nested loops
+    std::vector<idx> w(100 * 100, 0);
+    parallel_for(100, [&](idx i)
+    {
+        parallel_for(100, [&](idx j) { w[i * 100 + j] += i + j; }, 1);
+    }, 1);
+    for (idx i = 0; i < 100; ++i)
+        for (idx j = 0; j < 100; ++j)
+            EXPECT_EQ(i + j, w[i * 100 + j]);
+}
+/******************************************************************************/
+/// BEGIN template<typename F> void qpp::parallel_for(idx n1, idx n2,
+///       const F& f, idx grain = 0)
+TEST(qpp_parallel_for_2d, AllTests)
+{
+    for (idx grain : {1, 5, 4096})
+    {
+        idx n1 = 37, n2 = 11;
+        std::vector<idx> v(n1 * n2, 0);
+        parallel_for(n1, n2, [&](idx i, idx j) { v[i * n2 + j] += i + j; },
+                     grain);
+        for (idx i = 0; i < n1; ++i)
+            for (idx j = 0; j < n2; ++j)
+                EXPECT_EQ(i + j, v[i * n2 + j]);
+    }
+
+    // empty ranges
+    parallel_for(0, 5, [](idx, idx) { FAIL(); });
+    parallel_for(5, 0, [](idx, idx) { FAIL(); });
+}
+/******************************************************************************/
+/// BEGIN template<typename T, typename F, typename C> T qpp::parallel_reduce(
+///       idx n, const T& zero, const F& f, const C& combine, idx grain = 0)
+TEST(qpp_parallel_reduce, AllTests)
+{
+    for (idx grain : {1, 3, 4096})
+    {
+        idx n = 1000;
+        idx sum = parallel_reduce(n, idx{0},
+                                  [](idx i, idx& partial) { partial += i; },
+                                  [](idx& result, idx partial)
+                                  {
+                                      result += partial;
+                                  }, grain);
+        EXPECT_EQ(n * (n - 1) / 2, sum);
+    }
+
+    // the partials are combined in order
+    std::vector<idx> all = parallel_reduce(
+            100, std::vector<idx>{},
+            [](idx i, std::vector<idx>& partial) { partial.push_back(i); },
+            [](std::vector<idx>& result, const std::vector<idx>& partial)
+            {
+                result.insert(result.end(), partial.begin(), partial.end());
+            }, 1);
+    ASSERT_EQ(100u, all.size());
+    for (idx i = 0; i < 100; ++i)
+        EXPECT_EQ(i, all[i]);
+}
+/******************************************************************************/
+/// BEGIN class qpp::ThreadBudget
+TEST(qpp_ThreadBudget, AllTests)
+{
+    // the results do not depend on the number of threads
+    std::vector<idx> dims(16, 2);
+    ket psi = randket(65536);
+    ket expected = apply(psi, gt.H, {3}, dims);
+    {
+        ThreadBudget budget(1);
+        EXPECT_NEAR(0, norm(apply(psi, gt.H, {3}, dims) - expected), 1e-7);
+        {
+            ThreadBudget inner(3);
+            EXPECT_NEAR(0, norm(apply(psi, gt.H, {3}, dims) - expected),
+                        1e-7);
+        }
+        EXPECT_NEAR(0, norm(apply(psi, gt.H, {3}, dims) - expected), 1e-7);
+    }
+}
+/******************************************************************************/
@@ -57,6 +57,42 @@ TEST(qpp_cor, AllTests)
 TEST(qpp_cov, AllTests)
 {
 
+}
+/******************************************************************************/
+/// BEGIN inline std::vector<double> qpp::marginal(
+///       const std::vector<double>& prob,
+///       const std::vector<idx>& subsys,
+///       const std::vector<idx>& dims)
+TEST(qpp_marginal, AllTests)
+{
+    // reduces to qpp::marginalX() and qpp::marginalY()
+    dmat probXY(2, 3);
+    probXY << 0.1, 0.2, 0.05,
+            0.3, 0.15, 0.2;
+    std::vector<double> prob{0.1, 0.2, 0.05, 0.3, 0.15, 0.2};
+    std::vector<double> resultX = marginal(prob, {0}, {2, 3});
+    std::vector<double> resultY = marginal(prob, {1}, {2, 3});
+    std::vector<double> expectedX = marginalX(probXY);
+    std::vector<double> expectedY = marginalY(probXY);
+    for (idx i = 0; i < 2; ++i)
+        EXPECT_NEAR(expectedX[i], resultX[i], 1e-7);
+    for (idx i = 0; i < 3; ++i)
+        EXPECT_NEAR(expectedY[i], resultY[i], 1e-7);
+
+    // three variables, kept in a permuted order
+    std::vector<idx> dims{2, 3, 2};
+    prob = probs(randket(12), {0, 1, 2}, dims);
+    std::vector<double> result = marginal(prob, {2, 0}, dims);
+    std::vector<double> expected(4, 0);
+    for (idx a = 0; a < 2; ++a)
+        for (idx b = 0; b < 3; ++b)
+            for (idx c = 0; c < 2; ++c)
+                expected[c * 2 + a] += prob[a * 6 + b * 2 + c];
+    for (idx i = 0; i < 4; ++i)
+        EXPECT_NEAR(expected[i], result[i], 1e-7);
+
+    // empty subsys, the total probability
+    EXPECT_NEAR(1, marginal(prob, {}, dims)[0], 1e-7);
 }
 /******************************************************************************/
 /// BEGIN inline std::vector<double> qpp::marginalX(const dmat& probXY)